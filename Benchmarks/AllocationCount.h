@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new of the program to count its allocations.
+// Include it in one source file of a benchmark only.
+
+namespace mouseevents
+{
+
+// Number of allocations by operator new so far
+inline std::atomic<std::size_t>& AllocationCount()
+{
+    static std::atomic<std::size_t> Count{0};
+    return Count;
+}
+
+}
+
+void* operator new(std::size_t Size)
+{
+    ++mouseevents::AllocationCount();
+    if(void* Memory = std::malloc(Size > 0 ? Size : 1))
+    {
+        return Memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* Memory) noexcept
+{
+    std::free(Memory);
+}
+
+void operator delete(void* Memory, std::size_t) noexcept
+{
+    std::free(Memory);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace mouseevents
+{
+
+// Median of the measured times
+inline double Median(std::vector<double> Times)
+{
+    std::nth_element(Times.begin(), Times.begin() + Times.size()/2, Times.end());
+    return Times[Times.size()/2];
+}
+
+// Median time of a run in ms
+inline double MeasureMs(int Repetitions, const std::function<void()>& Run)
+{
+    std::vector<double> Times;
+    for(int Repetition = 0; Repetition < Repetitions; ++Repetition)
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        Run();
+        Times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+    }
+    return Median(Times);
+}
+
+// An XML log of EntryCount entries, mostly long text and comments
+inline std::string MakeBenchmarkLogXML(int EntryCount)
+{
+    std::string Xml = "<?xml version=\"1.0\" ?>\n<Log>\n";
+    for(int Entry = 0; Entry < EntryCount; ++Entry)
+    {
+        Xml += "\t<!-- entry " + std::to_string(Entry) + " of the log, written by the capture thread -->\n";
+        Xml += "\t<Entry Level=\"Info\">Frame " + std::to_string(Entry) + " was captured, composed and presented without being dropped by the pipeline, the zones were unchanged</Entry>\n";
+    }
+    return Xml + "</Log>\n";
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+#include "../ZoneConfig.h"
+
+namespace mouseevents
+{
+
+// Zones 1 to ZoneCount, of LineCount lines each
+inline CMouseEvents::ZonesType MakeBenchmarkZones(int ZoneCount, int LineCount)
+{
+    CMouseEvents::ZonesType Zones;
+    for(int ZoneId = 1; ZoneId <= ZoneCount; ++ZoneId)
+    {
+        CMouseEvents::SZone Zone;
+        Zone.s_ZoneId = ZoneId;
+        Zone.s_ZoneName = "Zone " + std::to_string(ZoneId);
+        for(int Line = 0; Line < LineCount; ++Line)
+        {
+            Zone.s_Lines.emplace_back(CMouseEvents::PointType(Line, ZoneId), CMouseEvents::PointType(Line + 1, ZoneId + Line));
+        }
+        Zones.Set(ZoneId, Zone);
+    }
+    return Zones;
+}
+
+// The XML configuration of the zones, as it is saved
+inline std::string MakeBenchmarkConfigXML(int ZoneCount, int LineCount)
+{
+    std::ostringstream Oss;
+    WriteConfigXML(Oss, MakeBenchmarkZones(ZoneCount, LineCount));
+    return Oss.str();
+}
+
+}
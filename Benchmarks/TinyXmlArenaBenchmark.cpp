@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../TinyXml/tinyxml.h"
+#include "AllocationCount.h"
+#include "Benchmark.h"
+#include "BenchmarkZones.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+struct SResult
+{
+    double s_ParseMs{0};
+    double s_DestroyMs{0};
+    std::size_t s_Allocations{0};
+};
+
+// Median times to parse the configuration into a new document and to destroy it, and the allocations of both
+SResult MeasureDocument(const std::string& Xml, bool UseArena, int Repetitions)
+{
+    std::vector<double> ParseTimes, DestroyTimes;
+    SResult Result;
+    for(int Repetition = 0; Repetition < Repetitions; ++Repetition)
+    {
+        const auto Allocations = AllocationCount().load();
+        const auto Start = std::chrono::steady_clock::now();
+        auto* Doc = new TiXmlDocument();
+        Doc->SetUseArena(UseArena);
+        Doc->Parse(Xml.c_str());
+        const auto Parsed = std::chrono::steady_clock::now();
+        if(Doc->Error())
+        {
+            std::fprintf(stderr, "%s\n", Doc->ErrorDesc());
+            std::exit(1);
+        }
+        delete Doc;
+        const auto Destroyed = std::chrono::steady_clock::now();
+        Result.s_Allocations = AllocationCount().load() - Allocations;
+        ParseTimes.push_back(std::chrono::duration<double, std::milli>(Parsed - Start).count());
+        DestroyTimes.push_back(std::chrono::duration<double, std::milli>(Destroyed - Parsed).count());
+    }
+    Result.s_ParseMs = Median(ParseTimes);
+    Result.s_DestroyMs = Median(DestroyTimes);
+    return Result;
+}
+
+}
+
+// Parse and destruction of a zone configuration with and without the arena of the document.
+// Usage: TinyXmlArenaBenchmark [zones] [lines per zone] [repetitions]
+int main(int argc, char* argv[])
+{
+    const int ZoneCount = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int LineCount = argc > 2 ? std::atoi(argv[2]) : 8;
+    const int Repetitions = argc > 3 ? std::atoi(argv[3]) : 11;
+
+    const auto Xml = MakeBenchmarkConfigXML(ZoneCount, LineCount);
+    std::printf("%d zones of %d lines, %zu bytes, median of %d parses\n", ZoneCount, LineCount, Xml.size(), Repetitions);
+    std::printf("           parse ms  destroy ms  allocations\n");
+    for(const bool UseArena : {false, true})
+    {
+        const auto Result = MeasureDocument(Xml, UseArena, Repetitions);
+        std::printf("%-8s %10.3f  %10.3f  %11zu\n", UseArena ? "arena" : "heap", Result.s_ParseMs, Result.s_DestroyMs, Result.s_Allocations);
+    }
+    return 0;
+}
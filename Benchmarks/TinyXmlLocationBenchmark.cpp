@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include "../TinyXml/tinyxml.h"
+#include "Benchmark.h"
+#include "BenchmarkZones.h"
+
+using namespace mouseevents;
+
+// Parse throughput in MB/s with and without the location of the nodes (TiXmlParseOptions::locateNodes).
+// Usage: TinyXmlLocationBenchmark [zones] [log entries] [repetitions]
+int main(int argc, char* argv[])
+{
+    const int ZoneCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int EntryCount = argc > 2 ? std::atoi(argv[2]) : 20000;
+    const int Repetitions = argc > 3 ? std::atoi(argv[3]) : 11;
+
+    std::printf("median of %d parses with the arena\n", Repetitions);
+    std::printf("                        located       not located\n");
+    for(const auto& [Name, Xml] : {std::make_pair("zones", MakeBenchmarkConfigXML(ZoneCount, 8)), std::make_pair("log", MakeBenchmarkLogXML(EntryCount))})
+    {
+        std::printf("%-6s %8.2f MB", Name, Xml.size()/1e6);
+        for(const bool LocateNodes : {true, false})
+        {
+            TiXmlParseOptions Options;
+            Options.locateNodes = LocateNodes;
+            bool Failed{false};
+            const auto Ms = MeasureMs(Repetitions, [&Xml = Xml, &Options, &Failed]()
+            {
+                TiXmlDocument Doc;
+                Doc.SetUseArena(true);
+                Doc.SetParseOptions(Options);
+                Doc.Parse(Xml.c_str());
+                Failed = Failed || Doc.Error();
+            });
+            if(Failed)
+            {
+                std::fprintf(stderr, "\nthe %s document could not be parsed\n", Name);
+                return 1;
+            }
+            std::printf("  %8.1f MB/s", Xml.size()/1e3/Ms);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../TinyXml/tinyxml.h"
+#include "AllocationCount.h"
+#include "Benchmark.h"
+#include "BenchmarkZones.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+// Number of elements below a node
+int CountElements(const TiXmlNode* Node)
+{
+    int Count{0};
+    for(const TiXmlElement* Child = Node->FirstChildElement(); Child; Child = Child->NextSiblingElement())
+    {
+        Count += 1 + CountElements(Child);
+    }
+    return Count;
+}
+
+}
+
+// Handing a parsed configuration to a worker thread, by a copy or by a move of the document.
+// Only the construction of the handed document is measured.
+// Usage: TinyXmlMoveBenchmark [zones] [repetitions]
+int main(int argc, char* argv[])
+{
+    const int ZoneCount = argc > 1 ? std::atoi(argv[1]) : 500;
+    const int Repetitions = argc > 2 ? std::atoi(argv[2]) : 21;
+
+    const auto Xml = MakeBenchmarkConfigXML(ZoneCount, 8);
+    std::printf("%d zones, %zu bytes, median of %d hand-offs\n", ZoneCount, Xml.size(), Repetitions);
+    for(const bool Move : {false, true})
+    {
+        std::vector<double> Times;
+        std::size_t Allocations{0};
+        int Elements{0};
+        for(int Repetition = 0; Repetition < Repetitions; ++Repetition)
+        {
+            TiXmlDocument Doc;
+            Doc.SetUseArena(true);
+            Doc.Parse(Xml.c_str());
+
+            const auto AllocationsBefore = AllocationCount().load();
+            const auto Start = std::chrono::steady_clock::now();
+            std::unique_ptr<TiXmlDocument> Handed(Move ? new TiXmlDocument(std::move(Doc)) : new TiXmlDocument(Doc));
+            Times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+            Allocations = AllocationCount().load() - AllocationsBefore;
+
+            std::thread Worker([&Elements, Handed = std::move(Handed)]() { Elements = CountElements(Handed.get()); });
+            Worker.join();
+        }
+        std::printf("%-5s %8zu allocations  %8.3f ms  (%d elements handed)\n", Move ? "move" : "copy", Allocations, Median(Times), Elements);
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "../TinyXml/tinyxml.h"
+#include "Benchmark.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+// A document like a zone configuration, mostly names, attributes and white space
+std::string MakeZonesDocument(int ZoneCount)
+{
+    std::string Xml = "<?xml version=\"1.0\" ?>\n<Zones>\n";
+    for(int ZoneId = 1; ZoneId <= ZoneCount; ++ZoneId)
+    {
+        const auto Id = std::to_string(ZoneId);
+        Xml += "<Zone ZoneId=\"" + Id + "\" ZoneName=\"Zone " + Id + "\">\n\t<Shape Type=\"POLYGON\">\n";
+        for(int Point = 0; Point < 8; ++Point)
+        {
+            Xml += "\t\t<Point X=\"" + std::to_string(Point*37 % 1920) + "\" Y=\"" + std::to_string((ZoneId + Point)*11 % 1080) + "\"/>\n";
+        }
+        Xml += "\t</Shape>\n\t<Characteristics/>\n\t\t<Direction>\n\t\t<Point X=\"960\" Y=\"540\"/>\n\t\t<Point X=\"980\" Y=\"520\"/>\n\t\t</Direction>\n</Zone>\n";
+    }
+    return Xml + "</Zones>\n";
+}
+
+}
+
+// Parse throughput of TinyXml in MB/s. The program is built twice, with the SIMD scanners
+// (TinyXmlScanBenchmark) and with TIXML_NO_SIMD (TinyXmlScanBenchmarkNoSimd), to compare them.
+// Usage: TinyXmlScanBenchmark [size in MB] [repetitions]
+int main(int argc, char* argv[])
+{
+    const double SizeMB = argc > 1 ? std::atof(argv[1]) : 4;
+    const int Repetitions = argc > 2 ? std::atoi(argv[2]) : 11;
+
+    #ifdef TIXML_NO_SIMD
+    std::printf("scalar scanners, median of %d parses\n", Repetitions);
+    #else
+    std::printf("SIMD scanners (if the target has them), median of %d parses\n", Repetitions);
+    #endif
+
+    const auto ZoneCount = static_cast<int>(SizeMB*1e6/500);
+    const auto EntryCount = static_cast<int>(SizeMB*1e6/200);
+    for(const auto& [Name, Xml] : {std::make_pair("zones", MakeZonesDocument(ZoneCount)), std::make_pair("text", MakeBenchmarkLogXML(EntryCount))})
+    {
+        bool Failed{false};
+        const auto Ms = MeasureMs(Repetitions, [&Xml = Xml, &Failed]()
+        {
+            TiXmlDocument Doc;
+            Doc.SetUseArena(true);
+            Doc.Parse(Xml.c_str());
+            Failed = Failed || Doc.Error();
+        });
+        if(Failed)
+        {
+            std::fprintf(stderr, "the %s document could not be parsed\n", Name);
+            return 1;
+        }
+        std::printf("%-6s %8.2f MB  %8.3f ms  %8.1f MB/s\n", Name, Xml.size()/1e6, Ms, Xml.size()/1e3/Ms);
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "../ZoneBinary.h"
+#include "../ZoneConfig.h"
+#include "Benchmark.h"
+#include "BenchmarkZones.h"
+
+using namespace mouseevents;
+
+// Startup load of a configuration in the XML and in the binary format.
+// Usage: ZoneConfigBenchmark [zones] [lines per zone] [repetitions]
+int main(int argc, char* argv[])
+{
+    const int ZoneCount = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int LineCount = argc > 2 ? std::atoi(argv[2]) : 8;
+    const int Repetitions = argc > 3 ? std::atoi(argv[3]) : 21;
+
+    const auto Zones = MakeBenchmarkZones(ZoneCount, LineCount);
+
+    const auto Directory = std::filesystem::temp_directory_path();
+    const auto XMLPath = (Directory / "ZoneConfigBenchmark.xml").string();
+    const auto BinaryPath = (Directory / "ZoneConfigBenchmark.bin").string();
+    {
+        std::ofstream Ofs(XMLPath);
+        WriteConfigXML(Ofs, Zones);
+    }
+    WriteConfigBinary(BinaryPath, Zones);
+
+    std::size_t Loaded{0};
+    const auto XMLMs = MeasureMs(Repetitions, [&]() { std::map<int, CMouseEvents::SZone> Read; ReadConfig(XMLPath, Read); Loaded += Read.size(); });
+    const auto BinaryMs = MeasureMs(Repetitions, [&]() { std::map<int, CMouseEvents::SZone> Read; ReadConfig(BinaryPath, Read); Loaded += Read.size(); });
+    const auto MapMs = MeasureMs(Repetitions, [&]() { CZoneBinaryView View; View.Open(BinaryPath); Loaded += View.Find(ZoneCount/2).has_value(); });
+
+    std::printf("%d zones of %d lines, median of %d loads\n", ZoneCount, LineCount, Repetitions);
+    std::printf("XML      %8zu bytes  %8.3f ms\n", static_cast<std::size_t>(std::filesystem::file_size(XMLPath)), XMLMs);
+    std::printf("binary   %8zu bytes  %8.3f ms\n", static_cast<std::size_t>(std::filesystem::file_size(BinaryPath)), BinaryMs);
+    std::printf("mapped only          %8.3f ms (open and find one zone, no copy)\n", MapMs);
+    return Loaded > 0 ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+#include "EventLog.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace mouseevents
+{
+
+namespace
+{
+
+const char* LevelName(ELogLevel Level)
+{
+    switch(Level)
+    {
+    case ELogLevel::Debug: return "DEBUG";
+    case ELogLevel::Info: return "INFO";
+    case ELogLevel::Warning: return "WARNING";
+    case ELogLevel::Error: return "ERROR";
+    default: return "";
+    }
+}
+
+}
+
+CEventLog::CEventLog()
+{
+    for(std::size_t i = 0; i < SlotCount; ++i)
+    {
+        m_Slots[i].s_Sequence.store(i, std::memory_order_relaxed);
+    }
+    m_Drainer = std::thread(&CEventLog::Run, this);
+}
+
+CEventLog::~CEventLog()
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Published.notify_one();
+    m_Drainer.join();
+}
+
+void CEventLog::Log(ELogLevel Level, const char* Format, ...)
+{
+    if(!Enabled(Level))
+    {
+        return;
+    }
+
+    SSlot* Slot = Acquire();
+    if(!Slot)
+    {
+        return;
+    }
+
+    va_list Args;
+    va_start(Args, Format);
+    int Length = std::vsnprintf(Slot->s_Text, TextSize, Format, Args);
+    va_end(Args);
+
+    Publish(Slot, Level, Length < 0 ? 0 : std::min<std::size_t>(Length, TextSize - 1));
+}
+
+void CEventLog::Write(ELogLevel Level, const std::string& Text)
+{
+    if(!Enabled(Level))
+    {
+        return;
+    }
+
+    std::size_t Begin{0};
+    while(Begin < Text.size())
+    {
+        auto End = Text.find('\n', Begin);
+        End = End == std::string::npos ? Text.size() : End;
+
+        auto Length = std::min(End - Begin, TextSize);
+        SSlot* Slot = Acquire();
+        if(!Slot)
+        {
+            return;
+        }
+        std::memcpy(Slot->s_Text, Text.data() + Begin, Length);
+        Publish(Slot, Level, Length);
+
+        // Continue with the rest of a long line or skip the line break
+        Begin += Length;
+        if(Begin == End)
+        {
+            ++Begin;
+        }
+    }
+}
+
+void CEventLog::Flush()
+{
+    auto Target = m_EnqueuePos.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    m_Drained.wait(Lock, [this, Target]() { return m_Written.load(std::memory_order_acquire) >= Target; });
+}
+
+CEventLog::SSlot* CEventLog::Acquire()
+{
+    auto Pos = m_EnqueuePos.load(std::memory_order_relaxed);
+    while(true)
+    {
+        SSlot* Slot = &m_Slots[Pos & (SlotCount - 1)];
+        auto Sequence = Slot->s_Sequence.load(std::memory_order_acquire);
+        auto Diff = static_cast<std::intptr_t>(Sequence) - static_cast<std::intptr_t>(Pos);
+        if(Diff == 0)
+        {
+            if(m_EnqueuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+            {
+                return Slot;
+            }
+        }
+        else if(Diff < 0)
+        {
+            // The drain thread has not caught up, drop the message
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+        {
+            Pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void CEventLog::Publish(SSlot* Slot, ELogLevel Level, std::size_t Length)
+{
+    Slot->s_Level = Level;
+    Slot->s_Length = static_cast<std::uint16_t>(Length);
+    Slot->s_Sequence.store(Slot->s_Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    // Either the drain thread sees the slot before it waits, or this sees it waiting (the fences pair with Run)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_Waiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Published.notify_one();
+    }
+}
+
+bool CEventLog::Ready() const
+{
+    return m_Slots[m_DequeuePos & (SlotCount - 1)].s_Sequence.load(std::memory_order_acquire) == m_DequeuePos + 1;
+}
+
+bool CEventLog::Drain()
+{
+    std::size_t Count{0};
+    while(true)
+    {
+        if(!Ready())
+        {
+            break;
+        }
+        SSlot& Slot = m_Slots[m_DequeuePos & (SlotCount - 1)];
+
+        std::cout << '[' << LevelName(Slot.s_Level) << "] ";
+        std::cout.write(Slot.s_Text, Slot.s_Length);
+        std::cout << '\n';
+
+        // Free the slot for the next round of the ring
+        Slot.s_Sequence.store(m_DequeuePos + SlotCount, std::memory_order_release);
+        ++m_DequeuePos;
+        ++Count;
+    }
+
+    if(Count == 0)
+    {
+        return false;
+    }
+
+    if(auto Dropped = m_Dropped.exchange(0, std::memory_order_relaxed))
+    {
+        std::cout << '[' << LevelName(ELogLevel::Warning) << "] " << Dropped << " log messages dropped\n";
+    }
+    std::cout << std::flush;
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Written.fetch_add(Count, std::memory_order_release);
+    }
+    m_Drained.notify_all();
+    return true;
+}
+
+void CEventLog::Run()
+{
+    while(!m_Stop.load(std::memory_order_relaxed))
+    {
+        if(Drain())
+        {
+            continue;
+        }
+
+        // Sleep until a message is published, the producer which finds m_Waiting set wakes the thread
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        m_Waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_Published.wait(Lock, [this]() { return m_Stop.load(std::memory_order_relaxed) || Ready(); });
+        m_Waiting.store(false, std::memory_order_relaxed);
+    }
+    Drain();
+}
+
+CEventLog& EventLog()
+{
+    static CEventLog Log;
+    return Log;
+}
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace mouseevents
+{
+
+enum class ELogLevel : std::uint8_t
+{
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+// Diagnostic log with a lock-free bounded ring buffer (multiple producers, one consumer).
+// Logging formats into a fixed-size slot and never allocates; a background thread drains the ring
+// to std::cout. Messages are dropped (and counted) when the ring is full. The drain thread sleeps
+// while the ring is empty, only the message which finds it asleep takes a lock to wake it.
+class CEventLog
+{
+public:
+    CEventLog();
+
+    ~CEventLog();
+
+    CEventLog(const CEventLog&) = delete;
+    CEventLog& operator=(const CEventLog&) = delete;
+
+    // Messages below the level are discarded at the call site, ELogLevel::Off disables the log
+    void SetLevel(ELogLevel Level) { m_Level.store(Level, std::memory_order_relaxed); }
+    ELogLevel GetLevel() const { return m_Level.load(std::memory_order_relaxed); }
+    bool Enabled(ELogLevel Level) const { return Level >= GetLevel() && Level != ELogLevel::Off; }
+
+    // printf-style message, truncated to the slot size
+#if defined(__GNUC__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+    void Log(ELogLevel Level, const char* Format, ...);
+
+    // Multi-line text, one slot per line (long lines are split over several slots)
+    void Write(ELogLevel Level, const std::string& Text);
+
+    // Block until everything logged so far is written
+    void Flush();
+
+private:
+    static constexpr std::size_t SlotSize{256};
+    static constexpr std::size_t SlotCount{1024}; // power of two
+
+    struct SSlot
+    {
+        std::atomic<std::size_t> s_Sequence{0};
+        ELogLevel s_Level{ELogLevel::Info};
+        std::uint16_t s_Length{0};
+        char s_Text[SlotSize - sizeof(std::atomic<std::size_t>) - sizeof(std::uint32_t)];
+    };
+
+    static constexpr std::size_t TextSize{sizeof(SSlot::s_Text)};
+    static_assert(sizeof(SSlot) == SlotSize, "log slots must have a fixed size");
+
+    // Claim a free slot, nullptr if the ring is full
+    SSlot* Acquire();
+
+    // Hand a filled slot to the drain thread
+    void Publish(SSlot* Slot, ELogLevel Level, std::size_t Length);
+
+    // Whether the next slot of the drain thread is published
+    bool Ready() const;
+
+    // Write all published slots, returns false if there was nothing to write
+    bool Drain();
+
+    void Run();
+
+    std::array<SSlot, SlotCount> m_Slots;
+    alignas(64) std::atomic<std::size_t> m_EnqueuePos{0};
+    alignas(64) std::size_t m_DequeuePos{0};
+    std::atomic<std::size_t> m_Dropped{0};
+    std::atomic<std::size_t> m_Written{0};
+    std::atomic<ELogLevel> m_Level{ELogLevel::Info};
+    std::atomic<bool> m_Stop{false};
+    std::atomic<bool> m_Waiting{false}; // the drain thread found the ring empty and waits for a message
+    std::mutex m_Mutex;
+    std::condition_variable m_Published; // a message for the waiting drain thread, or the end of the log
+    std::condition_variable m_Drained;   // messages were written, for Flush
+    std::thread m_Drainer;
+};
+
+// Process wide log
+CEventLog& EventLog();
+
+}
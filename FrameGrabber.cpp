@@ -0,0 +1,208 @@
+#include "FrameGrabber.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "EventLog.h"
+
+namespace mouseevents
+{
+
+namespace
+{
+
+// Interval between the frames of a video at its frame rate, 25 frames per second if the file has none
+std::chrono::steady_clock::duration FrameInterval(double FramesPerSecond)
+{
+    if(!(FramesPerSecond > 0 && FramesPerSecond <= 1000))
+    {
+        FramesPerSecond = 25;
+    }
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1 / FramesPerSecond));
+}
+
+}
+
+CFrameGrabber::CFrameGrabber(std::size_t Capacity, EFramePolicy Policy)
+    : m_Capacity{std::max<std::size_t>(Capacity, 1)}
+    , m_Policy{Policy}
+    , m_Slots(m_Capacity)
+    , m_CaptureTimes(m_Capacity)
+{
+}
+
+CFrameGrabber::~CFrameGrabber()
+{
+    Close();
+}
+
+bool CFrameGrabber::Open(int CameraIndex, bool Loop)
+{
+    Close();
+    m_FrameInterval = {};
+    return m_Capture.open(CameraIndex) && Start(Loop);
+}
+
+bool CFrameGrabber::Open(const std::string& FileName, bool Loop)
+{
+    Close();
+    if(!m_Capture.open(FileName))
+    {
+        return false;
+    }
+    // A camera delivers at its own rate, a video would be decoded as fast as possible
+    m_FrameInterval = m_Policy == EFramePolicy::DropOldest ? FrameInterval(m_Capture.get(cv::CAP_PROP_FPS)) : std::chrono::steady_clock::duration{};
+    return Start(Loop);
+}
+
+bool CFrameGrabber::Start(bool Loop)
+{
+    if(!m_Capture.isOpened())
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_First = 0;
+        m_Count = 0;
+        m_Captures = 0;
+        m_Stop = false;
+        m_Ended = false;
+    }
+    m_Loop = Loop;
+    m_Capturer = std::thread(&CFrameGrabber::Run, this);
+    return true;
+}
+
+bool CFrameGrabber::Read(cv::Mat& Frame)
+{
+    std::chrono::steady_clock::time_point CaptureTime;
+    return Read(Frame, CaptureTime);
+}
+
+bool CFrameGrabber::Read(cv::Mat& Frame, std::chrono::steady_clock::time_point& CaptureTime)
+{
+    {
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        m_Captured.wait(Lock, [this]() { return m_Count > 0 || m_Ended; });
+        if(m_Count == 0)
+        {
+            return false;
+        }
+
+        if(m_Policy == EFramePolicy::DropOldest)
+        {
+            // Only the latest frame is worth showing
+            m_Dropped += m_Count - 1;
+            m_First = (m_First + m_Count - 1) % m_Capacity;
+            m_Count = 1;
+        }
+
+        std::swap(Frame, m_Slots[m_First]);
+        CaptureTime = m_CaptureTimes[m_First];
+        m_First = (m_First + 1) % m_Capacity;
+        --m_Count;
+    }
+    m_Released.notify_one();
+    return true;
+}
+
+void CFrameGrabber::Close()
+{
+    if(!m_Capturer.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Released.notify_one();
+    m_Capturer.join();
+    m_Capture.release();
+}
+
+std::size_t CFrameGrabber::Queued() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_Count;
+}
+
+std::size_t CFrameGrabber::Dropped() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_Dropped;
+}
+
+void CFrameGrabber::Run()
+{
+    // Decoded outside of the lock, then exchanged with the free slot (whose buffer is decoded into next)
+    cv::Mat Frame;
+    auto Due = std::chrono::steady_clock::now();
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> Lock(m_Mutex);
+            if(m_Policy == EFramePolicy::Block)
+            {
+                m_Released.wait(Lock, [this]() { return m_Stop || m_Count < m_Capacity; });
+            }
+            else if(m_FrameInterval != std::chrono::steady_clock::duration::zero())
+            {
+                m_Released.wait_until(Lock, Due, [this]() { return m_Stop; });
+            }
+            if(m_Stop)
+            {
+                break;
+            }
+        }
+
+        try
+        {
+            if(!m_Capture.read(Frame) || Frame.empty())
+            {
+                // End of the video, start again
+                if(!m_Loop || !m_Capture.set(cv::CAP_PROP_POS_MSEC, 1) || !m_Capture.read(Frame) || Frame.empty())
+                {
+                    break;
+                }
+            }
+        }
+        catch(const cv::Exception& Ex)
+        {
+            EventLog().Log(ELogLevel::Error, "Could not capture a frame: %s", Ex.what());
+            break;
+        }
+
+        const auto CaptureTime = std::chrono::steady_clock::now();
+        // A video which decodes too slowly for its frame rate is not caught up with a burst of frames
+        Due = std::max(Due + m_FrameInterval, CaptureTime);
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            if(m_Count == m_Capacity)
+            {
+                // Only with EFramePolicy::DropOldest
+                m_First = (m_First + 1) % m_Capacity;
+                --m_Count;
+                ++m_Dropped;
+            }
+            const auto Slot = (m_First + m_Count) % m_Capacity;
+            std::swap(Frame, m_Slots[Slot]);
+            m_CaptureTimes[Slot] = CaptureTime;
+            ++m_Count;
+            ++m_Captures;
+        }
+        m_Captured.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Ended = true;
+        EventLog().Log(ELogLevel::Info, "Capture ended after %zu frames, %zu dropped", m_Captures, m_Dropped);
+    }
+    m_Captured.notify_all();
+}
+
+}
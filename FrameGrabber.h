@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+namespace mouseevents
+{
+
+enum class EFramePolicy : std::uint8_t
+{
+    DropOldest, // a full ring drops its oldest frame and Read skips to the latest one (live display)
+    Block       // capture waits for a free slot and Read returns every frame in order
+};
+
+// Decodes the frames of a camera or video on a capture thread into a bounded ring of frames, so that
+// decoding runs in parallel with the display loop. Frames are exchanged with the caller of Read, not
+// copied: the buffers of frames which were already shown are decoded into again.
+class CFrameGrabber
+{
+public:
+    CFrameGrabber(std::size_t Capacity = 2, EFramePolicy Policy = EFramePolicy::DropOldest);
+
+    ~CFrameGrabber();
+
+    CFrameGrabber(const CFrameGrabber&) = delete;
+    CFrameGrabber& operator=(const CFrameGrabber&) = delete;
+
+    // Open a camera or a video file and start capturing. A video starts again at its end if Loop is set.
+    // With EFramePolicy::DropOldest a video is captured at its frame rate (25 frames per second if the file
+    // has none) like a camera, instead of as fast as it decodes only to drop most frames. With
+    // EFramePolicy::Block the reader sets the pace, every frame is decoded as soon as a slot is free.
+    bool Open(int CameraIndex, bool Loop = true);
+    bool Open(const std::string& FileName, bool Loop = true);
+
+    // Wait for the next frame. Returns false once the stream has ended and all captured frames are read.
+    // The previous content of Frame goes back to the ring and is overwritten, clone a frame to keep it past the next Read.
+    bool Read(cv::Mat& Frame);
+
+    // Read, and get the time at which the frame was captured
+    bool Read(cv::Mat& Frame, std::chrono::steady_clock::time_point& CaptureTime);
+
+    // Number of captured frames waiting to be read
+    std::size_t Queued() const;
+
+    // Stop capturing, the frames captured so far can still be read
+    void Close();
+
+    // Number of captured frames which were dropped or skipped, never returned by Read
+    std::size_t Dropped() const;
+
+private:
+    bool Start(bool Loop);
+
+    void Run();
+
+    const std::size_t m_Capacity{2};
+    const EFramePolicy m_Policy{EFramePolicy::DropOldest};
+    cv::VideoCapture m_Capture;
+    bool m_Loop{true};
+    std::chrono::steady_clock::duration m_FrameInterval{}; // pace of a video captured with DropOldest, zero for a camera
+    std::vector<cv::Mat> m_Slots; // ring of captured frames
+    std::vector<std::chrono::steady_clock::time_point> m_CaptureTimes;
+    std::size_t m_First{0};       // oldest captured frame
+    std::size_t m_Count{0};       // number of captured frames not read yet
+    std::size_t m_Captures{0};
+    std::size_t m_Dropped{0};
+    bool m_Stop{false};
+    bool m_Ended{true};
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Captured;
+    std::condition_variable m_Released;
+    std::thread m_Capturer;
+};
+
+}
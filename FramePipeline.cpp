@@ -0,0 +1,229 @@
+#include "FramePipeline.h"
+
+#include <algorithm>
+
+#include <opencv2/highgui.hpp>
+
+#include "EventLog.h"
+#include "FrameGrabber.h"
+#include "MouseEvents.h"
+
+namespace mouseevents
+{
+
+namespace
+{
+
+double Milliseconds(std::chrono::steady_clock::duration Duration)
+{
+    return std::chrono::duration<double, std::milli>(Duration).count();
+}
+
+void LogStage(const char* Name, const SStageStats& Stats)
+{
+    EventLog().Log(ELogLevel::Info, "%s: %.1f ms (max %.1f), queue depth %.2f (max %zu)",
+                   Name, Stats.AverageMs(), Stats.s_MaxMs, Stats.AverageDepth(), Stats.s_MaxDepth);
+}
+
+constexpr std::size_t StatsInterval{300}; // frames between two logs of the stage statistics
+
+}
+
+CFramePool::CFramePool(std::size_t Capacity)
+    : m_Capacity{Capacity}
+{
+    m_Frames.reserve(m_Capacity);
+}
+
+void CFramePool::Acquire(cv::Mat& Frame)
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    if(m_Frames.empty())
+    {
+        Frame.release();
+        return;
+    }
+    Frame = m_Frames.back();
+    m_Frames.pop_back();
+}
+
+void CFramePool::Release(cv::Mat& Frame)
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        if(!Frame.empty() && m_Frames.size() < m_Capacity)
+        {
+            m_Frames.push_back(Frame);
+        }
+    }
+    Frame.release();
+}
+
+void SStageStats::Add(double Ms, std::size_t Depth)
+{
+    ++s_Frames;
+    s_TotalMs += Ms;
+    s_MaxMs = std::max(s_MaxMs, Ms);
+    s_TotalDepth += Depth;
+    s_MaxDepth = std::max(s_MaxDepth, Depth);
+}
+
+double SStageStats::AverageMs() const
+{
+    return s_Frames ? s_TotalMs/s_Frames : 0.0;
+}
+
+double SStageStats::AverageDepth() const
+{
+    return s_Frames ? static_cast<double>(s_TotalDepth)/s_Frames : 0.0;
+}
+
+CFramePipeline::CFramePipeline(CMouseEvents& Events, CFrameGrabber& Grabber, std::size_t QueueSize)
+    : m_Events{Events}
+    , m_Grabber{Grabber}
+    , m_QueueSize{std::max<std::size_t>(QueueSize, 1)}
+    , m_Pool{m_QueueSize + 2} // one for each queued frame, the one composed and the one shown
+    , m_ZoomPool{m_QueueSize + 2}
+{
+}
+
+void CFramePipeline::Run()
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Queue.clear();
+        m_Stop = false;
+        m_Ended = false;
+    }
+    m_Composer = std::thread(&CFramePipeline::Compose, this);
+
+    std::size_t Presented{0};
+    while(true)
+    {
+        SComposedFrame Frame;
+        std::size_t Depth{0};
+        {
+            std::unique_lock<std::mutex> Lock(m_Mutex);
+            // The mouse events are dispatched by waitKey, keep the window responsive while no frame is ready
+            if(!m_Composed.wait_for(Lock, std::chrono::milliseconds(10), [this]() { return m_Stop || m_Ended || !m_Queue.empty(); }))
+            {
+                Lock.unlock();
+                cv::waitKey(1);
+                continue;
+            }
+            if(m_Stop || m_Queue.empty())
+            {
+                break;
+            }
+            Depth = m_Queue.size();
+            Frame = std::move(m_Queue.front());
+            m_Queue.pop_front();
+        }
+        m_Released.notify_one();
+
+        m_Events.Present(Frame.s_Composed, Frame.s_Zoom);
+        const auto Ms = Milliseconds(std::chrono::steady_clock::now() - Frame.s_ComposedTime);
+        {
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            m_Stats.s_Present.Add(Ms, Depth);
+        }
+
+        m_Pool.Release(Frame.s_Composed);
+        m_ZoomPool.Release(Frame.s_Zoom);
+
+        if(++Presented % StatsInterval == 0 && EventLog().Enabled(ELogLevel::Info))
+        {
+            const auto Stats = this->Stats();
+            LogStage("Capture", Stats.s_Capture);
+            LogStage("Compose", Stats.s_Compose);
+            LogStage("Present", Stats.s_Present);
+            const auto Latency = m_Events.GetInputLatency();
+            EventLog().Log(ELogLevel::Info, "Input latency: p50 %.1f ms, p95 %.1f ms, p99 %.1f ms (%zu events)",
+                           Latency.s_P50Ms, Latency.s_P95Ms, Latency.s_P99Ms, Latency.s_Count);
+        }
+    }
+
+    bool Stopped{false};
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        Stopped = m_Stop;
+        m_Stop = true;
+    }
+    m_Released.notify_one();
+    if(Stopped)
+    {
+        // The compose thread may wait for a frame from the grabber
+        m_Grabber.Close();
+    }
+    m_Composer.join();
+
+    for(auto& Frame : m_Queue)
+    {
+        m_Pool.Release(Frame.s_Composed);
+        m_ZoomPool.Release(Frame.s_Zoom);
+    }
+    m_Queue.clear();
+}
+
+void CFramePipeline::Stop()
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Composed.notify_one();
+    m_Released.notify_one();
+}
+
+SPipelineStats CFramePipeline::Stats() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_Stats;
+}
+
+void CFramePipeline::Compose()
+{
+    // The frame buffer goes back to the grabber ring with the next Read
+    cv::Mat Frame;
+    std::chrono::steady_clock::time_point CaptureTime;
+    while(m_Grabber.Read(Frame, CaptureTime))
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        const auto CaptureDepth = m_Grabber.Queued();
+
+        SComposedFrame Composed;
+        m_Pool.Acquire(Composed.s_Composed);
+        m_ZoomPool.Acquire(Composed.s_Zoom);
+        try
+        {
+            m_Events.Compose(Frame, Composed.s_Composed, Composed.s_Zoom);
+        }
+        catch(const cv::Exception& Ex)
+        {
+            EventLog().Log(ELogLevel::Error, "Could not compose a frame: %s", Ex.what());
+            break;
+        }
+        Composed.s_ComposedTime = std::chrono::steady_clock::now();
+
+        {
+            std::unique_lock<std::mutex> Lock(m_Mutex);
+            m_Released.wait(Lock, [this]() { return m_Stop || m_Queue.size() < m_QueueSize; });
+            if(m_Stop)
+            {
+                break;
+            }
+            m_Queue.push_back(std::move(Composed));
+            m_Stats.s_Capture.Add(Milliseconds(Start - CaptureTime), CaptureDepth);
+            m_Stats.s_Compose.Add(Milliseconds(m_Queue.back().s_ComposedTime - Start), m_Queue.size());
+        }
+        m_Composed.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Ended = true;
+    }
+    m_Composed.notify_one();
+}
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace mouseevents
+{
+
+class CFrameGrabber;
+class CMouseEvents;
+
+// Bounded pool of frame buffers shared by the stages of a CFramePipeline. A released buffer keeps its
+// allocation, so that composing into an acquired buffer of the same size allocates nothing.
+class CFramePool
+{
+public:
+    CFramePool(std::size_t Capacity);
+
+    CFramePool(const CFramePool&) = delete;
+    CFramePool& operator=(const CFramePool&) = delete;
+
+    // Take a buffer from the pool, an empty frame if the pool is empty
+    void Acquire(cv::Mat& Frame);
+
+    // Give a buffer back to the pool, it is freed if the pool is full. Frame is empty afterwards.
+    void Release(cv::Mat& Frame);
+
+private:
+    const std::size_t m_Capacity{0};
+    std::vector<cv::Mat> m_Frames;
+    std::mutex m_Mutex;
+};
+
+// Queue depth and latency of one stage of a CFramePipeline
+struct SStageStats
+{
+    void Add(double Ms, std::size_t Depth);
+
+    double AverageMs() const;
+
+    double AverageDepth() const;
+
+    std::size_t s_Frames{0};
+    double s_TotalMs{0};
+    double s_MaxMs{0};
+    std::size_t s_TotalDepth{0}; // sum of the depths of the input queue of the stage
+    std::size_t s_MaxDepth{0};
+};
+
+struct SPipelineStats
+{
+    SStageStats s_Capture; // time from the capture until the frame is read, depth of the grabber ring
+    SStageStats s_Compose; // time to compose, depth of the present queue after the push
+    SStageStats s_Present; // time from the end of composing until shown, depth of the present queue before the pop
+};
+
+// Runs capture, composition and presentation of the frames as separate stages, so that the frame rate is set by
+// the slowest stage rather than by the sum of all stages. The frames are captured by the grabber thread, composed
+// (mouse events, zones and zoom drawn) on a compose thread and shown on the thread which calls Run. HighGUI windows
+// must be used from a single thread, so that thread should be the main thread.
+// The composed frames are passed on through a bounded queue and their buffers are taken from a CFramePool, the zoomed
+// regions from another one: without a zoom window a frame buffer would wait unused in the zoom of every frame.
+class CFramePipeline
+{
+public:
+    // The mouse events must not be used from another thread while the pipeline runs
+    CFramePipeline(CMouseEvents& Events, CFrameGrabber& Grabber, std::size_t QueueSize = 2);
+
+    CFramePipeline(const CFramePipeline&) = delete;
+    CFramePipeline& operator=(const CFramePipeline&) = delete;
+
+    // Show the frames of the grabber until it ends or Stop is called. The grabber is closed if stopped.
+    void Run();
+
+    // Make Run return after the frame being shown, can be called from any thread
+    void Stop();
+
+    SPipelineStats Stats() const;
+
+private:
+    struct SComposedFrame
+    {
+        cv::Mat s_Composed;
+        cv::Mat s_Zoom;
+        std::chrono::steady_clock::time_point s_ComposedTime;
+    };
+
+    void Compose();
+
+    CMouseEvents& m_Events;
+    CFrameGrabber& m_Grabber;
+    const std::size_t m_QueueSize{2};
+    CFramePool m_Pool;
+    CFramePool m_ZoomPool;
+    std::deque<SComposedFrame> m_Queue;
+    SPipelineStats m_Stats;
+    bool m_Stop{false};
+    bool m_Ended{false};
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Composed;
+    std::condition_variable m_Released;
+    std::thread m_Composer;
+};
+
+}
@@ -0,0 +1,65 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+
+namespace mouseevents
+{
+
+void CLatencyHistogram::Add(double Ms)
+{
+    Ms = std::max(Ms, 0.0);
+    const auto Bucket = std::min(static_cast<std::size_t>(Ms/BucketMs), BucketCount - 1);
+    m_Buckets[Bucket].fetch_add(1, std::memory_order_relaxed);
+
+    const auto Us = static_cast<std::uint64_t>(Ms*1000);
+    auto MaxUs = m_MaxUs.load(std::memory_order_relaxed);
+    while(Us > MaxUs && !m_MaxUs.compare_exchange_weak(MaxUs, Us, std::memory_order_relaxed))
+    {
+    }
+}
+
+SLatencyStats CLatencyHistogram::Stats() const
+{
+    std::array<std::uint32_t, BucketCount> Counts;
+    SLatencyStats Stats;
+    for(std::size_t Bucket = 0; Bucket < BucketCount; ++Bucket)
+    {
+        Counts[Bucket] = m_Buckets[Bucket].load(std::memory_order_relaxed);
+        Stats.s_Count += Counts[Bucket];
+    }
+    Stats.s_MaxMs = m_MaxUs.load(std::memory_order_relaxed)/1000.0;
+    if(Stats.s_Count == 0)
+    {
+        return Stats;
+    }
+
+    // Smallest bucket with at least the fraction of all latencies up to it
+    const auto Rank = [&Stats](double Fraction) { return std::max<std::size_t>(1, static_cast<std::size_t>(Fraction*Stats.s_Count + 0.5)); };
+    const std::size_t P50{Rank(0.50)}, P95{Rank(0.95)}, P99{Rank(0.99)};
+    std::size_t Below{0};
+    for(std::size_t Bucket = 0; Bucket < BucketCount; ++Bucket)
+    {
+        const auto Previous = Below;
+        Below += Counts[Bucket];
+        const auto UpperMs = std::min((Bucket + 1)*BucketMs, Stats.s_MaxMs);
+        Stats.s_P50Ms = (Previous < P50 && Below >= P50) ? UpperMs : Stats.s_P50Ms;
+        Stats.s_P95Ms = (Previous < P95 && Below >= P95) ? UpperMs : Stats.s_P95Ms;
+        Stats.s_P99Ms = (Previous < P99 && Below >= P99) ? UpperMs : Stats.s_P99Ms;
+        if(Below >= P99)
+        {
+            break;
+        }
+    }
+    return Stats;
+}
+
+void CLatencyHistogram::Reset()
+{
+    for(auto& Bucket : m_Buckets)
+    {
+        Bucket.store(0, std::memory_order_relaxed);
+    }
+    m_MaxUs.store(0, std::memory_order_relaxed);
+}
+
+}
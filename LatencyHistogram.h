@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mouseevents
+{
+
+struct SLatencyStats
+{
+    std::size_t s_Count{0};
+    double s_P50Ms{0};
+    double s_P95Ms{0};
+    double s_P99Ms{0};
+    double s_MaxMs{0};
+};
+
+// Histogram of latencies in buckets of 0.1 ms up to 500 ms, longer ones share the last bucket.
+// Add and Stats never block and can be called from any thread.
+class CLatencyHistogram
+{
+public:
+    CLatencyHistogram() = default;
+
+    CLatencyHistogram(const CLatencyHistogram&) = delete;
+    CLatencyHistogram& operator=(const CLatencyHistogram&) = delete;
+
+    void Add(double Ms);
+
+    // Percentiles are the upper bound of their bucket. Only a snapshot while latencies are added.
+    SLatencyStats Stats() const;
+
+    void Reset();
+
+private:
+    static constexpr double BucketMs{0.1};
+    static constexpr std::size_t BucketCount{5000};
+
+    std::array<std::atomic<std::uint32_t>, BucketCount> m_Buckets{};
+    std::atomic<std::uint64_t> m_MaxUs{0};
+};
+
+}
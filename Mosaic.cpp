@@ -0,0 +1,279 @@
+#include "Mosaic.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+#include <opencv2/highgui.hpp>
+
+#include "EventLog.h"
+#include "MouseEvents.h"
+
+namespace mouseevents
+{
+
+namespace
+{
+
+constexpr int EscapeKey{27};
+
+}
+
+CMosaic::CMosaic(const std::string& WinName, cv::Size TileSize, std::size_t Workers)
+    : m_WinName{WinName}
+    , m_TileSize{TileSize}
+    , m_WorkerCount{std::max<std::size_t>(Workers, 1)}
+{
+}
+
+CMosaic::~CMosaic() = default;
+
+bool CMosaic::Add(const std::string& Source, const std::string& ConfigPath, const std::string& SnapPath)
+{
+    auto Stream = std::make_unique<SStream>();
+    Stream->s_Source = Source;
+    const bool IsCamera = !Source.empty() && std::all_of(Source.cbegin(), Source.cend(), [](char C) { return std::isdigit(static_cast<unsigned char>(C)) != 0; });
+    if(!(IsCamera ? Stream->s_Capture.open(std::stoi(Source)) : Stream->s_Capture.open(Source)))
+    {
+        EventLog().Log(ELogLevel::Error, "Could not open %s", Source.c_str());
+        return false;
+    }
+
+    // The events of the tile are posted by the mosaic window
+    Stream->s_Events = std::make_unique<CMouseEvents>(m_WinName + std::to_string(m_Streams.size()), ConfigPath, SnapPath, false, false);
+    m_Streams.push_back(std::move(Stream));
+    return true;
+}
+
+void CMosaic::Run()
+{
+    if(m_Streams.empty())
+    {
+        return;
+    }
+
+    // As square as possible
+    const auto Count = m_Streams.size();
+    m_Columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(Count))));
+    const auto Rows = (static_cast<int>(Count) + m_Columns - 1)/m_Columns;
+    m_Mosaic = cv::Mat(cv::Size(m_Columns*m_TileSize.width, Rows*m_TileSize.height), CV_8UC3, cv::Scalar(0, 0, 0));
+
+    m_Captured = m_Pointed = -1;
+    cv::namedWindow(m_WinName, cv::WINDOW_AUTOSIZE);
+    cv::setMouseCallback(m_WinName, OnMouse, this);
+
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Queue.clear();
+        m_Ended = 0;
+        m_Stop = false;
+        for(std::size_t Index = 0; Index < Count; ++Index)
+        {
+            m_Queue.push_back(Index);
+        }
+    }
+    for(std::size_t Worker = 0; Worker < std::min(m_WorkerCount, Count); ++Worker)
+    {
+        m_Workers.emplace_back(&CMosaic::Decode, this);
+    }
+    EventLog().Log(ELogLevel::Info, "Showing %zu streams in %d x %d tiles, decoded by %zu workers", Count, m_Columns, Rows, m_Workers.size());
+
+    while(true)
+    {
+        if(!Collect())
+        {
+            break;
+        }
+
+        for(std::size_t Index = 0; Index < Count; ++Index)
+        {
+            if(!m_Streams[Index]->s_Frame.empty())
+            {
+                Compose(*m_Streams[Index], GetTile(Index));
+            }
+        }
+        cv::imshow(m_WinName, m_Mosaic);
+        for(const auto& Stream : m_Streams)
+        {
+            if(!Stream->s_Frame.empty())
+            {
+                Stream->s_Events->Presented();
+            }
+        }
+
+        // Undo and redo apply to the tile under the pointer, like a click
+        const auto Key = cv::waitKey(m_Delay);
+        if(Key == EscapeKey)
+        {
+            break;
+        }
+        if((CMouseEvents::IsUndoKey(Key) || CMouseEvents::IsRedoKey(Key)) && m_Pointed != -1)
+        {
+            m_Streams[m_Pointed]->s_Events->Post(CMouseEvents::KeyEvent, Key, 0, 0);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Ready.notify_all();
+    for(auto& Worker : m_Workers)
+    {
+        Worker.join();
+    }
+    m_Workers.clear();
+    cv::setMouseCallback(m_WinName, nullptr, nullptr);
+
+    for(const auto& Stream : m_Streams)
+    {
+        const auto Latency = Stream->s_Events->GetInputLatency();
+        EventLog().Log(ELogLevel::Info, "Showed %zu frames of %s, input latency p50 %.1f ms, p99 %.1f ms",
+                       Stream->s_Frames, Stream->s_Source.c_str(), Latency.s_P50Ms, Latency.s_P99Ms);
+    }
+}
+
+void CMosaic::Stop()
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    m_Stop = true;
+}
+
+bool CMosaic::Collect()
+{
+    std::size_t Taken{0};
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        if(m_Stop)
+        {
+            return false;
+        }
+
+        // Start with another stream every frame, all streams wait as long for a worker if the workers fall behind
+        m_First = (m_First + 1)%m_Streams.size();
+        for(std::size_t Offset = 0; Offset < m_Streams.size(); ++Offset)
+        {
+            const auto Index = (m_First + Offset)%m_Streams.size();
+            auto& Stream = *m_Streams[Index];
+            if(Stream.s_New)
+            {
+                // The shown frame is decoded into next
+                std::swap(Stream.s_Decoded, Stream.s_Frame);
+                Stream.s_New = false;
+                ++Stream.s_Frames;
+                m_Queue.push_back(Index);
+                ++Taken;
+            }
+        }
+        if(Taken == 0 && m_Ended == m_Streams.size())
+        {
+            return false;
+        }
+    }
+
+    for(std::size_t Ready = 0; Ready < Taken; ++Ready)
+    {
+        m_Ready.notify_one();
+    }
+    return true;
+}
+
+void CMosaic::Decode()
+{
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    while(true)
+    {
+        m_Ready.wait(Lock, [this]() { return m_Stop || !m_Queue.empty(); });
+        if(m_Stop)
+        {
+            return;
+        }
+
+        // Only this worker uses the stream until it is queued again
+        auto& Stream = *m_Streams[m_Queue.front()];
+        m_Queue.pop_front();
+        Lock.unlock();
+
+        bool Decoded{false};
+        try
+        {
+            // At the end of a video start again
+            Decoded = (Stream.s_Capture.read(Stream.s_Decoding) && !Stream.s_Decoding.empty())
+                   || (Stream.s_Capture.set(cv::CAP_PROP_POS_MSEC, 1) && Stream.s_Capture.read(Stream.s_Decoding) && !Stream.s_Decoding.empty());
+        }
+        catch(const cv::Exception& Ex)
+        {
+            EventLog().Log(ELogLevel::Error, "Could not capture a frame of %s: %s", Stream.s_Source.c_str(), Ex.what());
+        }
+
+        Lock.lock();
+        if(Decoded)
+        {
+            std::swap(Stream.s_Decoding, Stream.s_Decoded);
+            Stream.s_New = true;
+        }
+        else
+        {
+            Stream.s_Ended = true;
+            ++m_Ended;
+            EventLog().Log(ELogLevel::Info, "Stream %s ended", Stream.s_Source.c_str());
+        }
+    }
+}
+
+void CMosaic::Compose(SStream& Stream, const cv::Rect& Tile)
+{
+    // Fit the frame into the tile, the zones stay in the coordinates of the frame
+    const auto& Frame = Stream.s_Frame;
+    Stream.s_Events->SetScale(std::min(static_cast<double>(Tile.width)/Frame.cols, static_cast<double>(Tile.height)/Frame.rows));
+    auto Size = Stream.s_Events->GetComposedSize(Frame.size());
+    Size.width = std::min(Size.width, Tile.width);
+    Size.height = std::min(Size.height, Tile.height);
+
+    // Composed in place, the tile has the size of the composed frame
+    cv::Mat Composed = m_Mosaic(cv::Rect(Tile.tl(), Size));
+    Stream.s_Events->Compose(Frame, Composed, Stream.s_Zoom);
+}
+
+cv::Rect CMosaic::GetTile(std::size_t Index) const
+{
+    const auto Column = static_cast<int>(Index)%m_Columns;
+    const auto Row = static_cast<int>(Index)/m_Columns;
+    return cv::Rect(cv::Point(Column*m_TileSize.width, Row*m_TileSize.height), m_TileSize);
+}
+
+void CMosaic::OnMouse(int Event, int X, int Y, int Flag, void* Param)
+{
+    auto* Mosaic = static_cast<CMosaic*>(Param);
+    const auto Column = X/Mosaic->m_TileSize.width;
+    const auto Row = Y/Mosaic->m_TileSize.height;
+    auto Index = Row*Mosaic->m_Columns + Column;
+    if(Mosaic->m_Captured != -1)
+    {
+        Index = Mosaic->m_Captured;
+    }
+    else if(X < 0 || Y < 0 || Column >= Mosaic->m_Columns || Index >= static_cast<int>(Mosaic->m_Streams.size()))
+    {
+        return;
+    }
+
+    // A drag ends in the tile where it started
+    if(Event == cv::EVENT_LBUTTONDOWN || Event == cv::EVENT_RBUTTONDOWN)
+    {
+        Mosaic->m_Captured = Index;
+    }
+    else if(Event == cv::EVENT_LBUTTONUP || Event == cv::EVENT_RBUTTONUP)
+    {
+        Mosaic->m_Captured = -1;
+    }
+
+    Mosaic->m_Pointed = Index;
+
+    // In the coordinates of the tile
+    const auto Tile = Mosaic->GetTile(static_cast<std::size_t>(Index));
+    X = std::clamp(X - Tile.x, 0, Tile.width - 1);
+    Y = std::clamp(Y - Tile.y, 0, Tile.height - 1);
+    Mosaic->m_Streams[Index]->s_Events->Post(Event, X, Y, Flag);
+}
+
+}
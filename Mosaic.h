@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+namespace mouseevents
+{
+
+class CMouseEvents;
+
+// Annotates the zones of several cameras or videos in one window. The streams are decoded on a pool of worker
+// threads and shown as tiles of a mosaic, each tile has its own zones (and configuration file) in the coordinates
+// of its stream. Mouse input goes to the tile under the pointer, or to the tile where a button was pressed until
+// it is released. The undo and redo keys go to the tile under the pointer, Esc closes the mosaic.
+class CMosaic
+{
+public:
+    CMosaic(const std::string& WinName, cv::Size TileSize = cv::Size(480, 270), std::size_t Workers = std::thread::hardware_concurrency());
+
+    ~CMosaic();
+
+    CMosaic(const CMosaic&) = delete;
+    CMosaic& operator=(const CMosaic&) = delete;
+
+    // Add a stream before Run, a source of digits only is a camera index. Videos start again at their end.
+    bool Add(const std::string& Source, const std::string& ConfigPath, const std::string& SnapPath);
+
+    // Show the mosaic until all streams have ended or Stop is called. Must run on the GUI thread.
+    void Run();
+
+    // Make Run return after the current frame, can be called from any thread
+    void Stop();
+
+private:
+    struct SStream
+    {
+        std::string s_Source;
+        cv::VideoCapture s_Capture;
+        std::unique_ptr<CMouseEvents> s_Events;
+        cv::Mat s_Decoding;  // written by the worker which decodes the stream
+        cv::Mat s_Decoded;   // latest decoded frame, guarded by m_Mutex
+        cv::Mat s_Frame;     // frame of the tile, only used by Run
+        cv::Mat s_Zoom;
+        bool s_New{false};   // s_Decoded is not shown yet
+        bool s_Ended{false};
+        std::size_t s_Frames{0};
+    };
+
+    // The mouse callback of the window, Param is the CMosaic object
+    static void OnMouse(int Event, int X, int Y, int Flag, void* Param);
+
+    // Worker thread, decodes the next frame of the streams which are queued
+    void Decode();
+
+    // Take the new frames of the streams and queue the streams to be decoded again, false once Run should return
+    bool Collect();
+
+    // Draw a stream and its zones into its tile
+    void Compose(SStream& Stream, const cv::Rect& Tile);
+
+    cv::Rect GetTile(std::size_t Index) const;
+
+    const std::string m_WinName{};
+    const cv::Size m_TileSize{};
+    const std::size_t m_WorkerCount{1};
+    int m_Columns{1};
+    int m_Delay{33}; // delay in ms, corresponds to 30 FPS
+    std::vector<std::unique_ptr<SStream>> m_Streams;
+    cv::Mat m_Mosaic;
+
+    // Mouse routing, only used on the GUI thread (by the callback and Run)
+    int m_Captured{-1}; // tile which gets all events while a button is held
+    int m_Pointed{-1};  // tile of the last mouse event, gets the keys
+
+    // Streams waiting for a worker, a stream is queued again once its decoded frame is taken
+    std::deque<std::size_t> m_Queue;
+    std::size_t m_First{0}; // stream queued first by the next Collect
+    std::size_t m_Ended{0};
+    bool m_Stop{false};
+    std::mutex m_Mutex;
+    std::condition_variable m_Ready;
+    std::vector<std::thread> m_Workers;
+};
+
+}
@@ -1,7 +1,15 @@
 #include "MouseEvents.h"
-
+#include "EventLog.h"
+#include "ZoneBinary.h"
+#include "ZoneConfig.h"
+#include "ZoneJournal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <numeric>
+#include <sstream>
 #include <stdio.h> // for FILE*
 #include <stdlib.h>
 
@@ -14,70 +22,11 @@ namespace
 // The absolute length should not matter for direction. Can be adjusted for better visualization.
 constexpr int ArrowLength{100};
 
-// Write configuration file
-template<typename T>
-void WriteConfigXML(T& Ofs, const CMouseEvents::SZone& Zone)
-{
-    Ofs << "<Zone ZoneId=\"" << Zone.s_ZoneId << "\" ZoneName=\"" << Zone.s_ZoneName << "\">" << std::endl;
-    Ofs << "\t<Shape Type=\"POLYGON\">" << std::endl;
-    for(auto It = Zone.s_Lines.cbegin(); It != Zone.s_Lines.cend(); ++It)
-    {
-        auto Line = *It;
-
-        // Print the 1st point of line
-        Ofs << "\t\t<Point X=\"" << Line.first.x << "\" Y=\"" << Line.first.y << "\"/>" << std::endl;
-
-        // Print the 2nd point of line if it does not match with the first point of next line
-        auto NextLine = std::next(It) != Zone.s_Lines.cend() ? *std::next(It) : Zone.s_Lines.front();
-        if(Line.second != NextLine.first)
-        {
-            Ofs << "\t\t<Point X=\"" << Line.second.x << "\" Y=\"" << Line.second.y << "\"/>" << std::endl;
-        }
-    }
-    Ofs << "\t</Shape>" << std::endl;
-    Ofs << "\t<Characteristics/>" << std::endl;
-    Ofs << "\t\t<Direction>" << std::endl;
-    Ofs << "\t\t<Point X=\"" << Zone.GetCenter().x << "\" Y=\"" << Zone.GetCenter().y << "\"/>" << std::endl;
-    Ofs << "\t\t<Point X=\"" << Zone.GetArrowHead().x << "\" Y=\"" << Zone.GetArrowHead().y << "\"/>" << std::endl;
-    Ofs << "\t\t</Direction>" << std::endl;
-    Ofs << "</Zone>" << std::endl;
-}
-
-// Write configuration file in a nice format (same as Notepad++->Plugins->XML Tools->Pretty print)
-void PrettyPrint(TiXmlDocument& Doc, const std::string& FileName = std::string{})
-{
-    Doc.LoadFile(FileName.c_str(), TiXmlEncoding::TIXML_ENCODING_UTF8);
-    if(!FileName.empty())
-    {
-        FILE *Fp = fopen(FileName.c_str(), "w+");
-        Doc.Print(Fp);
-        fclose(Fp);
-    }
-
-    Doc.Print();
 }
 
-}
-
-const std::string PreConfigElement{""};
-const std::string PostConfigElement{""};
-
 // Pixels within range [0 10] are considered identical
 constexpr int Int_Pixel_Precision{10};
 
-CMouseEvents::PointType CMouseEvents::m_P1{};
-CMouseEvents::PointType CMouseEvents::m_P2{};
-CMouseEvents::PointType CMouseEvents::m_PMousePointer{};
-CMouseEvents::PointType CMouseEvents::m_ScaledP1{};
-CMouseEvents::PointType CMouseEvents::m_ScaledP2{};
-CMouseEvents::PointType CMouseEvents::m_ScaledPMousePointer{};
-int CMouseEvents::m_ClosestZoneId{-1};
-int CMouseEvents::m_Rotation{0};
-bool CMouseEvents::m_LeftClicked = false;
-bool CMouseEvents::m_RightClicked = false;
-bool CMouseEvents::m_LeftDoubleClicked = false;
-cv::MouseEventFlags CMouseEvents::m_Flag = cv::MouseEventFlags::EVENT_FLAG_LBUTTON;
-
 std::ostream& operator<<(std::ostream& OS, const cv::Point& Pixel)
 {
     return OS << Pixel.x << " " << Pixel.y;
@@ -173,235 +122,345 @@ CMouseEvents::CMouseEvents()
     : CMouseEvents("Zones", "/tmp/Config.xml", "/tmp/Zones.jpg", false)
 {}
 
-CMouseEvents::CMouseEvents(const std::string& WinName, const std::string& ConfigPath, const std::string& SnapPath, bool DrawROI)
+CMouseEvents::CMouseEvents(const std::string& WinName, const std::string& ConfigPath, const std::string& SnapPath, bool DrawROI, bool OwnWindow)
     : m_WinName{WinName}
     , m_WinNameZoom{m_WinName + "Zoom"}
     , m_ConfigPath{ConfigPath}
     , m_SnapPath{SnapPath}
+    , m_SnapshotEncoder{GetDefaultSnapshotParams(SnapPath)}
     , m_DrawROI{DrawROI}
+    , m_OwnWindow{OwnWindow}
+    , m_Published{std::make_shared<const ZonesType>()}
+    , m_Journal{std::make_unique<CZoneJournal>(ConfigPath)}
 {
-    cv::namedWindow(m_WinName, cv::WINDOW_AUTOSIZE);
-    cv::setMouseCallback(m_WinName, OnMouse);
+    if(m_OwnWindow)
+    {
+        cv::namedWindow(m_WinName, cv::WINDOW_AUTOSIZE);
+        cv::setMouseCallback(m_WinName, OnMouse, this);
+    }
     if(m_DrawROI)
     {
         cv::namedWindow(m_WinNameZoom, cv::WINDOW_AUTOSIZE);
     }
+
+    // The document is only used to pretty print the configuration, reparsed on every save
+    m_Doc.SetUseArena(true);
+
+    // Restore the zones of the previous session including all journaled edits
+    auto Start = std::chrono::steady_clock::now();
+    std::map<int, SZone> Zones;
+    m_Journal->Load(Zones);
+    auto LoadTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start);
+    EventLog().Log(ELogLevel::Info, "Loaded %zu zones from %s in %.3f ms", Zones.size(), m_ConfigPath.c_str(), LoadTime.count());
+    if(!Zones.empty())
+    {
+        SetConfigZones(Zones);
+    }
 }
 
-void CMouseEvents::SetConfigZones(const std::map<int, SZone>& Zones)
+CMouseEvents::~CMouseEvents()
 {
-    m_Zones = Zones;
-    m_ZoneId = m_Zones.rbegin()->first + 1; // New id starts from max + 1
+    // The window may outlive this object
+    if(m_OwnWindow)
+    {
+        cv::setMouseCallback(m_WinName, nullptr, nullptr);
+    }
+
+    const auto Latency = m_InputLatency.Stats();
+    if(Latency.s_Count > 0)
+    {
+        EventLog().Log(ELogLevel::Info, "Input latency of %zu events: p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms",
+                       Latency.s_Count, Latency.s_P50Ms, Latency.s_P95Ms, Latency.s_P99Ms, Latency.s_MaxMs);
+    }
 }
 
-void CMouseEvents::Show(const cv::Mat& Frame)
+void CMouseEvents::SetConfigZones(const std::map<int, SZone>& Zones)
 {
-    cv::resize(Frame, m_CurrentScaledFrame, cv::Size(Frame.cols*m_Scale, Frame.rows*m_Scale));
-    AddLines();
-    Update();
-    Draw();
-    if(m_DrawROI)
+    std::lock_guard<std::mutex> Lock(m_StateMutex);
+    m_Zones = ZonesType();
+    for(const auto& [ZoneId, Zone] : Zones)
     {
-        DrawROI();
+        // The cached center and arrow head are filled before the zone is shared with other threads
+        Zone.GetArrowHead();
+        m_Zones.Set(ZoneId, Zone);
     }
-    cv::imshow(m_WinName, m_CurrentScaledFrame);
-    cv::waitKey(m_Delay);
+    m_ZoneId = m_Zones.Empty() ? 1 : m_Zones.Last()->first + 1; // New id starts from max + 1
+    m_Undo.clear();
+    m_Redo.clear();
+    m_Dirty = true;
+    Publish();
 }
 
-void CMouseEvents::AddLines()
+void CMouseEvents::DeleteZone(int ZoneId)
 {
-    // Left click drag and drop to add lines to the current zone
-    if(!m_LeftClicked && m_LastLeftClicked)
+    std::lock_guard<std::mutex> Lock(m_StateMutex);
+    if(m_Zones.Find(ZoneId))
     {
-        // Add only those lines whose start and end points are not close enough
-        if(m_P1!=m_P2)
-        {
-            if(m_CurrentLines.size()>0)
-            {
-                // Close the loop if the end point of previous line and the start point of new line are close enough
-                if(m_P1==m_CurrentLines.back().second)
-                {
-                    m_CurrentLines.emplace_back(m_CurrentLines.back().second, m_P2);
-                }
-                else
-                {
-                    m_CurrentLines.emplace_back(m_P1, m_P2);
-                }
-            }
-            else
-            {
-                m_CurrentLines.emplace_back(m_P1, m_P2);
-            }
-
-        }
+        Checkpoint();
+        m_Zones.Erase(ZoneId);
+        m_Journal->Delete(ZoneId);
+        Publish();
     }
-    m_LastLeftClicked = m_LeftClicked;
+}
 
-    // Right click to end adding lines to the current zone
-    if(!m_RightClicked && m_LastRightClicked)
+void CMouseEvents::RenameZone(int ZoneId, const std::string& ZoneName)
+{
+    std::lock_guard<std::mutex> Lock(m_StateMutex);
+    if(const auto* Zone = m_Zones.Find(ZoneId))
     {
-        // Close the loop if the end point of last line and the first point of first line are close enough
-        if(m_CurrentLines.size()>0)
-        {
-            if(m_CurrentLines[0].first==m_CurrentLines.back().second)
-            {
-                m_CurrentLines.back().second = m_CurrentLines[0].first;
-            }
-        }
+        Checkpoint();
+        auto Renamed = *Zone;
+        Renamed.s_ZoneName = ZoneName;
+        m_Zones.Set(ZoneId, Renamed);
+        m_Journal->Rename(ZoneId, ZoneName);
+        Publish();
+    }
+}
 
-        SZone Zone;
-        Zone.s_ZoneId = m_ZoneId++;
-        Zone.s_Lines = m_CurrentLines;
+bool CMouseEvents::Undo()
+{
+    std::lock_guard<std::mutex> Lock(m_StateMutex);
+    return UndoEdit();
+}
 
-        // Print all lines in the current zone
-        WriteConfigXML(std::cout, Zone);
+bool CMouseEvents::Redo()
+{
+    std::lock_guard<std::mutex> Lock(m_StateMutex);
+    return RedoEdit();
+}
 
-        // Add lines in the current zone to all lines
-        m_Zones.emplace(Zone.s_ZoneId, Zone);
+bool CMouseEvents::UndoEdit()
+{
+    if(m_Undo.empty())
+    {
+        return false;
+    }
+    m_Redo.push_back(m_Zones);
+    Restore(m_Undo.back());
+    m_Undo.pop_back();
+    return true;
+}
 
-        // Clear current lines
-        m_CurrentLines.clear();
+bool CMouseEvents::RedoEdit()
+{
+    if(m_Redo.empty())
+    {
+        return false;
     }
-    m_LastRightClicked = m_RightClicked;
+    m_Undo.push_back(m_Zones);
+    Restore(m_Redo.back());
+    m_Redo.pop_back();
+    return true;
+}
 
-    // Left double click to write all zones to the configuration file
-    if(m_LeftDoubleClicked)
+CMouseEvents::ZonesType CMouseEvents::GetZones() const
+{
+    return *std::atomic_load(&m_Published);
+}
+
+void CMouseEvents::Show(const cv::Mat& Frame)
+{
+    Compose(Frame, m_CurrentScaledFrame, m_CurrentZoomFrame);
+    Present(m_CurrentScaledFrame, m_CurrentZoomFrame);
+}
+
+int CMouseEvents::Annotate(const cv::Mat& Image)
+{
+    m_Dirty = true;
+    while(true)
     {
-        m_Ofs = std::ofstream(m_ConfigPath, std::ofstream::out | std::ofstream::trunc);
-        m_Ofs << PreConfigElement << std::endl;
-        m_Ofs << "<Zones>" << std::endl;
-        for(const auto& [ZoneId, Zone] : m_Zones)
+        // The mouse events are queued by waitKey
+        if(m_Dirty || m_Events.Size() > 0)
         {
-            WriteConfigXML(m_Ofs, Zone);
+            Compose(Image, m_CurrentScaledFrame, m_CurrentZoomFrame);
+            if(m_DrawROI)
+            {
+                cv::imshow(m_WinNameZoom, m_CurrentZoomFrame);
+            }
+            cv::imshow(m_WinName, m_CurrentScaledFrame);
+            Presented();
         }
-        m_Ofs << "</Zones>" << std::endl;
-        m_Ofs << PostConfigElement << std::endl;
-        m_Ofs << std::flush;
 
-        PrettyPrint(m_Doc, m_ConfigPath);
+        auto Key = cv::waitKey(m_Delay);
+        if(IsUndoKey(Key) || IsRedoKey(Key))
+        {
+            Post(KeyEvent, Key, 0, 0);
+        }
+        else if(Key != -1)
+        {
+            return Key;
+        }
     }
 }
 
-void CMouseEvents::Update()
+void CMouseEvents::Compose(const cv::Mat& Frame, cv::Mat& Composed, cv::Mat& Zoom)
 {
-    auto ClosestZoneId = m_Zones.empty() ? -1 : m_Zones.cbegin()->first;
-    auto Distance = m_Zones.empty() ? -1 : m_Zones[ClosestZoneId].GetDistance(m_PMousePointer);
-    for(const auto& [ZoneId, Zone] : m_Zones)
+    m_InputTimes.clear();
     {
-        auto NewDistance = Zone.GetDistance(m_PMousePointer);
-        if(NewDistance < Distance)
+        // Other threads may edit the zones or change the scale at the same time
+        std::lock_guard<std::mutex> Lock(m_StateMutex);
+        cv::resize(Frame, Composed, ComposedSize(Frame.size()));
+        HandleEvents();
+        Update();
+
+        // Edits of the handled events are drawn now
+        m_Dirty = false;
+        Draw(Composed);
+        if(m_DrawROI)
         {
-            Distance = NewDistance;
-            ClosestZoneId = ZoneId;
+            DrawROI(Composed, Zoom);
         }
     }
 
-    if(ClosestZoneId != m_ClosestZoneId)
+    std::lock_guard<std::mutex> Lock(m_PendingMutex);
+    if(m_PendingInputCounts.size() == PendingFramesLimit)
     {
-        m_Rotation = 0;
-        m_LastRotation = 0;
+        m_PendingInputTimes.erase(m_PendingInputTimes.begin(), m_PendingInputTimes.begin() + m_PendingInputCounts.front());
+        m_PendingInputCounts.pop_front();
     }
-    m_ClosestZoneId = ClosestZoneId;
+    m_PendingInputTimes.insert(m_PendingInputTimes.end(), m_InputTimes.cbegin(), m_InputTimes.cend());
+    m_PendingInputCounts.push_back(m_InputTimes.size());
+}
 
-    // Update Arrow head of the closest zone
-    if(m_Rotation != m_LastRotation)
+void CMouseEvents::Presented()
+{
+    const auto Now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> Lock(m_PendingMutex);
+    if(m_PendingInputCounts.empty())
+    {
+        return;
+    }
+    for(std::size_t Index = 0; Index < m_PendingInputCounts.front(); ++Index)
     {
-        m_Zones[m_ClosestZoneId].Rotate(m_Rotation-m_LastRotation);
+        m_InputLatency.Add(std::chrono::duration<double, std::milli>(Now - m_PendingInputTimes.front()).count());
+        m_PendingInputTimes.pop_front();
     }
-    m_LastRotation = m_Rotation;
+    m_PendingInputCounts.pop_front();
 }
 
-void CMouseEvents::Draw()
+SLatencyStats CMouseEvents::GetInputLatency() const
 {
-    // Draw mouse pointer
-    MyFilledCircle(m_CurrentScaledFrame, m_ScaledPMousePointer);
+    return m_InputLatency.Stats();
+}
 
-    // Draw point (in green) when holding and moving mouse over the image using left click
-    if(m_LeftClicked)
+void CMouseEvents::ResetInputLatency()
+{
+    m_InputLatency.Reset();
+}
+
+void CMouseEvents::SetLatencyHud(bool Enabled)
+{
+    std::lock_guard<std::mutex> Lock(m_StateMutex);
+    m_LatencyHud = Enabled;
+    m_Dirty = true;
+}
+
+void CMouseEvents::Present(const cv::Mat& Composed, const cv::Mat& Zoom)
+{
+    if(m_DrawROI)
     {
-        MyFilledCircle(m_CurrentScaledFrame, m_ScaledP1);
-        MyFilledCircle(m_CurrentScaledFrame, m_ScaledP2);
-        MyLine(m_CurrentScaledFrame, m_ScaledP1, m_ScaledP2);
-        DrawText(m_CurrentScaledFrame, m_P1, m_ScaledP1);
-        DrawText(m_CurrentScaledFrame, m_P2, m_ScaledP2);
+        cv::imshow(m_WinNameZoom, Zoom);
     }
-
-    // Draw current zone (in green) before right click
-    for(const auto& Line : m_CurrentLines)
+    cv::imshow(m_WinName, Composed);
+    Presented();
+    auto Key = cv::waitKey(m_Delay);
+    if(IsUndoKey(Key) || IsRedoKey(Key))
     {
-        MyLine(m_CurrentScaledFrame, Line.first*m_Scale, Line.second*m_Scale);
-        DrawText(m_CurrentScaledFrame, Line.first, Line.first*m_Scale);
-        DrawText(m_CurrentScaledFrame, Line.second, Line.second*m_Scale);
+        Post(KeyEvent, Key, 0, 0);
     }
+}
 
-    // Draw all saved zones (in blue) after right click.
-    for(const auto& [ZoneId, Zone] : m_Zones)
+void CMouseEvents::Post(int Event, int X, int Y, int Flag)
+{
+    if(!m_Events.Push({Event, X, Y, Flag, std::chrono::steady_clock::now()}))
     {
-        // Draw all lines/zones
-        for(const auto& Line : Zone.s_Lines)
-        {
-            MyLine(m_CurrentScaledFrame, Line.first*m_Scale, Line.second*m_Scale, cv::Scalar(255, 0, 0));
-            DrawText(m_CurrentScaledFrame, Line.first, Line.first*m_Scale);
-            DrawText(m_CurrentScaledFrame, Line.second, Line.second*m_Scale);
-        }
+        m_DroppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-        // Draw all centers
-        auto Center = Zone.GetCenter();
-        MyFilledCircle(m_CurrentScaledFrame, Center*m_Scale);
-        DrawText(m_CurrentScaledFrame, ZoneId, Center*m_Scale);
-        DrawText(m_CurrentScaledFrame, Center, Center*m_Scale + PointType(5, 10));
+void CMouseEvents::SetSnapshotParams(const std::vector<int>& Params)
+{
+    m_SnapshotEncoder.SetParams(Params);
+}
 
-        // Draw all Arrow Head
-        auto ArrowHead = Zone.GetArrowHead();
-        MyFilledCircle(m_CurrentScaledFrame, ArrowHead*m_Scale);
-        MyLine(m_CurrentScaledFrame, Center*m_Scale, ArrowHead*m_Scale, cv::Scalar(255, 0, 0));
-        DrawText(m_CurrentScaledFrame, Zone.s_Angle, ArrowHead*m_Scale);
+void CMouseEvents::SetScale(double Scale)
+{
+    std::lock_guard<std::mutex> Lock(m_StateMutex);
+    m_Dirty = m_Dirty || Scale != m_Scale;
+    m_Scale = Scale;
+    m_ScaledP1 = m_P1*m_Scale;
+    m_ScaledP2 = m_P2*m_Scale;
+    m_ScaledPMousePointer = m_PMousePointer*m_Scale;
+}
+
+cv::Size CMouseEvents::GetComposedSize(const cv::Size& FrameSize) const
+{
+    std::lock_guard<std::mutex> Lock(m_StateMutex);
+    return ComposedSize(FrameSize);
+}
+
+cv::Size CMouseEvents::ComposedSize(const cv::Size& FrameSize) const
+{
+    return cv::Size(cvRound(FrameSize.width*m_Scale), cvRound(FrameSize.height*m_Scale));
+}
+
+void CMouseEvents::HandleEvents()
+{
+    SMouseEvent Event;
+    std::size_t Count{0};
+    std::chrono::steady_clock::time_point Oldest{};
+    while(m_Events.Pop(Event))
+    {
+        Oldest = Count++ == 0 ? Event.s_Time : Oldest;
+        m_InputTimes.push_back(Event.s_Time);
+        HandleEvent(Event);
     }
 
-    // Highligh center closest to mouse pointer
-    if(!m_Zones.empty())
+    if(Count > 0 && EventLog().Enabled(ELogLevel::Debug))
     {
-        auto Center = m_Zones[m_ClosestZoneId].GetCenter();
-        auto ArrowHead = m_Zones[m_ClosestZoneId].GetArrowHead();
-        MyFilledCircle(m_CurrentScaledFrame, Center*m_Scale, cv::Scalar(0, 0, 255));
-        MyLine(m_CurrentScaledFrame, Center*m_Scale, ArrowHead*m_Scale, cv::Scalar(0, 0, 255));
+        auto Delay = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Oldest);
+        EventLog().Log(ELogLevel::Debug, "Handled %zu mouse events, the oldest was queued %.1f ms ago", Count, Delay.count());
     }
 
-    if(m_LeftDoubleClicked)
+    JournalRotations();
+    if(Count > 0)
     {
-        cv::Mat m_Snapshot;
-        cv::resize(m_CurrentScaledFrame, m_Snapshot, cv::Size(m_CurrentScaledFrame.cols/m_Scale, m_CurrentScaledFrame.rows/m_Scale));
-        cv::imwrite(m_SnapPath, m_Snapshot); // write image
+        Publish();
     }
-    m_LeftDoubleClicked = false;
-}
 
-void CMouseEvents::DrawROI()
-{
-    int Radius = 100;
-    int Scale = 2;
-    cv::Mat Src{m_CurrentScaledFrame};
-    cv::Rect ROI1(m_ScaledP1.x-Radius, m_ScaledP1.y-Radius, 2*Radius, 2*Radius);
-    cv::Rect ROI2(m_ScaledP2.x-Radius, m_ScaledP2.y-Radius, 2*Radius, 2*Radius);
-    cv::Rect ROI = ((ROI1 | ROI2) & cv::Rect(0, 0, Src.cols, Src.rows));
-    cv::Mat CroppedImage = Src(ROI);
-    cv::Mat ScaledImage;
-    cv::resize(CroppedImage, ScaledImage, cv::Size(CroppedImage.cols*Scale, CroppedImage.rows*Scale));
-    cv::imshow(m_WinNameZoom, ScaledImage);
+    auto Dropped = m_DroppedEvents.load(std::memory_order_relaxed);
+    if(Dropped != m_ReportedDroppedEvents)
+    {
+        EventLog().Log(ELogLevel::Warning, "Dropped %zu mouse events, the event queue was full", Dropped - m_ReportedDroppedEvents);
+        m_ReportedDroppedEvents = Dropped;
+    }
 }
 
-void CMouseEvents::OnMouse(int Event, int X, int Y, int Flag, void* /*Param*/)
+void CMouseEvents::HandleEvent(const SMouseEvent& Event)
 {
-    m_Flag = static_cast<cv::MouseEventFlags>(Flag);
+    const auto X = Event.s_X;
+    const auto Y = Event.s_Y;
+    m_Flag = static_cast<cv::MouseEventFlags>(Event.s_Flag);
 
-    switch(Event){
+    switch(Event.s_Event){
+
+    case KeyEvent:
+        if(IsUndoKey(X))
+        {
+            UndoEdit();
+        }
+        else if(IsRedoKey(X))
+        {
+            RedoEdit();
+        }
+        break;
 
     case cv::EVENT_LBUTTONDOWN:
         m_LeftClicked = true;
-        m_P1.x=X/m_Scale;
-        m_P1.y=Y/m_Scale;
-        m_P2.x=X/m_Scale;
-        m_P2.y=Y/m_Scale;
+        m_P1.x=cvRound(X/m_Scale);
+        m_P1.y=cvRound(Y/m_Scale);
+        m_P2.x=cvRound(X/m_Scale);
+        m_P2.y=cvRound(Y/m_Scale);
         m_ScaledP1.x = X;
         m_ScaledP1.y = Y;
         m_ScaledP2.x = X;
@@ -413,24 +472,36 @@ void CMouseEvents::OnMouse(int Event, int X, int Y, int Flag, void* /*Param*/)
         break;
 
     case cv::EVENT_LBUTTONUP:
-        m_LeftClicked = false;
-        m_P2.x=X/m_Scale;
-        m_P2.y=Y/m_Scale;
+        m_P2.x=cvRound(X/m_Scale);
+        m_P2.y=cvRound(Y/m_Scale);
         m_ScaledP2.x = X;
         m_ScaledP2.y = Y;
+        // Left click drag and drop to add lines to the current zone
+        if(m_LeftClicked)
+        {
+            m_LeftClicked = false;
+            AddLine();
+        }
         break;
 
     case cv::EVENT_RBUTTONUP:
-        m_RightClicked  = false;
+        // Right click to end adding lines to the current zone
+        if(m_RightClicked)
+        {
+            m_RightClicked = false;
+            AddZone();
+        }
         break;
 
     case cv::EVENT_LBUTTONDBLCLK:
+        // Left double click to write all zones to the configuration file
         m_LeftDoubleClicked = true;
+        Save();
         break;
 
     case cv::EVENT_MOUSEMOVE:
-        m_PMousePointer.x=X/m_Scale;
-        m_PMousePointer.y=Y/m_Scale;
+        m_PMousePointer.x=cvRound(X/m_Scale);
+        m_PMousePointer.y=cvRound(Y/m_Scale);
         m_ScaledPMousePointer.x = X;
         m_ScaledPMousePointer.y = Y;
         if(m_LeftClicked)
@@ -442,27 +513,304 @@ void CMouseEvents::OnMouse(int Event, int X, int Y, int Flag, void* /*Param*/)
 
     case cv::EVENT_MOUSEWHEEL:
     case cv::EVENT_MOUSEHWHEEL:
-        if(cv::getMouseWheelDelta(Flag) > 0)
+    {
+        // Rotate the zone closest to the mouse pointer at the time of the event
+        auto ClosestZoneId = FindClosestZone(m_PMousePointer);
+        if(ClosestZoneId != -1)
         {
-            // Scroll down
-            if(m_ClosestZoneId != -1)
+            // All rotations of a frame are one undo step
+            if(m_RotatedZones.empty())
             {
-                ++m_Rotation;
+                Checkpoint();
             }
-        }
-        else
-        {
-            // Scroll up
-            if(m_ClosestZoneId != -1)
+
+            // Scroll down to increase the angle, scroll up to decrease it
+            auto Zone = *m_Zones.Find(ClosestZoneId);
+            Zone.Rotate(cv::getMouseWheelDelta(Event.s_Flag) > 0 ? 1 : -1);
+            m_Zones.Set(ClosestZoneId, Zone);
+            if(std::find(m_RotatedZones.cbegin(), m_RotatedZones.cend(), ClosestZoneId) == m_RotatedZones.cend())
             {
-                --m_Rotation;
+                m_RotatedZones.push_back(ClosestZoneId);
             }
         }
         break;
+    }
 
     default:
         break;
     }
 }
 
+void CMouseEvents::AddLine()
+{
+    // Add only those lines whose start and end points are not close enough
+    if(m_P1!=m_P2)
+    {
+        if(m_CurrentLines.size()>0)
+        {
+            // Close the loop if the end point of previous line and the start point of new line are close enough
+            if(m_P1==m_CurrentLines.back().second)
+            {
+                m_CurrentLines.emplace_back(m_CurrentLines.back().second, m_P2);
+            }
+            else
+            {
+                m_CurrentLines.emplace_back(m_P1, m_P2);
+            }
+        }
+        else
+        {
+            m_CurrentLines.emplace_back(m_P1, m_P2);
+        }
+
+    }
+}
+
+void CMouseEvents::AddZone()
+{
+    // Close the loop if the end point of last line and the first point of first line are close enough
+    if(m_CurrentLines.size()>0)
+    {
+        if(m_CurrentLines[0].first==m_CurrentLines.back().second)
+        {
+            m_CurrentLines.back().second = m_CurrentLines[0].first;
+        }
+    }
+
+    SZone Zone;
+    Zone.s_ZoneId = m_ZoneId++;
+    Zone.s_Lines = m_CurrentLines;
+
+    // Log all lines in the current zone
+    if(EventLog().Enabled(ELogLevel::Debug))
+    {
+        std::ostringstream Oss;
+        WriteConfigXML(Oss, Zone);
+        EventLog().Write(ELogLevel::Debug, Oss.str());
+    }
+    EventLog().Log(ELogLevel::Info, "Added zone %d with %zu lines", Zone.s_ZoneId, Zone.s_Lines.size());
+
+    // Add lines in the current zone to all lines
+    Checkpoint();
+    Zone.GetArrowHead();
+    m_Zones.Set(Zone.s_ZoneId, Zone);
+    m_Journal->Add(Zone);
+
+    // Clear current lines
+    m_CurrentLines.clear();
+}
+
+void CMouseEvents::Save()
+{
+    // Written through a temporary file, the journal keeps all edits until the configuration is replaced
+    if(!m_Journal->Save(m_Zones, IsBinaryConfigPath(m_ConfigPath) ? nullptr : &m_Doc))
+    {
+        return;
+    }
+
+    // Rotations of this frame are in the configuration file as well
+    m_RotatedZones.clear();
+    EventLog().Log(ELogLevel::Info, "Saved %zu zones to %s", m_Zones.Size(), m_ConfigPath.c_str());
+
+    if(!IsBinaryConfigPath(m_ConfigPath) && EventLog().Enabled(ELogLevel::Debug))
+    {
+        TiXmlPrinter Printer;
+        m_Doc.Accept(&Printer);
+        EventLog().Write(ELogLevel::Debug, Printer.CStr());
+    }
+}
+
+void CMouseEvents::Checkpoint()
+{
+    // The versions share all zones which were not edited in between
+    m_Undo.push_back(m_Zones);
+    if(m_Undo.size() > UndoLimit)
+    {
+        m_Undo.pop_front();
+    }
+    m_Redo.clear();
+    m_Dirty = true;
+}
+
+void CMouseEvents::Restore(const ZonesType& Zones)
+{
+    JournalRotations();
+
+    // Both versions are in id order, a zone which was not edited in between is the same object in both
+    auto Old = m_Zones.cbegin();
+    auto New = Zones.cbegin();
+    while(Old != m_Zones.cend() || New != Zones.cend())
+    {
+        if(New == Zones.cend() || (Old != m_Zones.cend() && Old->first < New->first))
+        {
+            m_Journal->Delete(Old->first);
+            ++Old;
+        }
+        else if(Old == m_Zones.cend() || New->first < Old->first)
+        {
+            m_Journal->Add(New->second);
+            ++New;
+        }
+        else
+        {
+            if(&Old->second != &New->second)
+            {
+                m_Journal->Add(New->second);
+            }
+            ++Old;
+            ++New;
+        }
+    }
+
+    m_Zones = Zones;
+    m_Dirty = true;
+    Publish();
+}
+
+void CMouseEvents::JournalRotations()
+{
+    // Rotations are journaled with their final angle
+    for(auto ZoneId : m_RotatedZones)
+    {
+        if(const auto* Zone = m_Zones.Find(ZoneId))
+        {
+            m_Journal->Rotate(ZoneId, Zone->s_Angle);
+        }
+    }
+    m_RotatedZones.clear();
+}
+
+void CMouseEvents::Publish()
+{
+    std::atomic_store(&m_Published, std::make_shared<const ZonesType>(m_Zones));
+}
+
+bool CMouseEvents::IsUndoKey(int Key)
+{
+    Key &= 0xFF;
+    return Key == 'z' || Key == 26;
+}
+
+bool CMouseEvents::IsRedoKey(int Key)
+{
+    Key &= 0xFF;
+    return Key == 'y' || Key == 25;
+}
+
+int CMouseEvents::FindClosestZone(const PointType& Point)
+{
+    auto ClosestZoneId = m_Zones.Empty() ? -1 : m_Zones.cbegin()->first;
+    auto Distance = m_Zones.Empty() ? -1 : m_Zones.cbegin()->second.GetDistance(Point);
+    for(const auto& [ZoneId, Zone] : m_Zones)
+    {
+        auto NewDistance = Zone.GetDistance(Point);
+        if(NewDistance < Distance)
+        {
+            Distance = NewDistance;
+            ClosestZoneId = ZoneId;
+        }
+    }
+    return ClosestZoneId;
+}
+
+void CMouseEvents::Update()
+{
+    m_ClosestZoneId = FindClosestZone(m_PMousePointer);
+
+    // Fold the journal into the configuration file once it has grown
+    m_Journal->CompactIfNeeded(m_Zones);
+}
+
+void CMouseEvents::Draw(cv::Mat& Img)
+{
+    // Draw mouse pointer
+    MyFilledCircle(Img, m_ScaledPMousePointer);
+
+    // Draw point (in green) when holding and moving mouse over the image using left click
+    if(m_LeftClicked)
+    {
+        MyFilledCircle(Img, m_ScaledP1);
+        MyFilledCircle(Img, m_ScaledP2);
+        MyLine(Img, m_ScaledP1, m_ScaledP2);
+        DrawText(Img, m_P1, m_ScaledP1);
+        DrawText(Img, m_P2, m_ScaledP2);
+    }
+
+    // Draw current zone (in green) before right click
+    for(const auto& Line : m_CurrentLines)
+    {
+        MyLine(Img, Line.first*m_Scale, Line.second*m_Scale);
+        DrawText(Img, Line.first, Line.first*m_Scale);
+        DrawText(Img, Line.second, Line.second*m_Scale);
+    }
+
+    // Draw all saved zones (in blue) after right click.
+    for(const auto& [ZoneId, Zone] : m_Zones)
+    {
+        // Draw all lines/zones
+        for(const auto& Line : Zone.s_Lines)
+        {
+            MyLine(Img, Line.first*m_Scale, Line.second*m_Scale, cv::Scalar(255, 0, 0));
+            DrawText(Img, Line.first, Line.first*m_Scale);
+            DrawText(Img, Line.second, Line.second*m_Scale);
+        }
+
+        // Draw all centers
+        auto Center = Zone.GetCenter();
+        MyFilledCircle(Img, Center*m_Scale);
+        DrawText(Img, ZoneId, Center*m_Scale);
+        DrawText(Img, Center, Center*m_Scale + PointType(5, 10));
+
+        // Draw all Arrow Head
+        auto ArrowHead = Zone.GetArrowHead();
+        MyFilledCircle(Img, ArrowHead*m_Scale);
+        MyLine(Img, Center*m_Scale, ArrowHead*m_Scale, cv::Scalar(255, 0, 0));
+        DrawText(Img, Zone.s_Angle, ArrowHead*m_Scale);
+    }
+
+    // Highligh center closest to mouse pointer
+    if(const auto* ClosestZone = m_Zones.Find(m_ClosestZoneId))
+    {
+        auto Center = ClosestZone->GetCenter();
+        auto ArrowHead = ClosestZone->GetArrowHead();
+        MyFilledCircle(Img, Center*m_Scale, cv::Scalar(0, 0, 255));
+        MyLine(Img, Center*m_Scale, ArrowHead*m_Scale, cv::Scalar(0, 0, 255));
+    }
+
+    if(m_LatencyHud)
+    {
+        const auto Latency = m_InputLatency.Stats();
+        std::ostringstream HUD;
+        HUD << std::fixed << std::setprecision(1) << "Input latency p50 " << Latency.s_P50Ms << " p95 " << Latency.s_P95Ms << " p99 " << Latency.s_P99Ms << " ms";
+        DrawText(Img, HUD.str(), PointType(5, 15), cv::Scalar(0, 255, 255));
+    }
+
+    if(m_LeftDoubleClicked)
+    {
+        // The resized snapshot is a fresh buffer owned by the encoder, the frame can be reused right away
+        cv::Mat Snapshot;
+        cv::resize(Img, Snapshot, cv::Size(cvRound(Img.cols/m_Scale), cvRound(Img.rows/m_Scale)));
+        m_SnapshotEncoder.Submit(m_SnapPath, Snapshot); // write image in the background
+    }
+    m_LeftDoubleClicked = false;
+}
+
+void CMouseEvents::DrawROI(const cv::Mat& Img, cv::Mat& Zoom)
+{
+    int Radius = 100;
+    int Scale = 2;
+    const cv::Mat& Src{Img};
+    cv::Rect ROI1(m_ScaledP1.x-Radius, m_ScaledP1.y-Radius, 2*Radius, 2*Radius);
+    cv::Rect ROI2(m_ScaledP2.x-Radius, m_ScaledP2.y-Radius, 2*Radius, 2*Radius);
+    cv::Rect ROI = ((ROI1 | ROI2) & cv::Rect(0, 0, Src.cols, Src.rows));
+    cv::Mat CroppedImage = Src(ROI);
+    cv::resize(CroppedImage, Zoom, cv::Size(CroppedImage.cols*Scale, CroppedImage.rows*Scale));
+}
+
+void CMouseEvents::OnMouse(int Event, int X, int Y, int Flag, void* Param)
+{
+    // Only queue the event, it is handled by Show (in order, with all others since the last frame)
+    static_cast<CMouseEvents*>(Param)->Post(Event, X, Y, Flag);
+}
+
 }
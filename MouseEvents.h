@@ -1,14 +1,23 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <vector>
 
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "LatencyHistogram.h"
+#include "PersistentMap.h"
+#include "SnapshotEncoder.h"
+#include "SpscQueue.h"
 #include "TinyXml/tinyxml.h"
 
 namespace mouseevents
@@ -27,6 +36,8 @@ void MyLine(cv::Mat& Img, const cv::Point& Start, const cv::Point& End, cv::Scal
 template<typename T>
 void DrawText(cv::Mat& Img, const T& Data, const cv::Point& Location, cv::Scalar Color = cv::Scalar(0, 0, 0));
 
+class CZoneJournal;
+
 class CMouseEvents
 {
 public:
@@ -49,57 +60,196 @@ public:
         int s_Angle{0};
     };
 
+    // Every edit makes a new version of the zones, a copy is an O(1) snapshot which never changes
+    using ZonesType = CPersistentMap<int /*Zone Id*/, SZone>;
+
+    // A key pressed in the window, posted as an event with the key in s_X
+    static constexpr int KeyEvent{-2};
+
+    // A mouse event as received by the window callback
+    struct SMouseEvent
+    {
+        int s_Event{-1}; // cv::MouseEventTypes or KeyEvent
+        int s_X{0};
+        int s_Y{0};
+        int s_Flag{0};
+        std::chrono::steady_clock::time_point s_Time{};
+    };
+
     CMouseEvents();
 
-    CMouseEvents(const std::string& WinName, const std::string& ConfigPath, const std::string& SnapPath, bool DrawRoI);
+    // Without a window of its own the mouse events have to be posted, e.g. by a CMosaic
+    CMouseEvents(const std::string& WinName, const std::string& ConfigPath, const std::string& SnapPath, bool DrawRoI, bool OwnWindow = true);
+
+    ~CMouseEvents();
 
+    // The mouse callback of the window refers to this object
+    CMouseEvents(const CMouseEvents&) = delete;
+    CMouseEvents& operator=(const CMouseEvents&) = delete;
+
+    // The zones can be edited from any thread, also while another thread composes frames (the edit waits for the
+    // frame being composed). Replace all zones, the undo history is cleared.
     void SetConfigZones(const std::map<int, SZone>& Zones);
 
-    // Show the current frame
+    // Delete a zone
+    void DeleteZone(int ZoneId);
+
+    // Rename a zone
+    void RenameZone(int ZoneId, const std::string& ZoneName);
+
+    // Go back to the zones before the last edit, or forward again. Returns false if there is nothing to undo or redo.
+    // Also bound to the keys z and y (or Ctrl+Z and Ctrl+Y) of the window.
+    bool Undo();
+    bool Redo();
+
+    // Whether a key is bound to Undo or Redo
+    static bool IsUndoKey(int Key);
+    static bool IsRedoKey(int Key);
+
+    // The zones as of the last handled event, can be called from any thread. The snapshot is not copied and
+    // does not change, it can be kept as long as needed.
+    ZonesType GetZones() const;
+
+    // Show the current frame (Compose and Present)
     void Show(const cv::Mat& Frame);
 
+    // Show a still image until a key is pressed, returns the key. The image is only redrawn when a mouse event
+    // arrives or the zones change, otherwise the thread sleeps in waitKey.
+    int Annotate(const cv::Mat& Image);
+
+    // Handle the mouse events and draw the zones onto a scaled copy of the frame, and the zoomed region if enabled.
+    // Composed and Zoom are reused if they have the right size. Can run on another thread than Present (one at a time).
+    void Compose(const cv::Mat& Frame, cv::Mat& Composed, cv::Mat& Zoom);
+
+    // Show a composed frame and wait for the frame delay, the mouse callback runs here. Must run on the GUI thread.
+    // Undo and redo keys are posted as events.
+    void Present(const cv::Mat& Composed, const cv::Mat& Zoom);
+
+    // The oldest composed frame which is not shown yet was handed to imshow, the latencies of the events it reflects
+    // are recorded. Called by Present, a caller which shows composed frames itself has to call it once per frame.
+    void Presented();
+
+    // Percentiles of the time from an event in the window callback until the first frame reflecting it was handed
+    // to imshow. Can be called from any thread.
+    SLatencyStats GetInputLatency() const;
+    void ResetInputLatency();
+
+    // Draw the input latency onto the composed frames, can be called from any thread
+    void SetLatencyHud(bool Enabled);
+
+    // Queue a mouse (or key) event in the coordinates of the composed frame, it is handled by the next Compose.
+    // Only one thread may post, the window callback does if the object owns its window.
+    void Post(int Event, int X, int Y, int Flag);
+
+    // Encoder parameters of the double-click snapshots as cv::imwrite flags, e.g. {cv::IMWRITE_JPEG_QUALITY, 80}.
+    // The format follows the extension of the snapshot path, by default it is written in high quality.
+    void SetSnapshotParams(const std::vector<int>& Params);
+
+    // Scale of the composed frame relative to the captured one, zones are kept in the coordinates of the captured frame.
+    // Can be called from any thread.
+    void SetScale(double Scale);
+
+    // Size of the frame composed from a captured frame of the given size
+    cv::Size GetComposedSize(const cv::Size& FrameSize) const;
+
 private:
-    // Add lines to the vector of lines
-    void AddLines();
+    // Undo, Redo and GetComposedSize with m_StateMutex held
+    bool UndoEdit();
+    bool RedoEdit();
+    cv::Size ComposedSize(const cv::Size& FrameSize) const;
+
+    // Handle all mouse events received since the last frame, in order
+    void HandleEvents();
+
+    void HandleEvent(const SMouseEvent& Event);
+
+    // Add the line of the last left click drag and drop to the current zone
+    void AddLine();
+
+    // Add the current zone to all zones
+    void AddZone();
+
+    // Write all zones to the configuration file
+    void Save();
+
+    // Keep the current zones as an undo step before they are edited
+    void Checkpoint();
+
+    // Switch to another version of the zones, the difference is journaled
+    void Restore(const ZonesType& Zones);
+
+    // Journal the rotations since the last call with their final angle
+    void JournalRotations();
+
+    // Make the current zones visible to GetZones
+    void Publish();
+
+    // Zone closest to a point, -1 if there are no zones
+    int FindClosestZone(const PointType& Point);
 
     // Update zones
     void Update();
 
     // Draw lines on the current frame
-    void Draw();
+    void Draw(cv::Mat& Img);
 
-    // Zoom the image around the points in another window
-    void DrawROI();
+    // Zoom the image around the points
+    void DrawROI(const cv::Mat& Img, cv::Mat& Zoom);
 
-    // Mouse events related (static members used in the Callback function for mouse events)
+    // Mouse events related (the callback queues the events of the window, Param is the CMouseEvents object)
     static void OnMouse(int Event, int X, int Y, int Flag, void* Param);
 
-    // Store mouse actions between OnMouse callbacks
-    static PointType m_P1, m_P2, m_PMousePointer, m_ScaledP1, m_ScaledP2, m_ScaledPMousePointer;
-    static int m_ClosestZoneId, m_Rotation;
-    static bool m_LeftClicked;
-    static bool m_RightClicked;
-    static bool m_LeftDoubleClicked;
-    static cv::MouseEventFlags m_Flag;
-    int m_LastRotation{};
-    bool m_LastLeftClicked{false};
-    bool m_LastRightClicked{false};
+    // Events from the window callback to Show, the callback may run on the GUI thread of the HighGUI backend
+    static constexpr std::size_t EventQueueSize{1024};
+    CSpscQueue<SMouseEvent, EventQueueSize> m_Events;
+    std::atomic<std::size_t> m_DroppedEvents{0};
+    std::size_t m_ReportedDroppedEvents{0};
+
+    // Input latency, the times of the events of composed frames wait here until the frames are presented
+    static constexpr std::size_t PendingFramesLimit{8}; // frames which are composed but never presented are dropped
+    std::vector<std::chrono::steady_clock::time_point> m_InputTimes; // events of the frame being composed
+    std::deque<std::chrono::steady_clock::time_point> m_PendingInputTimes;
+    std::deque<std::size_t> m_PendingInputCounts; // events per composed frame, oldest first
+    std::mutex m_PendingMutex;
+    CLatencyHistogram m_InputLatency;
+    bool m_LatencyHud{false};
+
+    // Held while the zones, the mouse state and the scale are used: by Compose, and by the public methods which
+    // change them from other threads
+    mutable std::mutex m_StateMutex;
+
+    // Mouse state as of the last handled event
+    PointType m_P1{}, m_P2{}, m_PMousePointer{}, m_ScaledP1{}, m_ScaledP2{}, m_ScaledPMousePointer{};
+    int m_ClosestZoneId{-1};
+    bool m_LeftClicked{false};
+    bool m_RightClicked{false};
+    bool m_LeftDoubleClicked{false};
+    cv::MouseEventFlags m_Flag{cv::MouseEventFlags::EVENT_FLAG_LBUTTON};
 
     // Display related
-    static const int m_Scale{1};
+    double m_Scale{1.0};
     const std::string m_WinName{};
     const std::string m_WinNameZoom{};
     const std::string m_ConfigPath{};
     const std::string m_SnapPath{};
+    CSnapshotEncoder m_SnapshotEncoder;
     cv::Mat m_CurrentScaledFrame;
+    cv::Mat m_CurrentZoomFrame;
     int m_Delay{33}; // delay in ms, corresponds to 30 FPS
     const bool m_DrawROI{false};
+    const bool m_OwnWindow{true};
+    std::atomic<bool> m_Dirty{true}; // the zones changed since the last Compose
 
     // Zone lines related
     int m_ZoneId{1};
     LinesType m_CurrentLines;
-    std::map<int /*Zone Id*/, SZone> m_Zones;
-    std::ofstream m_Ofs;
+    ZonesType m_Zones;
+    std::shared_ptr<const ZonesType> m_Published; // read and written with std::atomic_load and std::atomic_store
+    static constexpr std::size_t UndoLimit{256};
+    std::deque<ZonesType> m_Undo;
+    std::vector<ZonesType> m_Redo;
+    std::vector<int> m_RotatedZones; // journaled once per frame
+    std::unique_ptr<CZoneJournal> m_Journal;
     TiXmlDocument m_Doc{};
 };
 
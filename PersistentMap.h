@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace mouseevents
+{
+
+// Ordered map whose versions share their unchanged nodes (a persistent AVL tree). Copying a map is O(1) and the
+// copy never changes, Set and Erase copy only the O(log n) nodes on the path to the key. The nodes are immutable,
+// so copies can be read by other threads while the original is being changed. The values are never copied by an
+// edit: a value is shared by all versions until it is replaced, and keeps its address.
+template<typename K, typename V>
+class CPersistentMap
+{
+    struct SNode;
+    using NodePtr = std::shared_ptr<const SNode>;
+
+public:
+    using value_type = std::pair<const K, V>;
+
+    // In-order iterator, valid as long as a version containing the item is alive
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = CPersistentMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return *m_Path.back()->s_Item; }
+        pointer operator->() const { return m_Path.back()->s_Item.get(); }
+
+        const_iterator& operator++()
+        {
+            const SNode* Node = m_Path.back();
+            m_Path.pop_back();
+            PushLeft(Node->s_Right.get());
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            auto It = *this;
+            ++*this;
+            return It;
+        }
+
+        bool operator==(const const_iterator& Other) const { return Current() == Other.Current(); }
+        bool operator!=(const const_iterator& Other) const { return !(*this == Other); }
+
+    private:
+        friend class CPersistentMap;
+
+        explicit const_iterator(const SNode* Root) { PushLeft(Root); }
+
+        void PushLeft(const SNode* Node)
+        {
+            for(; Node; Node = Node->s_Left.get())
+            {
+                m_Path.push_back(Node);
+            }
+        }
+
+        const SNode* Current() const { return m_Path.empty() ? nullptr : m_Path.back(); }
+
+        std::vector<const SNode*> m_Path; // the current node and its ancestors whose right subtree is still to come
+    };
+
+    CPersistentMap() = default;
+
+    template<typename InputIt>
+    CPersistentMap(InputIt First, InputIt Last)
+    {
+        for(; First != Last; ++First)
+        {
+            Set(First->first, First->second);
+        }
+    }
+
+    std::size_t Size() const { return m_Size; }
+    bool Empty() const { return m_Size == 0; }
+
+    // The value of a key, nullptr if there is none
+    const V* Find(const K& Key) const
+    {
+        for(const SNode* Node = m_Root.get(); Node;)
+        {
+            if(Key < Node->s_Item->first)
+            {
+                Node = Node->s_Left.get();
+            }
+            else if(Node->s_Item->first < Key)
+            {
+                Node = Node->s_Right.get();
+            }
+            else
+            {
+                return &Node->s_Item->second;
+            }
+        }
+        return nullptr;
+    }
+
+    // The item with the largest key, nullptr if the map is empty
+    const value_type* Last() const
+    {
+        const SNode* Node = m_Root.get();
+        for(; Node && Node->s_Right; Node = Node->s_Right.get())
+        {
+        }
+        return Node ? Node->s_Item.get() : nullptr;
+    }
+
+    // Insert or replace the value of a key
+    void Set(const K& Key, V Value)
+    {
+        bool Added{false};
+        m_Root = Insert(m_Root, std::make_shared<const value_type>(Key, std::move(Value)), Added);
+        m_Size += Added ? 1 : 0;
+    }
+
+    // Returns false if there was no such key
+    bool Erase(const K& Key)
+    {
+        bool Erased{false};
+        m_Root = Remove(m_Root, Key, Erased);
+        m_Size -= Erased ? 1 : 0;
+        return Erased;
+    }
+
+    const_iterator begin() const { return const_iterator(m_Root.get()); }
+    const_iterator end() const { return const_iterator(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+private:
+    using ItemPtr = std::shared_ptr<const value_type>;
+
+    struct SNode
+    {
+        SNode(ItemPtr Item, NodePtr Left, NodePtr Right)
+            : s_Item{std::move(Item)}
+            , s_Left{std::move(Left)}
+            , s_Right{std::move(Right)}
+            , s_Height{1 + std::max(Height(s_Left), Height(s_Right))}
+        {
+        }
+
+        ItemPtr s_Item;
+        NodePtr s_Left;
+        NodePtr s_Right;
+        int s_Height{1};
+    };
+
+    static int Height(const NodePtr& Node) { return Node ? Node->s_Height : 0; }
+
+    static NodePtr Make(ItemPtr Item, NodePtr Left, NodePtr Right)
+    {
+        return std::make_shared<const SNode>(std::move(Item), std::move(Left), std::move(Right));
+    }
+
+    // A new node for Item whose subtrees differ in height by at most 2, rotated to differ by at most 1
+    static NodePtr Balance(ItemPtr Item, NodePtr Left, NodePtr Right)
+    {
+        if(Height(Left) > Height(Right) + 1)
+        {
+            if(Height(Left->s_Left) >= Height(Left->s_Right))
+            {
+                return Make(Left->s_Item, Left->s_Left, Make(std::move(Item), Left->s_Right, std::move(Right)));
+            }
+            const auto& Middle = Left->s_Right;
+            return Make(Middle->s_Item, Make(Left->s_Item, Left->s_Left, Middle->s_Left), Make(std::move(Item), Middle->s_Right, std::move(Right)));
+        }
+        if(Height(Right) > Height(Left) + 1)
+        {
+            if(Height(Right->s_Right) >= Height(Right->s_Left))
+            {
+                return Make(Right->s_Item, Make(std::move(Item), std::move(Left), Right->s_Left), Right->s_Right);
+            }
+            const auto& Middle = Right->s_Left;
+            return Make(Middle->s_Item, Make(std::move(Item), std::move(Left), Middle->s_Left), Make(Right->s_Item, Middle->s_Right, Right->s_Right));
+        }
+        return Make(std::move(Item), std::move(Left), std::move(Right));
+    }
+
+    static NodePtr Insert(const NodePtr& Node, ItemPtr Item, bool& Added)
+    {
+        if(!Node)
+        {
+            Added = true;
+            return Make(std::move(Item), nullptr, nullptr);
+        }
+        if(Item->first < Node->s_Item->first)
+        {
+            return Balance(Node->s_Item, Insert(Node->s_Left, std::move(Item), Added), Node->s_Right);
+        }
+        if(Node->s_Item->first < Item->first)
+        {
+            return Balance(Node->s_Item, Node->s_Left, Insert(Node->s_Right, std::move(Item), Added));
+        }
+        return Make(std::move(Item), Node->s_Left, Node->s_Right);
+    }
+
+    // Nothing is copied if the key is not found
+    static NodePtr Remove(const NodePtr& Node, const K& Key, bool& Erased)
+    {
+        if(!Node)
+        {
+            return Node;
+        }
+        if(Key < Node->s_Item->first)
+        {
+            auto Left = Remove(Node->s_Left, Key, Erased);
+            return Erased ? Balance(Node->s_Item, std::move(Left), Node->s_Right) : Node;
+        }
+        if(Node->s_Item->first < Key)
+        {
+            auto Right = Remove(Node->s_Right, Key, Erased);
+            return Erased ? Balance(Node->s_Item, Node->s_Left, std::move(Right)) : Node;
+        }
+
+        Erased = true;
+        if(!Node->s_Left || !Node->s_Right)
+        {
+            return Node->s_Left ? Node->s_Left : Node->s_Right;
+        }
+
+        // Replaced by the smallest item of the right subtree
+        const SNode* Smallest = Node->s_Right.get();
+        for(; Smallest->s_Left; Smallest = Smallest->s_Left.get())
+        {
+        }
+        return Balance(Smallest->s_Item, Node->s_Left, RemoveFirst(Node->s_Right));
+    }
+
+    static NodePtr RemoveFirst(const NodePtr& Node)
+    {
+        if(!Node->s_Left)
+        {
+            return Node->s_Right;
+        }
+        return Balance(Node->s_Item, RemoveFirst(Node->s_Left), Node->s_Right);
+    }
+
+    NodePtr m_Root;
+    std::size_t m_Size{0};
+};
+
+}
@@ -0,0 +1,127 @@
+#include "SnapshotEncoder.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "EventLog.h"
+
+namespace mouseevents
+{
+
+std::vector<int> GetDefaultSnapshotParams(const std::string& FileName)
+{
+    const auto Dot = FileName.find_last_of('.');
+    auto Extension = Dot == std::string::npos ? std::string{} : FileName.substr(Dot + 1);
+    std::transform(Extension.begin(), Extension.end(), Extension.begin(), [](unsigned char C) { return static_cast<char>(std::tolower(C)); });
+    if(Extension == "jpg" || Extension == "jpeg" || Extension == "jpe")
+    {
+        return {cv::IMWRITE_JPEG_QUALITY, 95};
+    }
+    if(Extension == "png")
+    {
+        return {cv::IMWRITE_PNG_COMPRESSION, 3};
+    }
+    if(Extension == "webp")
+    {
+        return {cv::IMWRITE_WEBP_QUALITY, 95};
+    }
+    return {};
+}
+
+CSnapshotEncoder::CSnapshotEncoder(const std::vector<int>& Params, std::size_t Capacity)
+    : m_Capacity{std::max<std::size_t>(Capacity, 1)}
+    , m_Params{Params}
+    , m_Worker{&CSnapshotEncoder::Run, this}
+{
+}
+
+CSnapshotEncoder::~CSnapshotEncoder()
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Pending.notify_one();
+    m_Worker.join();
+}
+
+void CSnapshotEncoder::Submit(const std::string& FileName, const cv::Mat& Frame)
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        auto It = std::find_if(m_Queue.begin(), m_Queue.end(), [&FileName](const SRequest& Request) { return Request.s_FileName == FileName; });
+        if(It != m_Queue.end())
+        {
+            // Only the latest frame of a path ends up on disk anyway
+            It->s_Frame = Frame;
+            It->s_Params = m_Params;
+            ++m_Dropped;
+            return;
+        }
+        if(m_Queue.size() >= m_Capacity)
+        {
+            m_Queue.pop_front();
+            ++m_Dropped;
+        }
+        m_Queue.push_back({FileName, Frame, m_Params});
+    }
+    m_Pending.notify_one();
+}
+
+void CSnapshotEncoder::SetParams(const std::vector<int>& Params)
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    m_Params = Params;
+}
+
+void CSnapshotEncoder::Flush()
+{
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    m_Idle.wait(Lock, [this]() { return m_Queue.empty() && !m_Busy; });
+}
+
+std::size_t CSnapshotEncoder::Dropped() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_Dropped;
+}
+
+void CSnapshotEncoder::Run()
+{
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    while(true)
+    {
+        m_Pending.wait(Lock, [this]() { return m_Stop || !m_Queue.empty(); });
+        if(m_Queue.empty())
+        {
+            // Stop requested and everything written
+            return;
+        }
+
+        auto Request = std::move(m_Queue.front());
+        m_Queue.pop_front();
+        m_Busy = true;
+        Lock.unlock();
+
+        try
+        {
+            if(!cv::imwrite(Request.s_FileName, Request.s_Frame, Request.s_Params))
+            {
+                EventLog().Log(ELogLevel::Error, "Could not write snapshot %s", Request.s_FileName.c_str());
+            }
+        }
+        catch(const cv::Exception& Ex)
+        {
+            EventLog().Log(ELogLevel::Error, "Could not write snapshot %s: %s", Request.s_FileName.c_str(), Ex.what());
+        }
+
+        Lock.lock();
+        m_Busy = false;
+        if(m_Queue.empty())
+        {
+            m_Idle.notify_all();
+        }
+    }
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+namespace mouseevents
+{
+
+// High quality encoder parameters for the format of a file name: JPEG quality 95, PNG compression 3 or WebP
+// quality 95, none for other formats
+std::vector<int> GetDefaultSnapshotParams(const std::string& FileName);
+
+// Encodes and writes snapshots on a worker thread so that the display loop never waits for the disk.
+// The image format follows the file extension (as for cv::imwrite), the encoder parameters are
+// cv::imwrite flags, e.g. {cv::IMWRITE_JPEG_QUALITY, 90}.
+class CSnapshotEncoder
+{
+public:
+    CSnapshotEncoder(const std::vector<int>& Params = {cv::IMWRITE_JPEG_QUALITY, 95}, std::size_t Capacity = 2);
+
+    ~CSnapshotEncoder();
+
+    CSnapshotEncoder(const CSnapshotEncoder&) = delete;
+    CSnapshotEncoder& operator=(const CSnapshotEncoder&) = delete;
+
+    // Queue a frame for writing, never blocks. The frame is shared (not copied), the caller must not write to it afterwards.
+    // A pending request for the same path is replaced by the newer frame, if the queue is full the oldest request is dropped.
+    void Submit(const std::string& FileName, const cv::Mat& Frame);
+
+    // Change the encoder parameters of all following snapshots
+    void SetParams(const std::vector<int>& Params);
+
+    // Block until all queued snapshots are written
+    void Flush();
+
+    // Number of requests which were coalesced or dropped because the worker was busy
+    std::size_t Dropped() const;
+
+private:
+    struct SRequest
+    {
+        std::string s_FileName;
+        cv::Mat s_Frame;
+        std::vector<int> s_Params;
+    };
+
+    void Run();
+
+    const std::size_t m_Capacity{2};
+    std::vector<int> m_Params;
+    std::deque<SRequest> m_Queue;
+    std::size_t m_Dropped{0};
+    bool m_Busy{false};
+    bool m_Stop{false};
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Pending;
+    std::condition_variable m_Idle;
+    std::thread m_Worker;
+};
+
+}
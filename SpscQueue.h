@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace mouseevents
+{
+
+// Lock-free bounded queue for exactly one producer thread and one consumer thread.
+// Push and Pop never block or allocate, the items are copied in and out of a fixed ring.
+template<typename T, std::size_t Capacity>
+class CSpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "the capacity must be a power of two");
+
+public:
+    CSpscQueue() = default;
+
+    CSpscQueue(const CSpscQueue&) = delete;
+    CSpscQueue& operator=(const CSpscQueue&) = delete;
+
+    // Producer only. Returns false (and the item is not queued) if the queue is full.
+    bool Push(const T& Item)
+    {
+        const auto Tail = m_Tail.load(std::memory_order_relaxed);
+        if(Tail - m_Head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+        m_Items[Tail & (Capacity - 1)] = Item;
+        m_Tail.store(Tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false if the queue is empty.
+    bool Pop(T& Item)
+    {
+        const auto Head = m_Head.load(std::memory_order_relaxed);
+        if(Head == m_Tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        Item = m_Items[Head & (Capacity - 1)];
+        m_Head.store(Head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of queued items, only a snapshot if the other side is active
+    std::size_t Size() const { return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire); }
+
+private:
+    std::array<T, Capacity> m_Items{};
+    alignas(64) std::atomic<std::size_t> m_Head{0}; // next item to pop, written by the consumer
+    alignas(64) std::atomic<std::size_t> m_Tail{0}; // next free slot, written by the producer
+};
+
+}
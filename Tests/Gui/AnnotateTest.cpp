@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../../MouseEvents.h"
+#include "../TestCheck.h"
+#include "HighGuiStub.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+// A still image is drawn once, then again only for a mouse event or a change of the zones or the scale. Every
+// edit is drawn by one redraw, and the thread sleeps in waitKey in between.
+void TestRedraws(const std::filesystem::path& Directory)
+{
+    CMouseEvents Events("Annotate", (Directory / "Zones.xml").string(), (Directory / "Zones.jpg").string(), false);
+    const cv::Mat Image(cv::Size(160, 120), CV_8UC3, cv::Scalar(10, 20, 30));
+
+    int Shown{0};
+    cv::Size ShownSize;
+    SetImshowHandler([&](const std::string& WinName, const cv::Mat& Frame)
+    {
+        TEST_CHECK(WinName == "Annotate");
+        ++Shown;
+        ShownSize = Frame.size();
+    });
+
+    // Each step is played in one waitKey, with the number of frames shown before it
+    struct SStep
+    {
+        int s_Shown;
+        std::function<int()> s_Action;
+    };
+    const std::vector<SStep> Steps{
+        {1, []() { return -1; }},
+        {1, []() { return -1; }},
+        {1, []() { SendMouseEvent("Annotate", cv::EVENT_MOUSEMOVE, 10, 10, 0); return -1; }},
+        {2, []()
+        {
+            // A zone of one line, added by one redraw
+            SendMouseEvent("Annotate", cv::EVENT_LBUTTONDOWN, 20, 20, cv::EVENT_FLAG_LBUTTON);
+            SendMouseEvent("Annotate", cv::EVENT_MOUSEMOVE, 100, 20, cv::EVENT_FLAG_LBUTTON);
+            SendMouseEvent("Annotate", cv::EVENT_LBUTTONUP, 100, 20, 0);
+            SendMouseEvent("Annotate", cv::EVENT_RBUTTONDOWN, 60, 60, cv::EVENT_FLAG_RBUTTON);
+            SendMouseEvent("Annotate", cv::EVENT_RBUTTONUP, 60, 60, 0);
+            return -1;
+        }},
+        {3, []() { return -1; }},
+        {3, [&Events]() { Events.SetScale(1.0); return -1; }},
+        {3, [&Events]() { Events.SetScale(0.5); return -1; }},
+        {4, [&Events]() { Events.RenameZone(1, "Gate"); return -1; }},
+        {5, []() { return static_cast<int>('z'); }},
+        {6, [&Events]() { Events.DeleteZone(42); return -1; }},
+        {6, []() { return static_cast<int>('q'); }}};
+
+    std::size_t Step{0};
+    SetWaitKeyHandler([&](int Delay)
+    {
+        TEST_CHECK(Delay > 0);
+        if(Step == Steps.size())
+        {
+            return 27;
+        }
+        const bool Expected = Shown == Steps[Step].s_Shown;
+        if(!Expected)
+        {
+            std::fprintf(stderr, "%d frames shown before step %zu, expected %d\n", Shown, Step, Steps[Step].s_Shown);
+        }
+        TEST_CHECK(Expected);
+        return Steps[Step++].s_Action();
+    });
+    TEST_CHECK(Events.Annotate(Image) == 'q');
+    SetImshowHandler(nullptr);
+    SetWaitKeyHandler(nullptr);
+
+    TEST_CHECK(Step == Steps.size() && Shown == 6 && ShownSize == cv::Size(80, 60));
+    const auto Zones = Events.GetZones();
+    TEST_CHECK(Zones.Size() == 1 && Zones.Find(1) && Zones.Find(1)->s_ZoneName == "Default" && Zones.Find(1)->s_Lines.size() == 1);
+}
+
+}
+
+int main()
+{
+    const auto Directory = std::filesystem::temp_directory_path() / "AnnotateTest";
+    std::filesystem::remove_all(Directory);
+    std::filesystem::create_directories(Directory);
+
+    TestRedraws(Directory);
+    return TestFailures();
+}
@@ -0,0 +1,179 @@
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "../../FrameGrabber.h"
+#include "../../FramePipeline.h"
+#include "../../MouseEvents.h"
+#include "../TestCheck.h"
+#include "HighGuiStub.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+const int FrameCount{40};
+
+// A video as a sequence of images, the frame number is in the blue channel of every pixel
+std::string WriteVideo(const std::filesystem::path& Directory)
+{
+    for(int Frame = 0; Frame < FrameCount; ++Frame)
+    {
+        const cv::Mat Image(cv::Size(64, 48), CV_8UC3, cv::Scalar(5*Frame, 255 - 5*Frame, 100));
+        TEST_CHECK(cv::imwrite((Directory / ("Frame" + std::to_string(100 + Frame).substr(1) + ".png")).string(), Image));
+    }
+    return (Directory / "Frame%02d.png").string();
+}
+
+// The number of a shown frame, read far from the mouse pointer which is drawn at the top left
+int FrameNumber(const cv::Mat& Frame)
+{
+    return Frame.at<cv::Vec3b>(Frame.rows/2, Frame.cols/2)[0]/5;
+}
+
+std::vector<int> FirstFrames(int Count)
+{
+    std::vector<int> Frames;
+    for(int Frame = 0; Frame < Count; ++Frame)
+    {
+        Frames.push_back(Frame);
+    }
+    return Frames;
+}
+
+// Buffers go back to the pool up to its capacity and come out again, an empty pool gives empty frames
+void TestPool()
+{
+    CFramePool Pool(2);
+    cv::Mat Frame;
+    Pool.Acquire(Frame);
+    TEST_CHECK(Frame.empty());
+
+    std::set<const unsigned char*> Released;
+    for(int Index = 0; Index < 3; ++Index)
+    {
+        cv::Mat Buffer(cv::Size(16, 16), CV_8UC3, cv::Scalar(0, 0, 0));
+        Released.insert(Buffer.data);
+        Pool.Release(Buffer);
+        TEST_CHECK(Buffer.empty());
+
+        // An empty frame takes no place in the pool
+        cv::Mat Empty;
+        Pool.Release(Empty);
+    }
+
+    // Two buffers were kept, the third was freed (the test holds none of them)
+    std::set<const unsigned char*> Acquired;
+    for(int Buffer = 0; Buffer < 2; ++Buffer)
+    {
+        Pool.Acquire(Frame);
+        TEST_CHECK(!Frame.empty() && Frame.size() == cv::Size(16, 16));
+        Acquired.insert(Frame.data);
+    }
+    TEST_CHECK(Acquired.size() == 2);
+    for(const auto* Data : Acquired)
+    {
+        TEST_CHECK(Released.count(Data) == 1);
+    }
+    Pool.Acquire(Frame);
+    TEST_CHECK(Frame.empty());
+}
+
+// Every frame of the video is composed and shown once and in order. The present queue fills up while the display
+// is slow but never holds more than QueueSize frames, and the composed frames reuse a bounded set of buffers.
+void TestPipeline(const std::filesystem::path& Directory, const std::string& Video, std::size_t QueueSize)
+{
+    CMouseEvents Events("Pipeline", (Directory / "Zones.xml").string(), (Directory / "Zones.jpg").string(), false);
+    CFrameGrabber Grabber(2, EFramePolicy::Block);
+    TEST_CHECK(Grabber.Open(Video, false));
+    CFramePipeline Pipeline(Events, Grabber, QueueSize);
+
+    // The shown frames are kept, so that a buffer which is not reused cannot come back from the allocator
+    std::vector<int> Shown;
+    std::vector<cv::Mat> Kept;
+    std::set<const unsigned char*> Buffers;
+    SetImshowHandler([&](const std::string& WinName, const cv::Mat& Frame)
+    {
+        TEST_CHECK(WinName == "Pipeline" && Frame.size() == cv::Size(64, 48));
+        Shown.push_back(FrameNumber(Frame));
+        Kept.push_back(Frame);
+        Buffers.insert(Frame.data);
+    });
+    // A display which is slow for five frames and fast for the next five: the queue fills up, then the pool
+    SetWaitKeyHandler([&Shown](int Delay)
+    {
+        if(Delay > 1 && Shown.size()/5 % 2 == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return -1;
+    });
+    Pipeline.Run();
+
+    TEST_CHECK(Shown == FirstFrames(FrameCount));
+    const auto Stats = Pipeline.Stats();
+    TEST_CHECK(Stats.s_Capture.s_Frames == FrameCount && Stats.s_Compose.s_Frames == FrameCount && Stats.s_Present.s_Frames == FrameCount);
+    TEST_CHECK(Stats.s_Capture.s_MaxDepth <= 2);
+    TEST_CHECK(Stats.s_Compose.s_MaxDepth == QueueSize);
+    TEST_CHECK(Stats.s_Present.s_MaxDepth >= 1 && Stats.s_Present.s_MaxDepth <= QueueSize);
+
+    // One frame in the queue, one composed and one shown at most
+    TEST_CHECK(Buffers.size() <= QueueSize + 2);
+}
+
+// Stop makes Run return after the frame being shown, and closes the grabber
+void TestStop(const std::filesystem::path& Directory, const std::string& Video)
+{
+    CMouseEvents Events("Pipeline", (Directory / "Zones.xml").string(), (Directory / "Zones.jpg").string(), false);
+    CFrameGrabber Grabber(2, EFramePolicy::Block);
+    TEST_CHECK(Grabber.Open(Video, false));
+    CFramePipeline Pipeline(Events, Grabber);
+
+    std::vector<int> Shown;
+    SetImshowHandler([&Shown](const std::string&, const cv::Mat& Frame) { Shown.push_back(FrameNumber(Frame)); });
+    SetWaitKeyHandler([&Shown, &Pipeline](int)
+    {
+        if(Shown.size() == 10)
+        {
+            Pipeline.Stop();
+        }
+        return -1;
+    });
+    Pipeline.Run();
+    TEST_CHECK(Shown == FirstFrames(10));
+
+    // Only the frames captured before the grabber was closed are left
+    cv::Mat Frame;
+    int Left{0};
+    while(Grabber.Read(Frame))
+    {
+        ++Left;
+    }
+    TEST_CHECK(Left <= 2);
+}
+
+}
+
+int main()
+{
+    const auto Directory = std::filesystem::temp_directory_path() / "FramePipelineTest";
+    std::filesystem::remove_all(Directory);
+    std::filesystem::create_directories(Directory);
+    const auto Video = WriteVideo(Directory);
+
+    TestPool();
+    for(std::size_t QueueSize : {1, 2, 3})
+    {
+        TestPipeline(Directory, Video, QueueSize);
+    }
+    TestStop(Directory, Video);
+    SetImshowHandler(nullptr);
+    SetWaitKeyHandler(nullptr);
+    return TestFailures();
+}
@@ -0,0 +1,108 @@
+#include "HighGuiStub.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include <opencv2/highgui.hpp>
+
+namespace mouseevents
+{
+
+namespace
+{
+
+// State of the stand-in, the handlers run without the lock so that they can call back into it
+struct SWindows
+{
+    std::mutex s_Mutex;
+    ImshowHandler s_Imshow;
+    WaitKeyHandler s_WaitKey;
+    std::map<std::string, std::pair<cv::MouseCallback, void*>> s_Callbacks;
+};
+
+SWindows& Windows()
+{
+    static SWindows Instance;
+    return Instance;
+}
+
+}
+
+void SetImshowHandler(ImshowHandler Handler)
+{
+    std::lock_guard<std::mutex> Lock(Windows().s_Mutex);
+    Windows().s_Imshow = std::move(Handler);
+}
+
+void SetWaitKeyHandler(WaitKeyHandler Handler)
+{
+    std::lock_guard<std::mutex> Lock(Windows().s_Mutex);
+    Windows().s_WaitKey = std::move(Handler);
+}
+
+bool SendMouseEvent(const std::string& WinName, int Event, int X, int Y, int Flag)
+{
+    std::pair<cv::MouseCallback, void*> Callback{nullptr, nullptr};
+    {
+        std::lock_guard<std::mutex> Lock(Windows().s_Mutex);
+        const auto It = Windows().s_Callbacks.find(WinName);
+        if(It != Windows().s_Callbacks.end())
+        {
+            Callback = It->second;
+        }
+    }
+    if(!Callback.first)
+    {
+        return false;
+    }
+    Callback.first(Event, X, Y, Flag, Callback.second);
+    return true;
+}
+
+}
+
+// The functions of HighGUI which the application uses, defined by the test program instead of OpenCV
+namespace cv
+{
+
+void namedWindow(const String&, int)
+{
+}
+
+void destroyWindow(const String& WinName)
+{
+    std::lock_guard<std::mutex> Lock(mouseevents::Windows().s_Mutex);
+    mouseevents::Windows().s_Callbacks.erase(WinName);
+}
+
+void setMouseCallback(const String& WinName, MouseCallback OnMouse, void* UserData)
+{
+    std::lock_guard<std::mutex> Lock(mouseevents::Windows().s_Mutex);
+    mouseevents::Windows().s_Callbacks[WinName] = {OnMouse, UserData};
+}
+
+void imshow(const String& WinName, InputArray Frame)
+{
+    mouseevents::ImshowHandler Handler;
+    {
+        std::lock_guard<std::mutex> Lock(mouseevents::Windows().s_Mutex);
+        Handler = mouseevents::Windows().s_Imshow;
+    }
+    if(Handler)
+    {
+        Handler(WinName, Frame.getMat());
+    }
+}
+
+int waitKey(int Delay)
+{
+    mouseevents::WaitKeyHandler Handler;
+    {
+        std::lock_guard<std::mutex> Lock(mouseevents::Windows().s_Mutex);
+        Handler = mouseevents::Windows().s_WaitKey;
+    }
+    return Handler ? Handler(Delay) : -1;
+}
+
+}
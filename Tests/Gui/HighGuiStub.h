@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+namespace mouseevents
+{
+
+// The tests in Tests/Gui are linked with this stand-in for the windows of HighGUI, which takes the place of the one
+// of OpenCV, so that the display loops run without a display. The test sees the frames given to cv::imshow, and
+// plays the user in cv::waitKey: it sends the mouse events and returns the keys.
+
+// Called by cv::imshow with the window and the frame
+using ImshowHandler = std::function<void(const std::string& WinName, const cv::Mat& Frame)>;
+
+// Called by cv::waitKey with the delay, returns the key pressed or -1
+using WaitKeyHandler = std::function<int(int Delay)>;
+
+// Without handlers imshow does nothing and waitKey returns -1 at once
+void SetImshowHandler(ImshowHandler Handler);
+void SetWaitKeyHandler(WaitKeyHandler Handler);
+
+// Call the mouse callback of a window, like HighGUI does from waitKey. False if the window has no callback.
+bool SendMouseEvent(const std::string& WinName, int Event, int X, int Y, int Flag = 0);
+
+}
@@ -0,0 +1,173 @@
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "../../Mosaic.h"
+#include "../../MouseEvents.h"
+#include "../TestCheck.h"
+#include "HighGuiStub.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+// Frames of twice the size of a tile, so that the zones of a tile are kept at twice its coordinates
+const cv::Size TileSize{80, 60};
+const cv::Size FrameSize{160, 120};
+const int StreamCount{3};
+const int EscapeKey{27};
+
+cv::Vec3b StreamColor(int Stream)
+{
+    return cv::Vec3b{static_cast<unsigned char>(50 + 60*Stream), 100, static_cast<unsigned char>(200 - 60*Stream)};
+}
+
+// A video of a stream as a sequence of images in the color of the stream
+std::string WriteVideo(const std::filesystem::path& Directory, int Stream)
+{
+    const auto Color = StreamColor(Stream);
+    const cv::Mat Image(FrameSize, CV_8UC3, cv::Scalar(Color[0], Color[1], Color[2]));
+    const auto Name = "Stream" + std::to_string(Stream);
+    for(int Frame = 0; Frame < 60; ++Frame)
+    {
+        TEST_CHECK(cv::imwrite((Directory / (Name + "_" + std::to_string(100 + Frame).substr(1) + ".png")).string(), Image));
+    }
+    return (Directory / (Name + "_%02d.png")).string();
+}
+
+std::string ConfigPath(const std::filesystem::path& Directory, int Stream)
+{
+    return (Directory / ("Stream" + std::to_string(Stream) + ".xml")).string();
+}
+
+// Whether every stream is shown in its tile (read at the center, far from the mouse pointer), and the last tile is empty
+bool AllTilesShown(const cv::Mat& Mosaic)
+{
+    if(Mosaic.empty() || Mosaic.size() != cv::Size(2*TileSize.width, 2*TileSize.height))
+    {
+        return false;
+    }
+    for(int Tile = 0; Tile < 4; ++Tile)
+    {
+        const auto& Pixel = Mosaic.at<cv::Vec3b>((Tile/2)*TileSize.height + TileSize.height/2, (Tile%2)*TileSize.width + TileSize.width/2);
+        const auto Expected = Tile < StreamCount ? StreamColor(Tile) : cv::Vec3b{0, 0, 0};
+        if(Pixel[0] != Expected[0] || Pixel[1] != Expected[1] || Pixel[2] != Expected[2])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Drag(int FromX, int FromY, int ToX, int ToY)
+{
+    TEST_CHECK(SendMouseEvent("Mosaic", cv::EVENT_LBUTTONDOWN, FromX, FromY, cv::EVENT_FLAG_LBUTTON));
+    SendMouseEvent("Mosaic", cv::EVENT_MOUSEMOVE, ToX, ToY, cv::EVENT_FLAG_LBUTTON);
+    SendMouseEvent("Mosaic", cv::EVENT_LBUTTONUP, ToX, ToY, 0);
+}
+
+void RightClick(int X, int Y)
+{
+    SendMouseEvent("Mosaic", cv::EVENT_RBUTTONDOWN, X, Y, cv::EVENT_FLAG_RBUTTON);
+    SendMouseEvent("Mosaic", cv::EVENT_RBUTTONUP, X, Y, 0);
+}
+
+int MoveAndPress(int X, int Y, int Key)
+{
+    SendMouseEvent("Mosaic", cv::EVENT_MOUSEMOVE, X, Y, 0);
+    return Key;
+}
+
+// The lines of the zones of a stream as saved by its tile, in the coordinates of the stream
+std::vector<std::vector<int>> SavedLines(const std::filesystem::path& Directory, int Stream)
+{
+    CMouseEvents Loaded("Loaded", ConfigPath(Directory, Stream), (Directory / "Loaded.jpg").string(), false, false);
+    std::vector<std::vector<int>> Lines;
+    for(const auto& [ZoneId, Zone] : Loaded.GetZones())
+    {
+        for(const auto& Line : Zone.s_Lines)
+        {
+            Lines.push_back({ZoneId, Line.first.x, Line.first.y, Line.second.x, Line.second.y});
+        }
+    }
+    return Lines;
+}
+
+// Mouse events go to the tile under the pointer, or to the tile where a button was pressed until it is released,
+// in the coordinates of that tile. The undo and redo keys go to the tile under the pointer.
+void TestRouting(const std::filesystem::path& Directory)
+{
+    CMosaic Mosaic("Mosaic", TileSize, 2);
+    for(int Stream = 0; Stream < StreamCount; ++Stream)
+    {
+        TEST_CHECK(Mosaic.Add(WriteVideo(Directory, Stream), ConfigPath(Directory, Stream), (Directory / "Snap.jpg").string()));
+    }
+
+    cv::Mat Shown;
+    SetImshowHandler([&Shown](const std::string& WinName, const cv::Mat& Frame)
+    {
+        TEST_CHECK(WinName == "Mosaic");
+        Frame.copyTo(Shown);
+    });
+
+    // Every step is played in one waitKey, the events are handled when the tiles are composed next
+    const std::vector<std::function<int()>> Steps{
+        // A line in tile 0 which is dropped in tile 1 ends at the border of tile 0, then the zone is closed
+        []() { Drag(40, 30, 100, 30); RightClick(40, 30); return -1; },
+        // A zone in tile 1 and one in tile 2
+        []() { Drag(90, 10, 150, 10); RightClick(120, 30); return -1; },
+        []() { Drag(10, 70, 70, 70); RightClick(40, 90); return -1; },
+        // Undo in tile 2, then in tile 1, and redo in tile 2
+        []() { return MoveAndPress(40, 90, 'z'); },
+        []() { return MoveAndPress(120, 30, 'z'); },
+        []() { return MoveAndPress(40, 90, 'y'); },
+        // Tile 3 has no stream, and the events outside the mosaic go nowhere
+        []() { Drag(90, 70, 150, 70); RightClick(120, 90); return -1; },
+        []() { Drag(-10, 30, -10, 50); RightClick(-10, 30); return -1; },
+        []() { return -1; },
+        []() { return -1; }};
+
+    const auto Start = std::chrono::steady_clock::now();
+    bool Ready{false};
+    std::size_t Step{0};
+    SetWaitKeyHandler([&](int)
+    {
+        if(!Ready)
+        {
+            // Until every stream is decoded and shown, the scale of a tile is set by its first frame
+            Ready = AllTilesShown(Shown);
+            if(!Ready)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                return std::chrono::steady_clock::now() - Start > std::chrono::seconds(10) ? EscapeKey : -1;
+            }
+        }
+        return Step < Steps.size() ? Steps[Step++]() : EscapeKey;
+    });
+    Mosaic.Run();
+    SetImshowHandler(nullptr);
+    SetWaitKeyHandler(nullptr);
+    TEST_CHECK(Ready && Step == Steps.size());
+
+    TEST_CHECK(SavedLines(Directory, 0) == (std::vector<std::vector<int>>{{1, 80, 60, 158, 60}}));
+    TEST_CHECK(SavedLines(Directory, 1).empty());
+    TEST_CHECK(SavedLines(Directory, 2) == (std::vector<std::vector<int>>{{1, 20, 20, 140, 20}}));
+}
+
+}
+
+int main()
+{
+    const auto Directory = std::filesystem::temp_directory_path() / "MosaicTest";
+    std::filesystem::remove_all(Directory);
+    std::filesystem::create_directories(Directory);
+
+    TestRouting(Directory);
+    return TestFailures();
+}
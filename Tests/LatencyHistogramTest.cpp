@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../LatencyHistogram.h"
+#include "../MouseEvents.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+bool Near(double Value, double Expected)
+{
+    return std::abs(Value - Expected) < 1e-6;
+}
+
+// A percentile is the upper bound of the bucket which reaches its rank, but never more than the longest latency
+void TestPercentiles()
+{
+    CLatencyHistogram Histogram;
+    auto Stats = Histogram.Stats();
+    TEST_CHECK(Stats.s_Count == 0 && Stats.s_P50Ms == 0 && Stats.s_P99Ms == 0 && Stats.s_MaxMs == 0);
+
+    // One latency in the middle of each of the first 1000 buckets, in any order
+    std::vector<double> Latencies;
+    for(int Bucket = 0; Bucket < 1000; ++Bucket)
+    {
+        Latencies.push_back(0.1*Bucket + 0.05);
+    }
+    std::shuffle(Latencies.begin(), Latencies.end(), std::mt19937(50));
+    for(const auto Ms : Latencies)
+    {
+        Histogram.Add(Ms);
+    }
+    Stats = Histogram.Stats();
+    TEST_CHECK(Stats.s_Count == 1000 && Near(Stats.s_P50Ms, 50.0) && Near(Stats.s_P95Ms, 95.0) && Near(Stats.s_P99Ms, 99.0));
+    TEST_CHECK(Near(Stats.s_MaxMs, 99.95));
+
+    Histogram.Reset();
+    Stats = Histogram.Stats();
+    TEST_CHECK(Stats.s_Count == 0 && Stats.s_MaxMs == 0);
+
+    Histogram.Add(0.03);
+    Stats = Histogram.Stats();
+    TEST_CHECK(Stats.s_Count == 1 && Near(Stats.s_P50Ms, 0.03) && Near(Stats.s_P99Ms, 0.03) && Near(Stats.s_MaxMs, 0.03));
+
+    // Negative latencies count as zero, latencies beyond 500 ms share the last bucket
+    Histogram.Reset();
+    Histogram.Add(-3);
+    Histogram.Add(2000);
+    Stats = Histogram.Stats();
+    TEST_CHECK(Stats.s_Count == 2 && Near(Stats.s_P50Ms, 0.1) && Near(Stats.s_P99Ms, 500.0) && Near(Stats.s_MaxMs, 2000.0));
+}
+
+// Latencies added by several threads at once are all counted
+void TestThreads()
+{
+    CLatencyHistogram Histogram;
+    std::vector<std::thread> Threads;
+    for(int Thread = 0; Thread < 4; ++Thread)
+    {
+        Threads.emplace_back([&Histogram]
+        {
+            for(int Latency = 0; Latency < 50000; ++Latency)
+            {
+                Histogram.Add(0.1*(Latency % 100) + 0.05);
+            }
+        });
+    }
+    for(auto& Thread : Threads)
+    {
+        Thread.join();
+    }
+    const auto Stats = Histogram.Stats();
+    TEST_CHECK(Stats.s_Count == 200000 && Near(Stats.s_P50Ms, 5.0) && Near(Stats.s_P99Ms, 9.9) && Near(Stats.s_MaxMs, 9.95));
+}
+
+// The events of a composed frame are recorded when the frame is presented. Of the frames which are composed but never
+// presented, only the newest 8 (PendingFramesLimit) are kept.
+void TestPendingFrames(const std::filesystem::path& Directory)
+{
+    CMouseEvents Events("Latency", (Directory / "Zones.xml").string(), (Directory / "Zones.jpg").string(), false, false);
+    const cv::Mat Frame(cv::Size(32, 24), CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::Mat Composed, Zoom;
+
+    // The events of the first frames wait long before the newer frames are composed
+    for(int Composes = 0; Composes < 12; ++Composes)
+    {
+        if(Composes == 4)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        Events.Post(cv::EVENT_MOUSEMOVE, Composes, Composes, 0);
+        Events.Compose(Frame, Composed, Zoom);
+    }
+    for(int Presents = 0; Presents < 12; ++Presents)
+    {
+        Events.Presented();
+    }
+    auto Latency = Events.GetInputLatency();
+    TEST_CHECK(Latency.s_Count == 8 && Latency.s_MaxMs < 100);
+
+    // A frame without events records nothing, one with three events three latencies
+    Events.Compose(Frame, Composed, Zoom);
+    Events.Presented();
+    TEST_CHECK(Events.GetInputLatency().s_Count == 8);
+    for(int Event = 0; Event < 3; ++Event)
+    {
+        Events.Post(cv::EVENT_MOUSEMOVE, Event, Event, 0);
+    }
+    Events.Compose(Frame, Composed, Zoom);
+    TEST_CHECK(Events.GetInputLatency().s_Count == 8);
+    Events.Presented();
+    TEST_CHECK(Events.GetInputLatency().s_Count == 11);
+
+    Events.ResetInputLatency();
+    TEST_CHECK(Events.GetInputLatency().s_Count == 0);
+}
+
+}
+
+int main()
+{
+    const auto Directory = std::filesystem::temp_directory_path() / "LatencyHistogramTest";
+    std::filesystem::remove_all(Directory);
+    std::filesystem::create_directories(Directory);
+
+    TestPercentiles();
+    TestThreads();
+    TestPendingFrames(Directory);
+    return TestFailures();
+}
@@ -0,0 +1,123 @@
+#include <cstddef>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../PersistentMap.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+using Map = CPersistentMap<int, std::string>;
+using Reference = std::map<int, std::string>;
+
+// Same items in the same order, and the same answers to Find and Last
+bool SameItems(const Map& Version, const Reference& Expected)
+{
+    if(Version.Size() != Expected.size() || Version.Empty() != Expected.empty())
+    {
+        return false;
+    }
+    auto It = Version.begin();
+    for(const auto& Item : Expected)
+    {
+        if(It == Version.end() || It->first != Item.first || It->second != Item.second)
+        {
+            return false;
+        }
+        const auto* Value = Version.Find(Item.first);
+        if(!Value || *Value != Item.second)
+        {
+            return false;
+        }
+        ++It;
+    }
+    if(It != Version.end())
+    {
+        return false;
+    }
+    const auto* Last = Version.Last();
+    return Expected.empty() ? !Last : Last && Last->first == Expected.rbegin()->first;
+}
+
+// Random edits give the same items as std::map, and every old version keeps its items
+void TestRandomEdits()
+{
+    std::mt19937 Random(26);
+    std::uniform_int_distribution<int> RandomKey(0, 199);
+
+    Map Current;
+    Reference Expected;
+    std::vector<std::pair<Map, Reference>> Versions;
+    for(int Edit = 0; Edit < 4000; ++Edit)
+    {
+        const int Key = RandomKey(Random);
+        if(Random() % 3 == 0)
+        {
+            TEST_CHECK(Current.Erase(Key) == (Expected.erase(Key) == 1));
+        }
+        else
+        {
+            const auto Value = std::to_string(Edit);
+            Current.Set(Key, Value);
+            Expected[Key] = Value;
+        }
+        TEST_CHECK(Current.Find(Key) ? Expected.count(Key) == 1 : Expected.count(Key) == 0);
+        if(Edit % 100 == 0)
+        {
+            Versions.emplace_back(Current, Expected);
+        }
+    }
+    TEST_CHECK(SameItems(Current, Expected));
+    for(const auto& Version : Versions)
+    {
+        TEST_CHECK(SameItems(Version.first, Version.second));
+    }
+}
+
+// Edits share the values of the keys they do not touch, erasing a missing key changes nothing
+void TestSharing()
+{
+    const std::vector<std::pair<int, std::string>> Items{{3, "C"}, {1, "A"}, {2, "B"}, {5, "E"}, {4, "D"}};
+    const Map Original(Items.begin(), Items.end());
+    TEST_CHECK(SameItems(Original, Reference(Items.begin(), Items.end())));
+
+    Map Edited = Original;
+    Edited.Set(3, "Z");
+    TEST_CHECK(Edited.Erase(5));
+    TEST_CHECK(!Edited.Erase(6));
+    TEST_CHECK(!Edited.Erase(5));
+
+    TEST_CHECK(*Original.Find(3) == "C");
+    TEST_CHECK(*Edited.Find(3) == "Z");
+    TEST_CHECK(Original.Find(5) && !Edited.Find(5));
+    TEST_CHECK(Original.Size() == 5 && Edited.Size() == 4);
+    for(const int Key : {1, 2, 4})
+    {
+        TEST_CHECK(Original.Find(Key) == Edited.Find(Key));
+    }
+
+    const Map Unchanged = Edited;
+    Edited.Erase(6);
+    for(const int Key : {1, 2, 3, 4})
+    {
+        TEST_CHECK(Unchanged.Find(Key) == Edited.Find(Key));
+    }
+
+    Map Empty;
+    TEST_CHECK(!Empty.Erase(1) && Empty.Empty() && !Empty.Last() && Empty.begin() == Empty.end());
+}
+
+}
+
+int main()
+{
+    TestRandomEdits();
+    TestSharing();
+    return TestFailures();
+}
@@ -0,0 +1,82 @@
+#include <cstddef>
+#include <thread>
+
+#include "../SpscQueue.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+// Push fails when the queue is full and Pop when it is empty, the items come out in order across the wrap
+void TestBounds()
+{
+    CSpscQueue<int, 4> Queue;
+    int Item{0};
+    TEST_CHECK(!Queue.Pop(Item) && Queue.Size() == 0);
+    for(int Round = 0; Round < 3; ++Round)
+    {
+        for(int i = 0; i < 4; ++i)
+        {
+            TEST_CHECK(Queue.Push(Round * 10 + i));
+        }
+        TEST_CHECK(!Queue.Push(-1) && Queue.Size() == 4);
+        for(int i = 0; i < 3; ++i)
+        {
+            TEST_CHECK(Queue.Pop(Item) && Item == Round * 10 + i);
+        }
+        TEST_CHECK(Queue.Push(Round * 10 + 4));
+        for(int i = 3; i < 5; ++i)
+        {
+            TEST_CHECK(Queue.Pop(Item) && Item == Round * 10 + i);
+        }
+        TEST_CHECK(!Queue.Pop(Item) && Queue.Size() == 0);
+    }
+}
+
+// A producer and a consumer thread pass every item exactly once, in order
+void TestThreads()
+{
+    constexpr int Count{100000};
+    CSpscQueue<int, 64> Queue;
+    std::thread Producer([&Queue]
+    {
+        for(int i = 0; i < Count;)
+        {
+            if(Queue.Push(i))
+            {
+                ++i;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int Expected{0};
+    for(int Item{0}; Expected < Count;)
+    {
+        if(Queue.Pop(Item))
+        {
+            TEST_CHECK(Item == Expected);
+            ++Expected;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    Producer.join();
+    TEST_CHECK(Queue.Size() == 0);
+}
+
+}
+
+int main()
+{
+    TestBounds();
+    TestThreads();
+    return TestFailures();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdio>
+
+namespace mouseevents
+{
+
+// Number of failed checks of the test program, its exit code
+inline int& TestFailures()
+{
+    static int Failures{0};
+    return Failures;
+}
+
+}
+
+// Report a failed condition and go on with the test
+#define TEST_CHECK(Condition) \
+    ((Condition) ? void() : (std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #Condition), void(++mouseevents::TestFailures())))
@@ -0,0 +1,204 @@
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../TinyXml/tinyxml.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+// Much deeper than the stack allows for a recursive walk (which crashed at 100k)
+const int Depth{300000};
+
+// An element which counts the live instances, to see that Clear deletes every node
+class CCountedElement : public TiXmlElement
+{
+public:
+    explicit CCountedElement(const char* Value) : TiXmlElement(Value) { ++s_Live; }
+    ~CCountedElement() override { --s_Live; }
+
+    static int s_Live;
+};
+
+int CCountedElement::s_Live{0};
+
+// A chain of nested elements, each followed by a comment, with a text at the bottom:
+// <e><e>...<e>text</e>...<!--c--></e><!--c--></e>
+void AddChain(TiXmlNode* Parent, int Levels)
+{
+    for(int Level = 0; Level < Levels; ++Level)
+    {
+        TiXmlNode* Child = Parent->LinkEndChild(new CCountedElement("e"));
+        Parent->LinkEndChild(new TiXmlComment("c"));
+        Parent = Child;
+    }
+    Parent->LinkEndChild(new TiXmlText("text"));
+}
+
+// Checks the order of the visits of a chain while they are made
+class CChainChecker : public TiXmlVisitor
+{
+public:
+    bool VisitEnter(const TiXmlElement& Element, const TiXmlAttribute*) override
+    {
+        m_Ordered = m_Ordered && !m_TextSeen && std::string(Element.Value()) == "e";
+        ++m_Entered;
+        ++m_Depth;
+        return true;
+    }
+
+    bool VisitExit(const TiXmlElement&) override
+    {
+        m_Ordered = m_Ordered && m_TextSeen && m_CommentsSeen == m_Exited;
+        ++m_Exited;
+        --m_Depth;
+        return true;
+    }
+
+    bool Visit(const TiXmlText& Text) override
+    {
+        m_Ordered = m_Ordered && !m_TextSeen && m_Depth == Depth && std::string(Text.Value()) == "text";
+        m_TextSeen = true;
+        return true;
+    }
+
+    bool Visit(const TiXmlComment&) override
+    {
+        ++m_CommentsSeen;
+        // The comment of a level comes after its element is left
+        m_Ordered = m_Ordered && m_Exited == m_CommentsSeen;
+        return true;
+    }
+
+    int m_Entered{0};
+    int m_Exited{0};
+    int m_CommentsSeen{0};
+    int m_Depth{0};
+    bool m_TextSeen{false};
+    bool m_Ordered{true};
+};
+
+// Accept walks a deep chain in order, the printers print it, and Clear deletes it
+void TestDeepChain()
+{
+    {
+        TiXmlDocument Doc;
+        AddChain(&Doc, Depth);
+        TEST_CHECK(CCountedElement::s_Live == Depth);
+
+        CChainChecker Checker;
+        TEST_CHECK(Doc.Accept(&Checker));
+        TEST_CHECK(Checker.m_Ordered && Checker.m_TextSeen);
+        TEST_CHECK(Checker.m_Entered == Depth && Checker.m_Exited == Depth && Checker.m_CommentsSeen == Depth);
+
+        TiXmlPrinter Printer;
+        Printer.SetIndent("");
+        Printer.SetLineBreak("");
+        TEST_CHECK(Doc.Accept(&Printer));
+        // "<e>" and "</e><!--c-->" per level, one of them printed as "<e>text</e>"
+        TEST_CHECK(Printer.Size() == static_cast<size_t>(Depth) * (3 + 4 + 8) + 4);
+
+        Doc.Clear();
+        TEST_CHECK(CCountedElement::s_Live == 0 && !Doc.FirstChild());
+
+        // The destructor of a deep element
+        auto* Top = new CCountedElement("top");
+        AddChain(Top, Depth);
+        delete Top;
+        TEST_CHECK(CCountedElement::s_Live == 0);
+
+        // The destructor of the document
+        AddChain(&Doc, Depth);
+    }
+    TEST_CHECK(CCountedElement::s_Live == 0);
+}
+
+// Records the visits, and gives false for the nodes with the given values
+class CStopper : public TiXmlVisitor
+{
+public:
+    explicit CStopper(std::vector<std::string> Stops) : m_Stops{std::move(Stops)} {}
+
+    bool VisitEnter(const TiXmlElement& Element, const TiXmlAttribute*) override { return Record("enter ", Element.Value()); }
+    bool VisitExit(const TiXmlElement& Element) override { return Record("exit ", Element.Value()); }
+    bool Visit(const TiXmlText& Text) override { return Record("text ", Text.Value()); }
+    bool Visit(const TiXmlComment& Comment) override { return Record("comment ", Comment.Value()); }
+
+    std::string m_Visits;
+
+private:
+    bool Record(const char* Kind, const char* Value)
+    {
+        const std::string Visit{Kind + std::string(Value)};
+        m_Visits += Visit + ";";
+        for(const auto& Stop : m_Stops)
+        {
+            if(Stop == Visit)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::string> m_Stops;
+};
+
+std::string Visits(const TiXmlNode& Node, std::vector<std::string> Stops)
+{
+    CStopper Stopper(std::move(Stops));
+    Node.Accept(&Stopper);
+    return Stopper.m_Visits;
+}
+
+// A false from VisitEnter skips the children, a false from Visit or VisitExit skips the following siblings
+void TestEarlyOuts()
+{
+    TiXmlDocument Doc;
+    Doc.Parse("<a><b><c/>t1<!--k1--></b><d>t2</d><e/></a>");
+    TEST_CHECK(!Doc.Error());
+
+    TEST_CHECK(Visits(Doc, {}) == "enter a;enter b;enter c;exit c;text t1;comment k1;exit b;enter d;text t2;exit d;enter e;exit e;exit a;");
+    TEST_CHECK(Visits(Doc, {"enter b"}) == "enter a;enter b;exit b;enter d;text t2;exit d;enter e;exit e;exit a;");
+    TEST_CHECK(Visits(Doc, {"text t1"}) == "enter a;enter b;enter c;exit c;text t1;exit b;enter d;text t2;exit d;enter e;exit e;exit a;");
+    TEST_CHECK(Visits(Doc, {"exit c"}) == "enter a;enter b;enter c;exit c;exit b;enter d;text t2;exit d;enter e;exit e;exit a;");
+    TEST_CHECK(Visits(Doc, {"exit b"}) == "enter a;enter b;enter c;exit c;text t1;comment k1;exit b;exit a;");
+    TEST_CHECK(Visits(Doc, {"enter a"}) == "enter a;exit a;");
+
+    // A walk which starts below the document stops at its own node
+    TEST_CHECK(Visits(*Doc.RootElement()->FirstChildElement("d"), {}) == "enter d;text t2;exit d;");
+    TEST_CHECK(Visits(*Doc.RootElement()->FirstChildElement("b"), {"exit c"}) == "enter b;enter c;exit c;exit b;");
+}
+
+// Clear of an arena document deletes the nodes added after the parse, which own heap memory
+void TestArenaClear()
+{
+    for(const bool InSitu : {false, true})
+    {
+        TiXmlDocument Doc;
+        Doc.SetUseArena(true);
+        Doc.SetInSitu(InSitu);
+        Doc.Parse("<a x='1'><b>text</b><c><d/></c></a>");
+        TEST_CHECK(!Doc.Error());
+        AddChain(Doc.RootElement()->FirstChildElement("c")->FirstChildElement("d"), 1000);
+        Doc.RootElement()->LinkEndChild(new CCountedElement("late"));
+        Doc.RootElement()->FirstChildElement("b")->SetValue("renamed to a value on the heap, which is longer than the parsed one");
+        TEST_CHECK(CCountedElement::s_Live == 1001);
+
+        Doc.Clear();
+        TEST_CHECK(CCountedElement::s_Live == 0 && !Doc.FirstChild());
+    }
+}
+
+}
+
+int main()
+{
+    TestDeepChain();
+    TestEarlyOuts();
+    TestArenaClear();
+    return TestFailures();
+}
@@ -0,0 +1,253 @@
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../TinyXml/tinyxml.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+const int Names{12};
+
+std::string Name(unsigned Number)
+{
+    return "n" + std::to_string(Number % Names);
+}
+
+std::string AttributeName(unsigned Number)
+{
+    return "a" + std::to_string(Number % 40);
+}
+
+// The position of a child among the children of its parent, -1 for none
+int Position(const TiXmlNode* Child)
+{
+    if(!Child)
+    {
+        return -1;
+    }
+    int Result{0};
+    for(const TiXmlNode* Node = Child->Parent()->FirstChild(); Node != Child; Node = Node->NextSibling())
+    {
+        ++Result;
+    }
+    return Result;
+}
+
+TiXmlNode* ChildAt(TiXmlNode* Parent, unsigned Number)
+{
+    int Count{0};
+    for(TiXmlNode* Node = Parent->FirstChild(); Node; Node = Node->NextSibling())
+    {
+        ++Count;
+    }
+    if(Count == 0)
+    {
+        return nullptr;
+    }
+    TiXmlNode* Node = Parent->FirstChild();
+    for(unsigned Skip = Number % Count; Skip > 0; --Skip)
+    {
+        Node = Node->NextSibling();
+    }
+    return Node;
+}
+
+// Everything the lookups by name find, as positions and values
+std::vector<std::string> Lookups(const TiXmlElement* Root)
+{
+    std::vector<std::string> Result;
+    for(int Number = 0; Number <= Names; ++Number)
+    {
+        // The last name is never used
+        const auto Value = Number < Names ? Name(Number) : "missing";
+        std::string Found{Value + ":"};
+        for(const TiXmlNode* Node = Root->FirstChild(Value.c_str()); Node; Node = Node->NextSibling(Value.c_str()))
+        {
+            Found += " " + std::to_string(Position(Node));
+        }
+        Found += " |";
+        for(const TiXmlElement* Element = Root->FirstChildElement(Value.c_str()); Element; Element = Element->NextSiblingElement(Value.c_str()))
+        {
+            Found += " " + std::to_string(Position(Element));
+        }
+        Result.push_back(Found);
+    }
+    for(unsigned Number = 0; Number <= 40; ++Number)
+    {
+        const auto Attribute = Number < 40 ? AttributeName(Number) : "missing";
+        const char* Value = Root->Attribute(Attribute.c_str());
+        Result.push_back(Attribute + "=" + (Value ? Value : "(none)"));
+    }
+    return Result;
+}
+
+std::string AttributeNameNotIn(const TiXmlElement* Root, unsigned Number)
+{
+    for(;; ++Number)
+    {
+        const auto Candidate = AttributeName(Number);
+        if(!Root->Attribute(Candidate.c_str()))
+        {
+            return Candidate;
+        }
+    }
+}
+
+// One change of the children or attributes of the root, the same for the same numbers
+void Edit(TiXmlElement* Root, unsigned Choice, unsigned Number, unsigned Value)
+{
+    const TiXmlElement Added(Name(Value).c_str());
+    TiXmlNode* Child = ChildAt(Root, Number);
+    switch(Choice % 12)
+    {
+    case 0:
+        Root->InsertEndChild(Added);
+        break;
+    case 1:
+        if(Child)
+        {
+            Root->InsertBeforeChild(Child, Added);
+        }
+        break;
+    case 2:
+        if(Child)
+        {
+            Root->LinkAfterChild(Child, new TiXmlElement(Name(Value).c_str()));
+        }
+        break;
+    case 3:
+        if(Child)
+        {
+            Root->LinkBeforeChild(Child, new TiXmlComment(Name(Value).c_str()));
+        }
+        break;
+    case 4:
+        if(Child)
+        {
+            Child->SetValue(Name(Value).c_str());
+        }
+        break;
+    case 5:
+        if(Child)
+        {
+            Root->RemoveChild(Child);
+        }
+        break;
+    case 6:
+        if(Child)
+        {
+            Root->ReplaceChild(Child, Added);
+        }
+        break;
+    case 7:
+        Root->SetAttribute(AttributeName(Number).c_str(), std::to_string(Value).c_str());
+        break;
+    case 8:
+        Root->RemoveAttribute(AttributeName(Number).c_str());
+        break;
+    case 9:
+        if(TiXmlAttribute* Attribute = Root->FirstAttribute())
+        {
+            for(unsigned Skip = Number % 8; Skip > 0 && Attribute->Next(); --Skip)
+            {
+                Attribute = Attribute->Next();
+            }
+            Attribute->SetName(AttributeNameNotIn(Root, Value).c_str());
+        }
+        break;
+    case 10:
+        Root->LinkEndChild(new TiXmlText(Name(Value).c_str()));
+        break;
+    default:
+        if(Choice % 300 == 11)
+        {
+            Root->Clear();
+        }
+        break;
+    }
+}
+
+std::string MakeSource(std::mt19937& Random)
+{
+    std::string Xml{"<root"};
+    for(unsigned Attribute = 0; Attribute < 30; ++Attribute)
+    {
+        Xml += " " + AttributeName(Attribute) + "='" + std::to_string(Random() % 100) + "'";
+    }
+    Xml += ">";
+    for(int Child = 0; Child < 200; ++Child)
+    {
+        const auto Choice = Random() % 10;
+        const auto Value = Name(Random());
+        if(Choice == 0)
+        {
+            Xml += "<!--" + Value + "-->";
+        }
+        else if(Choice == 1)
+        {
+            Xml += "<" + Value + ">t</" + Value + ">";
+        }
+        else
+        {
+            Xml += "<" + Value + "/>";
+        }
+    }
+    return Xml + "</root>";
+}
+
+// After every edit (and in a copy), the lookups on a document parsed with the index find what they find without it
+void TestEdits()
+{
+    std::mt19937 Random(40);
+    const auto Source = MakeSource(Random);
+
+    TiXmlDocument Plain;
+    Plain.Parse(Source.c_str());
+    TEST_CHECK(!Plain.Error());
+
+    TiXmlParseOptions Options;
+    Options.indexNames = true;
+    TiXmlDocument Indexed;
+    Indexed.SetParseOptions(Options);
+    Indexed.Parse(Source.c_str());
+    TEST_CHECK(!Indexed.Error());
+
+    TEST_CHECK(Lookups(Indexed.RootElement()) == Lookups(Plain.RootElement()));
+    for(int Step = 0; Step < 3000; ++Step)
+    {
+        const auto Choice = static_cast<unsigned>(Random());
+        const auto Number = static_cast<unsigned>(Random());
+        const auto Value = static_cast<unsigned>(Random());
+        Edit(Plain.RootElement(), Choice, Number, Value);
+        Edit(Indexed.RootElement(), Choice, Number, Value);
+
+        const auto Expected = Lookups(Plain.RootElement());
+        const bool Same = Lookups(Indexed.RootElement()) == Expected;
+        if(!Same)
+        {
+            std::fprintf(stderr, "lookups differ after edit %u at step %d\n", Choice % 12, Step);
+        }
+        TEST_CHECK(Same);
+        if(!Same)
+        {
+            break;
+        }
+    }
+
+    // A copy indexes its children and attributes again
+    const TiXmlDocument Copy(Indexed);
+    TEST_CHECK(Lookups(Copy.RootElement()) == Lookups(Plain.RootElement()));
+}
+
+}
+
+int main()
+{
+    TestEdits();
+    return TestFailures();
+}
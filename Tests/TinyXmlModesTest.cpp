@@ -0,0 +1,63 @@
+#include <string>
+
+#include "../TinyXml/tinyxml.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+struct SMode
+{
+    const char* s_Name;
+    bool s_InSitu;
+    bool s_Arena;
+};
+
+const SMode Modes[]{{"in situ", true, false}, {"arena", false, true}, {"in situ with arena", true, true}};
+
+std::string Print(const TiXmlDocument& Doc)
+{
+    TiXmlPrinter Printer;
+    Doc.Accept(&Printer);
+    return Printer.CStr();
+}
+
+// Every parse mode gives the same tree as the default one, and the same error at the same location
+void CheckSameParse(const std::string& Source)
+{
+    TiXmlDocument Expected;
+    Expected.Parse(Source.c_str());
+    for(const auto& Mode : Modes)
+    {
+        TiXmlDocument Doc;
+        Doc.SetInSitu(Mode.s_InSitu);
+        Doc.SetUseArena(Mode.s_Arena);
+        Doc.Parse(Source.c_str());
+        const bool Same = Doc.Error() == Expected.Error() && Doc.ErrorId() == Expected.ErrorId() &&
+                          Doc.ErrorRow() == Expected.ErrorRow() && Doc.ErrorCol() == Expected.ErrorCol() &&
+                          (Doc.Error() || Print(Doc) == Print(Expected));
+        if(!Same)
+        {
+            std::fprintf(stderr, "%s: error %d at %d,%d instead of %d at %d,%d for\n%s\n", Mode.s_Name, Doc.ErrorId(), Doc.ErrorRow(), Doc.ErrorCol(),
+                         Expected.ErrorId(), Expected.ErrorRow(), Expected.ErrorCol(), Source.c_str());
+        }
+        TEST_CHECK(Same);
+    }
+}
+
+}
+
+int main()
+{
+    CheckSameParse("<Zones>\n\t<Zone ZoneId=\"1\" ZoneName='Gate &quot;A&quot; &lt;&amp;&gt;'>\n\t\ttext &amp; &#x41;&#66;\n\t\t<![CDATA[<x>]]><!-- c -->\n\t</Zone>\n</Zones>");
+
+    // Errors after attribute values and text which are decoded in place
+    CheckSameParse("<a x='&lt;&lt;\n&gt;' y=\"v\" x='&lt;&lt;\n&gt;'/>");
+    CheckSameParse("<a>\n<c q=\"a\nb&quot;\"");
+    CheckSameParse("<a z=\"&amp;\" z=\"&amp;\">");
+    CheckSameParse("<a>text &amp;\n more &lt;</b>");
+    CheckSameParse("<a x=\"1&amp;2\"\n\t x=\"dup\"></a>");
+    return TestFailures();
+}
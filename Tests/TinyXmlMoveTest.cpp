@@ -0,0 +1,211 @@
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "../TinyXml/tinyxml.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+struct SMode
+{
+    const char* s_Name;
+    bool s_InSitu;
+    bool s_Arena;
+};
+
+const SMode Modes[]{{"default", false, false}, {"in situ", true, false}, {"arena", false, true}, {"in situ with arena", true, true}};
+
+const char* const Source{"<?xml version=\"1.0\" ?>\n<Zones Count='2'>\n\t<Zone ZoneId=\"1\" ZoneName='Gate &quot;A&quot;'>text &amp; more<!-- c --></Zone>\n"
+                         "\t<Zone ZoneId=\"2\"><Point X='1' Y='2'/><![CDATA[<x>]]></Zone>\n</Zones>"};
+
+std::string Print(const TiXmlNode& Node)
+{
+    TiXmlPrinter Printer;
+    Node.Accept(&Printer);
+    return Printer.CStr();
+}
+
+std::unique_ptr<TiXmlDocument> Parse(const SMode& Mode, const char* Xml)
+{
+    auto Doc = std::make_unique<TiXmlDocument>();
+    Doc->SetInSitu(Mode.s_InSitu);
+    Doc->SetUseArena(Mode.s_Arena);
+    Doc->Parse(Xml);
+    return Doc;
+}
+
+// An element which counts the live instances, to see which nodes are deleted
+class CCountedElement : public TiXmlElement
+{
+public:
+    explicit CCountedElement(const char* Value) : TiXmlElement(Value) { ++s_Live; }
+    ~CCountedElement() override { --s_Live; }
+
+    static int s_Live;
+};
+
+int CCountedElement::s_Live{0};
+
+// A moved document keeps its nodes after the source is gone, the source is empty and can parse again
+void TestMoveDocument(const SMode& Mode)
+{
+    const std::string Expected = Print(*Parse(Mode, Source));
+
+    auto Moved = Parse(Mode, Source);
+    TiXmlDocument Target(std::move(*Moved));
+    TEST_CHECK(!Moved->FirstChild() && !Moved->Error());
+    Moved->Parse("<Other a='b'/>");
+    TEST_CHECK(!Moved->Error() && Print(*Moved) == "<Other a=\"b\" />\n");
+    Moved.reset();
+    TEST_CHECK(Print(Target) == Expected);
+
+    // Assigned over a document parsed in another mode
+    auto Assigned = Parse(Mode, Source);
+    auto Other = Parse(Modes[3 - (&Mode - Modes)], "<Old><Child/></Old>");
+    *Other = std::move(*Assigned);
+    Assigned.reset();
+    TEST_CHECK(Print(*Other) == Expected);
+
+    // The error goes with the document
+    const auto Reference = Parse(Mode, "<a>\n<b></a>");
+    auto Failed = Parse(Mode, "<a>\n<b></a>");
+    TiXmlDocument FailedTarget(std::move(*Failed));
+    TEST_CHECK(FailedTarget.Error() && FailedTarget.ErrorId() == Reference->ErrorId());
+    TEST_CHECK(FailedTarget.ErrorRow() == Reference->ErrorRow() && FailedTarget.ErrorCol() == Reference->ErrorCol());
+}
+
+// A parsed document handed to a worker thread is used there after the parsing thread dropped it
+void TestHandToWorker()
+{
+    for(const auto& Mode : Modes)
+    {
+        auto Doc = Parse(Mode, Source);
+        const std::string Expected = Print(*Doc);
+        std::string Printed;
+        std::thread Worker([&Printed](TiXmlDocument Handed) { Printed = Print(Handed); }, std::move(*Doc));
+        Doc.reset();
+        Worker.join();
+        TEST_CHECK(Printed == Expected);
+    }
+}
+
+// A moved element takes the name, attributes and children, the source stays linked but empty
+void TestMoveElement(const SMode& Mode)
+{
+    auto Doc = Parse(Mode, Source);
+    TiXmlElement* Zone = Doc->RootElement()->FirstChildElement("Zone");
+    const std::string Expected = Print(*Zone);
+
+    auto* Moved = new TiXmlElement(std::move(*Zone));
+    TEST_CHECK(Print(*Moved) == Expected);
+    TEST_CHECK(std::string(Zone->Value()).empty() && !Zone->FirstAttribute() && !Zone->FirstChild());
+    TEST_CHECK(Zone->Parent() == Doc->RootElement() && Doc->RootElement()->FirstChild() == Zone);
+    TEST_CHECK(std::string(Moved->Attribute("ZoneName")) == "Gate \"A\"" && Moved->FirstChild()->Parent() == Moved);
+
+    // The moved element lives in the same document as its nodes
+    Doc->RootElement()->LinkEndChild(Moved);
+    TEST_CHECK(Doc->RootElement()->LastChild() == Moved && Print(*Doc->RootElement()->LastChild()) == Expected);
+
+    TiXmlElement* Second = Zone->NextSiblingElement("Zone");
+    const std::string SecondExpected = Print(*Second);
+    TiXmlElement Assigned("Old");
+    Assigned.SetAttribute("Old", "1");
+    Assigned.LinkEndChild(new TiXmlElement("OldChild"));
+    Assigned = std::move(*Second);
+    TEST_CHECK(Print(Assigned) == SecondExpected && !Assigned.Attribute("Old") && !Assigned.FirstChild("OldChild"));
+    TEST_CHECK(!Second->FirstChild() && !Second->FirstAttribute());
+}
+
+// The linking insertions own their node: it is deleted with its parent, when replaced, or on error
+void TestLinkOwnership()
+{
+    {
+        TiXmlDocument Doc;
+        auto* Root = new CCountedElement("root");
+        TEST_CHECK(Doc.LinkEndChild(Root) == Root);
+        auto* Middle = new CCountedElement("middle");
+        TEST_CHECK(Root->LinkEndChild(Middle) == Middle);
+        TEST_CHECK(Root->LinkBeforeChild(Middle, new CCountedElement("before")) == Middle->PreviousSibling());
+        TEST_CHECK(Root->LinkAfterChild(Middle, new CCountedElement("after")) == Middle->NextSibling());
+        TEST_CHECK(CCountedElement::s_Live == 4);
+        TEST_CHECK(Print(Doc) == "<root>\n    <before />\n    <middle />\n    <after />\n</root>\n");
+
+        auto* Replacement = new CCountedElement("replacement");
+        TEST_CHECK(Root->LinkReplaceChild(Middle, Replacement) == Replacement);
+        TEST_CHECK(CCountedElement::s_Live == 4 && Replacement->Parent() == Root);
+        TEST_CHECK(Print(Doc) == "<root>\n    <before />\n    <replacement />\n    <after />\n</root>\n");
+
+        // Nodes which are not children of the root
+        TiXmlElement Stranger("stranger");
+        TEST_CHECK(!Root->LinkBeforeChild(&Stranger, new CCountedElement("lost")));
+        TEST_CHECK(!Root->LinkAfterChild(nullptr, new CCountedElement("lost")));
+        TEST_CHECK(!Root->LinkReplaceChild(&Stranger, new CCountedElement("lost")));
+        TEST_CHECK(CCountedElement::s_Live == 4);
+
+        // A document is never a child
+        TEST_CHECK(!Root->LinkBeforeChild(Replacement, new TiXmlDocument));
+        TEST_CHECK(!Root->LinkAfterChild(Replacement, new TiXmlDocument));
+        TEST_CHECK(!Root->LinkReplaceChild(Replacement, new TiXmlDocument));
+        TEST_CHECK(Doc.Error() && Doc.ErrorId() == TiXmlBase::TIXML_ERROR_DOCUMENT_TOP_ONLY);
+        TEST_CHECK(Print(Doc) == "<root>\n    <before />\n    <replacement />\n    <after />\n</root>\n");
+    }
+    TEST_CHECK(CCountedElement::s_Live == 0);
+
+    // A moved document deletes the nodes it took, and the source deletes none
+    {
+        auto Doc = std::make_unique<TiXmlDocument>();
+        Doc->LinkEndChild(new CCountedElement("root"))->LinkEndChild(new CCountedElement("child"));
+        TiXmlDocument Target(std::move(*Doc));
+        Doc.reset();
+        TEST_CHECK(CCountedElement::s_Live == 2);
+    }
+    TEST_CHECK(CCountedElement::s_Live == 0);
+}
+
+// The name index of a document parsed with it goes with the moved nodes
+void TestMoveIndex()
+{
+    std::string Xml{"<root>"};
+    for(int Child = 0; Child < 100; ++Child)
+    {
+        Xml += "<c" + std::to_string(Child % 10) + " n='" + std::to_string(Child) + "'/>";
+    }
+    Xml += "</root>";
+
+    TiXmlParseOptions Options;
+    Options.indexNames = true;
+    auto Doc = std::make_unique<TiXmlDocument>();
+    Doc->SetParseOptions(Options);
+    Doc->Parse(Xml.c_str());
+    TEST_CHECK(!Doc->RootElement()->FirstChild("missing"));
+
+    TiXmlDocument Target(std::move(*Doc));
+    Doc.reset();
+    TiXmlElement Root(std::move(*Target.RootElement()));
+    int Found{0};
+    for(const TiXmlElement* Child = Root.FirstChildElement("c7"); Child; Child = Child->NextSiblingElement("c7"))
+    {
+        TEST_CHECK(Child->Parent() == &Root && std::stoi(Child->Attribute("n")) == 7 + 10 * Found++);
+    }
+    TEST_CHECK(Found == 10 && !Target.RootElement()->FirstChild("c7"));
+}
+
+}
+
+int main()
+{
+    for(const auto& Mode : Modes)
+    {
+        TestMoveDocument(Mode);
+        TestMoveElement(Mode);
+    }
+    TestHandToWorker();
+    TestLinkOwnership();
+    TestMoveIndex();
+    return TestFailures();
+}
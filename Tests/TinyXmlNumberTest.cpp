@@ -0,0 +1,120 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "../TinyXml/tinyxml.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+bool SameDouble(double D1, double D2)
+{
+    return (std::isnan(D1) && std::isnan(D2)) || (D1 == D2 && std::signbit(D1) == std::signbit(D2));
+}
+
+// ToInt accepts the input of sscanf's "%d" and gives the same value
+void CheckInt(const std::string& Text)
+{
+    int Expected{0}, Value{0};
+    const bool Scanned = std::sscanf(Text.c_str(), "%d", &Expected) == 1;
+    const int Result = TiXmlBase::ToInt(Text.c_str(), &Value);
+    const bool Same = Result == (Scanned ? TIXML_SUCCESS : TIXML_WRONG_TYPE) && (!Scanned || Value == Expected);
+    if(!Same)
+    {
+        std::fprintf(stderr, "ToInt(\"%s\") is %d, %d instead of %d, %d\n", Text.c_str(), Result, Value, Scanned ? TIXML_SUCCESS : TIXML_WRONG_TYPE, Expected);
+    }
+    TEST_CHECK(Same);
+}
+
+// ToDouble accepts the input of sscanf's "%lf" and gives the same value
+void CheckDouble(const std::string& Text)
+{
+    double Expected{0}, Value{0};
+    const bool Scanned = std::sscanf(Text.c_str(), "%lf", &Expected) == 1;
+    const int Result = TiXmlBase::ToDouble(Text.c_str(), &Value);
+    const bool Same = Result == (Scanned ? TIXML_SUCCESS : TIXML_WRONG_TYPE) && (!Scanned || SameDouble(Value, Expected));
+    if(!Same)
+    {
+        std::fprintf(stderr, "ToDouble(\"%s\") is %d, %.17g instead of %d, %.17g\n", Text.c_str(), Result, Value, Scanned ? TIXML_SUCCESS : TIXML_WRONG_TYPE, Expected);
+    }
+    TEST_CHECK(Same);
+}
+
+// Attributes print numbers as "%d" and "%g" do
+void CheckPrinted(int IntValue, double DoubleValue)
+{
+    char Buffer[64];
+    TiXmlAttribute Attribute;
+    Attribute.SetIntValue(IntValue);
+    std::snprintf(Buffer, sizeof(Buffer), "%d", IntValue);
+    TEST_CHECK(std::strcmp(Attribute.Value(), Buffer) == 0);
+    TEST_CHECK(Attribute.IntValue() == IntValue);
+
+    Attribute.SetDoubleValue(DoubleValue);
+    std::snprintf(Buffer, sizeof(Buffer), "%g", DoubleValue);
+    if(std::strcmp(Attribute.Value(), Buffer) != 0)
+    {
+        std::fprintf(stderr, "SetDoubleValue(%.17g) prints %s instead of %s\n", DoubleValue, Attribute.Value(), Buffer);
+        ++TestFailures();
+    }
+}
+
+}
+
+int main()
+{
+    for(const char* Text : {"0", "42", "-42", "+42", "  7", "\t\n\v\f\r 7", "7 ", "7abc", "007", "-0", "+-1", "-+1", "++1", "--1", "+", "-", "",
+                            " ", "abc", "0x1A", "0X1a", "1e3", "1.5", ".5", "2147483647", "-2147483648", "+2147483647"})
+    {
+        CheckInt(Text);
+        CheckDouble(Text);
+    }
+
+    // Out of range integers are rejected, sscanf's result for them is undefined
+    for(const char* Text : {"2147483648", "-2147483649", "99999999999999999999", "+2147483648"})
+    {
+        int Value{0};
+        TEST_CHECK(TiXmlBase::ToInt(Text, &Value) == TIXML_WRONG_TYPE);
+    }
+
+    for(const char* Text : {"1e308", "1e309", "-1e309", "1e-320", "1e-400", "-1e-400", "4.9e-324", "1.7976931348623157e308", "inf", "-inf", "+inf",
+                            "INF", "infinity", "-Infinity", "infinit", "infinityx", "infx", "in", "i", "nan", "-nan", "NaN", "na", "nan(123)", "nan(", "nan(1", "nan(a_1)", "0x1p3", "0x1.8p1", "-0x10", "+0x1P-2",
+                            "0x", "1e", "1e+", "1e-x", "1.", "-.5e2", "+.e1", ".", "-.", "  +3.25", "3.25\n", "1,5", "0.1", "123456789012345678901234567890"})
+    {
+        CheckDouble(Text);
+    }
+
+    // Random strings of number characters
+    std::mt19937 Random(35);
+    const char Characters[]{"0123456789+-.eExXpPinftyaINFTYAN() \t"};
+    for(int Text = 0; Text < 20000; ++Text)
+    {
+        std::string Input;
+        const auto Length = Random() % 12;
+        for(unsigned i = 0; i < Length; ++i)
+        {
+            Input += Characters[Random() % (sizeof(Characters) - 1)];
+        }
+        CheckDouble(Input);
+        if(Input.find_first_of("0123456789") == std::string::npos || Input.size() < 10)
+        {
+            CheckInt(Input);
+        }
+    }
+
+    for(const int IntValue : {0, 1, -1, 123456, std::numeric_limits<int>::max(), std::numeric_limits<int>::min()})
+    {
+        for(const double DoubleValue : {0.0, -0.0, 1.0, 0.1, 1.0/3, 123456.0, 1234567.0, 1e-5, 1e-4, 1e21, -2.5e-300, 1e308,
+                                        std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()})
+        {
+            CheckPrinted(IntValue, DoubleValue);
+        }
+    }
+    return TestFailures();
+}
@@ -0,0 +1,180 @@
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+
+#include "../TinyXml/tinyxml.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+// What Print writes to a file
+std::string Printed(const TiXmlDocument& Doc)
+{
+    std::string Result;
+    if(FILE* Fp = std::tmpfile())
+    {
+        Doc.Print(Fp);
+        std::rewind(Fp);
+        char Buffer[4096];
+        for(std::size_t Read; (Read = std::fread(Buffer, 1, sizeof(Buffer), Fp)) > 0;)
+        {
+            Result.append(Buffer, Read);
+        }
+        std::fclose(Fp);
+    }
+    return Result;
+}
+
+// What SaveFile writes
+std::string Saved(const TiXmlDocument& Doc)
+{
+    const auto Path = std::filesystem::temp_directory_path() / "TinyXmlPrintTest.xml";
+    std::string Result;
+    TEST_CHECK(Doc.SaveFile(Path.string().c_str()));
+    if(FILE* Fp = std::fopen(Path.string().c_str(), "rb"))
+    {
+        char Buffer[4096];
+        for(std::size_t Read; (Read = std::fread(Buffer, 1, sizeof(Buffer), Fp)) > 0;)
+        {
+            Result.append(Buffer, Read);
+        }
+        std::fclose(Fp);
+    }
+    return Result;
+}
+
+std::string PrinterOutput(const TiXmlDocument& Doc)
+{
+    TiXmlPrinter Printer;
+    Doc.Accept(&Printer);
+    TEST_CHECK(Printer.Size() == std::string(Printer.CStr()).size());
+    return Printer.CStr();
+}
+
+// Print and SaveFile write what TiXmlPrinter builds
+void CheckSameOutput(const TiXmlDocument& Doc)
+{
+    const auto Expected = PrinterOutput(Doc);
+    const auto Output = Printed(Doc);
+    if(Output != Expected)
+    {
+        std::fprintf(stderr, "Print wrote %zu bytes instead of the %zu of TiXmlPrinter\n", Output.size(), Expected.size());
+    }
+    TEST_CHECK(Output == Expected);
+    TEST_CHECK(Saved(Doc) == Expected);
+}
+
+// Random strings with characters which are escaped, entities, control characters and UTF-8
+std::string MakeString(std::mt19937& Random)
+{
+    const char* const Pieces[]{"plain", " ", "&", "<", ">", "\"", "'", "&#x41;", "&amp", "\x01", "\n", "\xc3\xa9", "\x7f"};
+    std::string Result;
+    const auto Count = Random() % 6;
+    for(unsigned Piece = 0; Piece < Count; ++Piece)
+    {
+        Result += Pieces[Random() % 13];
+    }
+    return Result;
+}
+
+// A random tree of elements with attributes, single text children, comments and unknown nodes,
+// the nodes which Print and TiXmlPrinter lay out in the same way
+void AddChildren(std::mt19937& Random, TiXmlNode* Parent, int Depth, int& Elements)
+{
+    const auto Children = Depth < 6 ? Random() % 5 : 0;
+    for(unsigned Child = 0; Child < Children && Elements > 0; ++Child)
+    {
+        const auto Choice = Random() % 8;
+        if(Choice == 0)
+        {
+            Parent->LinkEndChild(new TiXmlComment(("comment " + MakeString(Random)).c_str()));
+        }
+        else if(Choice == 1)
+        {
+            auto* Unknown = new TiXmlUnknown;
+            Unknown->SetValue("!DOCTYPE unknown");
+            Parent->LinkEndChild(Unknown);
+        }
+        else
+        {
+            auto* Element = new TiXmlElement(("e" + std::to_string(--Elements % 7)).c_str());
+            const auto Attributes = Random() % 4;
+            for(unsigned Attribute = 0; Attribute < Attributes; ++Attribute)
+            {
+                Element->SetAttribute(("a" + std::to_string(Attribute)).c_str(), MakeString(Random).c_str());
+            }
+            if(Random() % 3 == 0)
+            {
+                Element->LinkEndChild(new TiXmlText(MakeString(Random).c_str()));
+            }
+            else
+            {
+                AddChildren(Random, Element, Depth + 1, Elements);
+            }
+            Parent->LinkEndChild(Element);
+        }
+    }
+}
+
+TiXmlDocument MakeDocument(std::mt19937& Random, int Elements)
+{
+    TiXmlDocument Doc;
+    if(Random() % 2)
+    {
+        Doc.LinkEndChild(new TiXmlDeclaration("1.0", Random() % 2 ? "UTF-8" : "", Random() % 2 ? "yes" : ""));
+    }
+    while(Elements > 0)
+    {
+        AddChildren(Random, &Doc, 0, Elements);
+    }
+    return Doc;
+}
+
+// Texts which are not the only child and CDATA sections keep the layout of the old fprintf-based Print
+void TestOwnLayout()
+{
+    TiXmlDocument Doc;
+    Doc.Parse("<a x='1&amp;'><b>t &lt; u</b><d><![CDATA[x<y]]></d>mixed<e>q</e></a>");
+    TEST_CHECK(!Doc.Error());
+    TEST_CHECK(Printed(Doc) == "<a x=\"1&amp;\">\n    <b>t &lt; u</b>\n    <d>\n        <![CDATA[x<y]]>\n</d>mixed\n    <e>q</e>\n</a>\n");
+}
+
+// Escaping of attribute values and texts, with the quote chosen by the value
+void TestEncoding()
+{
+    TiXmlDocument Doc;
+    auto* Element = new TiXmlElement("a");
+    Element->SetAttribute("v", "q\"'<>&\x01 &#x41; &amp &\xc3\xa9\x7f");
+    Element->SetAttribute("w", "it's");
+    Element->LinkEndChild(new TiXmlText("t\"'<>&\x01\x1f &#x41;\n\xc3\xa9"));
+    Doc.LinkEndChild(Element);
+    const std::string Expected{"<a v='q&quot;&apos;&lt;&gt;&amp;&#x01; &#x41; &amp;amp &amp;\xc3\xa9\x7f' w=\"it&apos;s\">"
+                               "t&quot;&apos;&lt;&gt;&amp;&#x01;&#x1F; &#x41;&#x0A;\xc3\xa9</a>\n"};
+    TEST_CHECK(Printed(Doc) == Expected);
+    CheckSameOutput(Doc);
+}
+
+}
+
+int main()
+{
+    TestOwnLayout();
+    TestEncoding();
+
+    std::mt19937 Random(36);
+    for(int Document = 0; Document < 200; ++Document)
+    {
+        CheckSameOutput(MakeDocument(Random, 1 + Document % 50));
+    }
+
+    // Much larger than the buffer of Print, so that it is written in many blocks
+    CheckSameOutput(MakeDocument(Random, 20000));
+
+    std::filesystem::remove(std::filesystem::temp_directory_path() / "TinyXmlPrintTest.xml");
+    return TestFailures();
+}
@@ -0,0 +1,234 @@
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../TinyXml/tinyxml.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+using Events = std::vector<std::string>;
+
+// Records the callbacks, and stops the parse after StopAfter of them if it is not negative
+class CRecorder : public TiXmlSaxHandler
+{
+public:
+    explicit CRecorder(int StopAfter = -1) : m_StopAfter{StopAfter} {}
+
+    bool StartElement(const char* Name) override { return Record("start " + std::string(Name)); }
+    bool Attribute(const char* Name, const char* Value) override { return Record("attribute " + std::string(Name) + "=" + Value); }
+    bool Text(const char* Text, bool CData) override { return Record((CData ? "cdata " : "text ") + std::string(Text)); }
+    bool EndElement(const char* Name) override { return Record("end " + std::string(Name)); }
+
+    Events m_Events;
+
+private:
+    bool Record(const std::string& Event)
+    {
+        m_Events.push_back(Event);
+        return m_StopAfter < 0 || static_cast<int>(m_Events.size()) < m_StopAfter;
+    }
+
+    int m_StopAfter;
+};
+
+// The callbacks the SAX reader makes for the elements and texts of a parsed document
+void AddEvents(const TiXmlNode* Node, Events& Result)
+{
+    for(const TiXmlNode* Child = Node->FirstChild(); Child; Child = Child->NextSibling())
+    {
+        if(const TiXmlElement* Element = Child->ToElement())
+        {
+            Result.push_back("start " + std::string(Element->Value()));
+            for(const TiXmlAttribute* Attribute = Element->FirstAttribute(); Attribute; Attribute = Attribute->Next())
+            {
+                Result.push_back("attribute " + std::string(Attribute->Name()) + "=" + Attribute->Value());
+            }
+            AddEvents(Element, Result);
+            Result.push_back("end " + std::string(Element->Value()));
+        }
+        else if(const TiXmlText* Text = Child->ToText())
+        {
+            Result.push_back((Text->CDATA() ? "cdata " : "text ") + std::string(Text->Value()));
+        }
+    }
+}
+
+Events DocumentEvents(const TiXmlDocument& Doc)
+{
+    Events Result;
+    AddEvents(&Doc, Result);
+    return Result;
+}
+
+const std::filesystem::path& SourcePath()
+{
+    static const auto Path = std::filesystem::temp_directory_path() / "TinyXmlSaxTest.xml";
+    return Path;
+}
+
+// The SAX reader makes the callbacks of the document parsed by the DOM, from memory and streamed from a file
+void CheckSameEvents(const std::string& Source)
+{
+    TiXmlDocument Doc;
+    Doc.Parse(Source.c_str());
+    TEST_CHECK(!Doc.Error());
+    const auto Expected = DocumentEvents(Doc);
+
+    CRecorder Recorder;
+    TiXmlSaxReader Reader(&Recorder);
+    TEST_CHECK(Reader.Parse(Source.c_str()) && !Reader.Stopped());
+    TEST_CHECK(Recorder.m_Events == Expected);
+
+    // New lines are normalized when a file is loaded, but not when memory is parsed
+    if(FILE* Fp = std::fopen(SourcePath().string().c_str(), "wb"))
+    {
+        std::fwrite(Source.data(), 1, Source.size(), Fp);
+        std::fclose(Fp);
+    }
+    TiXmlDocument FileDoc;
+    TEST_CHECK(FileDoc.LoadFile(SourcePath().string().c_str()));
+    CRecorder FileRecorder;
+    TiXmlSaxReader FileReader(&FileRecorder);
+    TEST_CHECK(FileReader.LoadFile(SourcePath().string().c_str()));
+    TEST_CHECK(FileRecorder.m_Events == DocumentEvents(FileDoc));
+}
+
+// Errors are reported like the DOM reports them
+void CheckSameError(const std::string& Source)
+{
+    TiXmlDocument Doc;
+    Doc.Parse(Source.c_str());
+    CRecorder Recorder;
+    TiXmlSaxReader Reader(&Recorder);
+    const bool Parsed = Reader.Parse(Source.c_str());
+    const bool Same = Doc.Error() && !Parsed && Reader.ErrorId() == Doc.ErrorId() && Reader.ErrorRow() == Doc.ErrorRow() && Reader.ErrorCol() == Doc.ErrorCol();
+    if(!Same)
+    {
+        std::fprintf(stderr, "SAX error %d at %d,%d instead of %d at %d,%d for\n%s\n", Reader.ErrorId(), Reader.ErrorRow(), Reader.ErrorCol(),
+                     Doc.ErrorId(), Doc.ErrorRow(), Doc.ErrorCol(), Source.c_str());
+    }
+    TEST_CHECK(Same);
+}
+
+// A random document of nested elements with attributes, texts, CDATA sections and comments
+std::string MakeDocument(std::mt19937& Random, int Elements)
+{
+    const char* const Texts[]{"plain", "a &amp; b", " spaced  out ", "&lt;&#x41;&#66;&gt;", "line\nbreak", "caf\xc3\xa9"};
+    const char* const Spaces[]{"", " ", "\n", "\r\n", "\t "};
+    std::string Xml = Random() % 2 ? "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n" : "";
+    std::vector<std::string> Open;
+    int Next{0};
+    while(Next < Elements || !Open.empty())
+    {
+        const auto Choice = Random() % 8;
+        if(Open.empty() || (Next < Elements && Choice < 3))
+        {
+            const auto Name = "e" + std::to_string(Next++ % 7);
+            Xml += "<" + Name;
+            const auto Attributes = Random() % 4;
+            for(unsigned Attribute = 0; Attribute < Attributes; ++Attribute)
+            {
+                const std::string Quote = Random() % 2 ? "\"" : "'";
+                Xml += std::string(Spaces[Random() % 5]) + " a" + std::to_string(Attribute) + "=" + Quote + Texts[Random() % 6] + Quote;
+            }
+            if(Random() % 5 == 0)
+            {
+                Xml += "/>";
+            }
+            else
+            {
+                Xml += ">";
+                Open.push_back(Name);
+            }
+        }
+        else if(Choice == 3)
+        {
+            Xml += Texts[Random() % 6];
+        }
+        else if(Choice == 4)
+        {
+            Xml += "<![CDATA[" + std::string(Texts[Random() % 6]) + "]]>";
+        }
+        else if(Choice == 5)
+        {
+            Xml += "<!-- comment " + std::to_string(Next) + " -->";
+        }
+        else
+        {
+            Xml += "</" + Open.back() + ">";
+            Open.pop_back();
+        }
+        Xml += Spaces[Random() % 5];
+    }
+    return Xml;
+}
+
+}
+
+int main()
+{
+    CheckSameEvents("<Zones>\n\t<Zone ZoneId=\"1\" ZoneName='Gate &quot;A&quot; &lt;&amp;&gt;'>\n\t\ttext &amp; &#x41;&#66;\n\t\t<![CDATA[<x>]]><!-- c -->\n\t</Zone>\n</Zones>");
+    CheckSameEvents("<?xml version=\"1.0\" ?><!-- before --><a x='1'><b/>tail<c></c></a><!-- after -->");
+    CheckSameEvents("<a>\r\n<b\r\n y=\"line\r\nbreak\">\r\n</b>\r</a>");
+
+    std::mt19937 Random(30);
+    for(int Document = 0; Document < 300; ++Document)
+    {
+        CheckSameEvents(MakeDocument(Random, 1 + Document % 40));
+    }
+
+    // Larger than the chunks of LoadFile (64k). Every byte of the repeated part ends the first chunk for one
+    // of the lengths of the leading comment, so every kind of item is split at every position.
+    const std::string Part{"<e a=\"v &amp; w\" b='x'>text &amp; more<![CDATA[cd]]><!-- c --><f/>\n</e>\n"};
+    std::string Large{"<r>"};
+    while(Large.size() < 70000)
+    {
+        Large += Part;
+    }
+    Large += "</r>";
+    for(std::size_t Shift = 0; Shift < Part.size(); ++Shift)
+    {
+        CheckSameEvents("<!--" + std::string(Shift, '-') + "-->" + Large);
+    }
+
+    // Items larger than a chunk
+    const std::string Long(150000, 'x');
+    CheckSameEvents("<a>" + Long + "<!--" + Long + "--><![CDATA[" + Long + "]]><b c=\"" + Long + "\"/></a>");
+
+    // A handler which stops the parse gets the start of the events, and no error
+    const auto Source = MakeDocument(Random, 30);
+    TiXmlDocument Doc;
+    Doc.Parse(Source.c_str());
+    const auto Expected = DocumentEvents(Doc);
+    for(int StopAfter = 1; StopAfter <= static_cast<int>(Expected.size()); StopAfter += 7)
+    {
+        CRecorder Recorder(StopAfter);
+        TiXmlSaxReader Reader(&Recorder);
+        TEST_CHECK(Reader.Parse(Source.c_str()) && Reader.Stopped());
+        TEST_CHECK(Events(Expected.begin(), Expected.begin() + StopAfter) == Recorder.m_Events);
+    }
+
+    CheckSameError("");
+    CheckSameError("<a><b></a>");
+    CheckSameError("<a>\n  <b x=\"1></b>\n</a>");
+    CheckSameError("<a>text");
+    CheckSameError("<a b></a>");
+
+    // Reported where the DOM only finds the element unfinished, or accepts a document without an element
+    for(const char* Source : {"<a>\n<![CDATA[ open", "<?xml version=\"1.0\""})
+    {
+        CRecorder Recorder;
+        TiXmlSaxReader Reader(&Recorder);
+        TEST_CHECK(!Reader.Parse(Source) && Reader.Error());
+    }
+
+    std::filesystem::remove(SourcePath());
+    return TestFailures();
+}
@@ -0,0 +1,257 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "../TinyXml/tinyxml.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+// The program is built twice, with the SIMD scanners of the parser (TinyXmlScanTest) and with
+// TIXML_NO_SIMD (TinyXmlScanTestNoSimd). Run with --dump, it prints a hash of every parse. The test
+// compares its own parses with the ones printed by the program in TINYXML_SCAN_REFERENCE.
+
+namespace
+{
+
+// A random document with runs of white space, names and text of every length around the vector widths
+std::string MakeDocument(std::mt19937& Random)
+{
+    const char* const Pieces[]{"&amp;", "&lt;", "&#x41;", "&#66;", "caf\xc3\xa9", "\t", "\n", "  ", ">", "'", "\""};
+    auto Run = [&Random](char First, char Other, std::size_t Length)
+    {
+        std::string Result(1, First);
+        Result.append(Length, Other);
+        return Result;
+    };
+    auto Text = [&]()
+    {
+        std::string Result;
+        const auto Count = Random() % 4;
+        for(unsigned Piece = 0; Piece < Count; ++Piece)
+        {
+            Result += Run('t', "xy _-.:"[Random() % 7], Random() % 70);
+            Result += Pieces[Random() % 11];
+        }
+        return Result;
+    };
+    auto Space = [&]() { return std::string(Random() % 40, " \t\n"[Random() % 3]); };
+
+    std::string Xml = Space();
+    std::vector<std::string> Open;
+    int Elements{0};
+    while(Elements < 12 || !Open.empty())
+    {
+        const auto Choice = Random() % 6;
+        if(Open.empty() || (Elements < 12 && Choice < 2))
+        {
+            const auto Name = Run('e', "abc_-.:9"[Random() % 8], Random() % 70);
+            Xml += "<" + Name;
+            const auto Attributes = Random() % 3;
+            for(unsigned Attribute = 0; Attribute < Attributes; ++Attribute)
+            {
+                auto Value = Text();
+                for(auto& Character : Value)
+                {
+                    Character = Character == '"' ? 'q' : Character;
+                }
+                Xml += Space() + " " + Run('a', 'n', Random() % 40) + std::to_string(Attribute) + Space() + "=" + Space() + "\"" + Value + "\"";
+            }
+            Xml += Space();
+            ++Elements;
+            if(Random() % 4 == 0)
+            {
+                Xml += "/>";
+            }
+            else
+            {
+                Xml += ">";
+                Open.push_back(Name);
+            }
+        }
+        else if(Choice == 2)
+        {
+            Xml += Text();
+        }
+        else if(Choice == 3)
+        {
+            Xml += "<!--" + Text() + "-->";
+        }
+        else
+        {
+            Xml += "</" + Open.back() + Space() + ">";
+            Open.pop_back();
+        }
+        Xml += Space();
+    }
+
+    // Truncated or damaged documents end the scans at the terminator
+    const auto Damage = Random() % 4;
+    if(Damage == 1)
+    {
+        Xml.resize(Random() % Xml.size());
+    }
+    else if(Damage == 2)
+    {
+        Xml[Random() % Xml.size()] = "<>&\"="[Random() % 5];
+    }
+    return Xml;
+}
+
+std::vector<std::string> MakeDocuments()
+{
+    std::vector<std::string> Documents{"", " ", "<a/>", "<a>\n</a>", std::string(100, ' ') + "<a>" + std::string(100, 'x') + "</a>"};
+    std::mt19937 Random(34);
+    for(int Document = 0; Document < 400; ++Document)
+    {
+        Documents.push_back(MakeDocument(Random));
+    }
+    return Documents;
+}
+
+// The locations of the nodes below a node
+void AddLocations(const TiXmlNode* Node, std::string& Result)
+{
+    for(const TiXmlNode* Child = Node->FirstChild(); Child; Child = Child->NextSibling())
+    {
+        Result += " " + std::to_string(Child->Row()) + "," + std::to_string(Child->Column());
+        AddLocations(Child, Result);
+    }
+}
+
+// Parse the source placed at Offset in a buffer, or if Offset is negative, so that its terminator
+// is the last byte before an unreadable page (where the system allows it)
+std::string Parse(const std::string& Source, int Mode, int Offset)
+{
+    TiXmlDocument Doc;
+    TiXmlParseOptions Options;
+    Options.condenseWhiteSpace = Mode != 1;
+    Doc.SetParseOptions(Options);
+    Doc.SetInSitu(Mode == 2);
+
+    const auto Length = Source.size() + 1;
+#if defined( __unix__ ) || defined( __APPLE__ )
+    if(Offset < 0)
+    {
+        const auto Page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const auto Pages = (Length + Page - 1)/Page;
+        void* Mapped = mmap(nullptr, (Pages + 1)*Page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(Mapped == MAP_FAILED)
+        {
+            return "no memory";
+        }
+        char* Memory = static_cast<char*>(Mapped);
+        mprotect(Memory + Pages*Page, Page, PROT_NONE);
+        std::memcpy(Memory + Pages*Page - Length, Source.c_str(), Length);
+        Doc.Parse(Memory + Pages*Page - Length);
+        munmap(Memory, (Pages + 1)*Page);
+    }
+    else
+#endif
+    {
+        Offset = Offset < 0 ? 0 : Offset;
+        std::vector<char> Buffer(Offset + Length);
+        std::memcpy(Buffer.data() + Offset, Source.c_str(), Length);
+        Doc.Parse(Buffer.data() + Offset);
+    }
+
+    if(Doc.Error())
+    {
+        return "error " + std::to_string(Doc.ErrorId()) + " at " + std::to_string(Doc.ErrorRow()) + "," + std::to_string(Doc.ErrorCol());
+    }
+    TiXmlPrinter Printer;
+    Doc.Accept(&Printer);
+    std::string Result = Printer.CStr();
+    AddLocations(&Doc, Result);
+    return Result;
+}
+
+std::uint64_t Hash(const std::string& Text)
+{
+    std::uint64_t Result{14695981039346656037ull};
+    for(const unsigned char Character : Text)
+    {
+        Result = (Result ^ Character)*1099511628211ull;
+    }
+    return Result;
+}
+
+// The hashes of the parses of every document in every mode, which do not depend on the placement
+// of the document: the offsets and the end of a page give the same parse.
+std::vector<std::uint64_t> ParseHashes(const std::vector<std::string>& Documents)
+{
+    std::vector<std::uint64_t> Hashes;
+    for(std::size_t Document = 0; Document < Documents.size(); ++Document)
+    {
+        for(int Mode = 0; Mode < 3; ++Mode)
+        {
+            const auto Expected = Parse(Documents[Document], Mode, 0);
+            for(const int Offset : {1, 7, 15, 31, -1})
+            {
+                if(Parse(Documents[Document], Mode, Offset) != Expected)
+                {
+                    std::fprintf(stderr, "document %zu mode %d parses differently at offset %d\n", Document, Mode, Offset);
+                    ++TestFailures();
+                }
+            }
+            Hashes.push_back(Hash(Expected));
+        }
+    }
+    return Hashes;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const auto Documents = MakeDocuments();
+    const auto Hashes = ParseHashes(Documents);
+    if(argc > 1 && std::strcmp(argv[1], "--dump") == 0)
+    {
+        for(const auto Value : Hashes)
+        {
+            std::printf("%llu\n", static_cast<unsigned long long>(Value));
+        }
+        return TestFailures();
+    }
+
+    const char* Reference = std::getenv("TINYXML_SCAN_REFERENCE");
+    if(!Reference)
+    {
+        std::fprintf(stderr, "TINYXML_SCAN_REFERENCE is not set, only the placements are compared\n");
+        return TestFailures();
+    }
+    const auto DumpPath = std::filesystem::temp_directory_path() / "TinyXmlScanTest.txt";
+    TEST_CHECK(std::system(("\"" + std::string(Reference) + "\" --dump > \"" + DumpPath.string() + "\"").c_str()) == 0);
+
+    std::ifstream Ifs(DumpPath);
+    std::vector<std::uint64_t> ReferenceHashes;
+    unsigned long long Value{0};
+    while(Ifs >> Value)
+    {
+        ReferenceHashes.push_back(Value);
+    }
+    TEST_CHECK(ReferenceHashes.size() == Hashes.size());
+    for(std::size_t i = 0; i < Hashes.size() && i < ReferenceHashes.size(); ++i)
+    {
+        if(Hashes[i] != ReferenceHashes[i])
+        {
+            std::fprintf(stderr, "mode %zu parses differently with the scalar code:\n%s\n", i%3, Documents[i/3].c_str());
+            ++TestFailures();
+        }
+    }
+    Ifs.close();
+    std::filesystem::remove(DumpPath);
+    return TestFailures();
+}
@@ -0,0 +1,173 @@
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "../../TinyXml/tinyxml.h"
+#include "../TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+// A stream buffer which gives one character per underflow, so every read of StreamIn reaches the end of the buffer
+class COneByteBuffer : public std::streambuf
+{
+public:
+    explicit COneByteBuffer(const std::string& Source) : m_Source{Source} {}
+
+protected:
+    int_type underflow() override
+    {
+        if(m_Next == m_Source.size())
+        {
+            return traits_type::eof();
+        }
+        m_Current = m_Source[m_Next++];
+        setg(&m_Current, &m_Current, &m_Current + 1);
+        return traits_type::to_int_type(m_Current);
+    }
+
+private:
+    std::string m_Source;
+    std::size_t m_Next{0};
+    char m_Current{0};
+};
+
+std::string Print(const TiXmlDocument& Doc)
+{
+    TiXmlPrinter Printer;
+    Doc.Accept(&Printer);
+    return Printer.CStr();
+}
+
+std::string Rest(std::istream& In)
+{
+    return std::string(std::istreambuf_iterator<char>(In), std::istreambuf_iterator<char>());
+}
+
+// Reading a document from a stream gives the tree of its parse and leaves what follows the root element
+void CheckSameDocument(const std::string& Source)
+{
+    TiXmlDocument Expected;
+    Expected.Parse(Source.c_str());
+    TEST_CHECK(!Expected.Error());
+    const auto Printed = Print(Expected);
+
+    const std::string Following{"<next a='1'/>\n"};
+    std::istringstream In(Source + Following);
+    TiXmlDocument Streamed;
+    In >> Streamed;
+    const bool Same = !Streamed.Error() && Print(Streamed) == Printed;
+    if(!Same)
+    {
+        std::fprintf(stderr, "streamed document differs (error '%s') for\n%s\n", Streamed.ErrorDesc(), Source.c_str());
+    }
+    TEST_CHECK(Same);
+    TEST_CHECK(Rest(In) == Following);
+
+    COneByteBuffer Buffer(Source + Following);
+    std::istream OneByte(&Buffer);
+    TiXmlDocument SlowlyStreamed;
+    OneByte >> SlowlyStreamed;
+    TEST_CHECK(!SlowlyStreamed.Error() && Print(SlowlyStreamed) == Printed);
+    TEST_CHECK(Rest(OneByte) == Following);
+}
+
+// A random document of nested elements with attributes, texts, CDATA sections, comments and unknown nodes.
+// A '>' in an attribute value ends the tag for StreamIn, as it always did, so values use &gt;
+std::string MakeDocument(std::mt19937& Random, int Elements, std::size_t LongText)
+{
+    const char* const Texts[]{"plain", "a &amp; b", " spaced  out ", "&lt;&#x41;&#66;&gt;", "line\nbreak", "caf\xc3\xa9", "- -- ->"};
+    const char* const Spaces[]{"", " ", "\n", "\r\n", "\t "};
+    std::string Xml = Random() % 2 ? "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n" : "";
+    if(Random() % 2)
+    {
+        Xml += "<!-- before -- the > root -->\n<!DOCTYPE root>\n";
+    }
+    Xml += "<root>";
+    std::vector<std::string> Open{"root"};
+    int Next{0};
+    while(Next < Elements || Open.size() > 1)
+    {
+        const auto Choice = Random() % 8;
+        if(Open.size() == 1 || (Next < Elements && Choice < 3))
+        {
+            const auto Name = "e" + std::to_string(Next++ % 7);
+            Xml += "<" + Name;
+            const auto Attributes = Random() % 4;
+            for(unsigned Attribute = 0; Attribute < Attributes; ++Attribute)
+            {
+                const std::string Quote = Random() % 2 ? "\"" : "'";
+                Xml += std::string(Spaces[Random() % 5]) + " a" + std::to_string(Attribute) + "=" + Quote + Texts[Random() % 4] + Quote;
+            }
+            if(Random() % 5 == 0)
+            {
+                Xml += "/>";
+            }
+            else
+            {
+                Xml += ">";
+                Open.push_back(Name);
+            }
+        }
+        else if(Choice == 3)
+        {
+            Xml += Random() % 10 ? std::string(Texts[Random() % 7]) : std::string(LongText, 'x');
+        }
+        else if(Choice == 4)
+        {
+            Xml += "<![CDATA[" + std::string(Texts[Random() % 7]) + (Random() % 10 ? "" : std::string(LongText, ']')) + "]]>";
+        }
+        else if(Choice == 5)
+        {
+            Xml += "<!-- comment " + std::to_string(Next) + (Random() % 10 ? " -" : std::string(LongText, '-') + ">") + " -->";
+        }
+        else
+        {
+            Xml += "</" + Open.back() + ">";
+            Open.pop_back();
+        }
+        Xml += Spaces[Random() % 5];
+    }
+    return Xml + "</root>";
+}
+
+// Input which ends inside a node, or has a null character in the content of an element, is an error and does not hang
+void CheckStreamError(const std::string& Source)
+{
+    std::istringstream In(Source);
+    TiXmlDocument Doc;
+    In >> Doc;
+    TEST_CHECK(Doc.Error());
+}
+
+}
+
+int main()
+{
+    CheckSameDocument("<Zones>\n\t<Zone ZoneId=\"1\" ZoneName='Gate &quot;A&quot; &lt;&amp;&gt;'>\n\t\ttext &amp; &#x41;&#66;\n\t\t<![CDATA[<x>]]><!-- c -->\n\t</Zone>\n</Zones>");
+    CheckSameDocument("<?xml version=\"1.0\" ?><!-- before --><a x='1'><b/>tail<c></c></a>");
+
+    std::mt19937 Random(42);
+    for(int Document = 0; Document < 300; ++Document)
+    {
+        CheckSameDocument(MakeDocument(Random, 1 + Document % 40, 10));
+    }
+
+    // Nodes much longer than the blocks StreamIn copies (4K)
+    for(int Document = 0; Document < 20; ++Document)
+    {
+        CheckSameDocument(MakeDocument(Random, 30, 3000 + 1000 * Document));
+    }
+
+    CheckStreamError("<a><b>text");
+    CheckStreamError("<a><!-- comment");
+    CheckStreamError("<a><![CDATA[ data");
+    CheckStreamError(std::string("<a>text\0more</a>", 16));
+    return TestFailures();
+}
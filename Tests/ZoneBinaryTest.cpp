@@ -0,0 +1,195 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../ZoneBinary.h"
+#include "../ZoneConfig.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+using ZoneMap = std::map<int, CMouseEvents::SZone>;
+
+CMouseEvents::ZonesType MakeZones()
+{
+    CMouseEvents::ZonesType Zones;
+    for(int ZoneId : {2, 3, 7, 11, 40})
+    {
+        CMouseEvents::SZone Zone;
+        Zone.s_ZoneId = ZoneId;
+        Zone.s_ZoneName = ZoneId == 7 ? "Gate \"A\" <&>" : ZoneId == 11 ? "" : "Zone " + std::to_string(ZoneId);
+        for(int Vertex = 0; Vertex < 3 + ZoneId%4; ++Vertex)
+        {
+            Zone.s_Lines.emplace_back(CMouseEvents::PointType(10*Vertex, ZoneId), CMouseEvents::PointType(10*(Vertex + 1), ZoneId + Vertex));
+        }
+        // Closed polygon, the XML format stores the points of a closed polygon
+        Zone.s_Lines.back().second = Zone.s_Lines.front().first;
+        for(std::size_t Line = 1; Line < Zone.s_Lines.size(); ++Line)
+        {
+            Zone.s_Lines[Line].first = Zone.s_Lines[Line - 1].second;
+        }
+        Zone.Rotate(ZoneId);
+        Zones.Set(ZoneId, Zone);
+    }
+    return Zones;
+}
+
+bool SamePoint(const CMouseEvents::PointType& P1, const CMouseEvents::PointType& P2)
+{
+    return P1.x == P2.x && P1.y == P2.y;
+}
+
+void CheckSameZones(const ZoneMap& Loaded, const CMouseEvents::ZonesType& Expected)
+{
+    TEST_CHECK(Loaded.size() == Expected.Size());
+    for(const auto& [ZoneId, Zone] : Expected)
+    {
+        auto It = Loaded.find(ZoneId);
+        TEST_CHECK(It != Loaded.end());
+        if(It == Loaded.end())
+        {
+            continue;
+        }
+        const auto& Read = It->second;
+        TEST_CHECK(Read.s_ZoneName == Zone.s_ZoneName);
+        TEST_CHECK(Read.s_Angle == Zone.s_Angle);
+        TEST_CHECK(SamePoint(Read.GetCenter(), Zone.GetCenter()));
+        TEST_CHECK(SamePoint(Read.GetArrowHead(), Zone.GetArrowHead()));
+        TEST_CHECK(Read.s_Lines.size() == Zone.s_Lines.size());
+        for(std::size_t Line = 0; Line < std::min(Read.s_Lines.size(), Zone.s_Lines.size()); ++Line)
+        {
+            TEST_CHECK(SamePoint(Read.s_Lines[Line].first, Zone.s_Lines[Line].first));
+            TEST_CHECK(SamePoint(Read.s_Lines[Line].second, Zone.s_Lines[Line].second));
+        }
+    }
+}
+
+std::vector<char> ReadFile(const std::string& FileName)
+{
+    std::ifstream Ifs(FileName, std::ifstream::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(Ifs), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& FileName, const std::vector<char>& Content)
+{
+    std::ofstream(FileName, std::ofstream::binary | std::ofstream::trunc).write(Content.data(), static_cast<std::streamsize>(Content.size()));
+}
+
+// Binary -> XML -> binary gives the same zones and the same file
+void TestRoundTrip(const std::filesystem::path& Directory)
+{
+    const auto Zones = MakeZones();
+    const auto BinaryPath = (Directory / "Zones.bin").string();
+    const auto XMLPath = (Directory / "Zones.xml").string();
+    const auto BinaryAgainPath = (Directory / "ZonesAgain.bin").string();
+
+    TEST_CHECK(WriteConfigBinary(BinaryPath, Zones));
+    TEST_CHECK(IsBinaryConfigFile(BinaryPath));
+    TEST_CHECK(ConvertBinaryToXML(BinaryPath, XMLPath));
+    TEST_CHECK(!IsBinaryConfigFile(XMLPath));
+    TEST_CHECK(ConvertXMLToBinary(XMLPath, BinaryAgainPath));
+    TEST_CHECK(ReadFile(BinaryPath) == ReadFile(BinaryAgainPath));
+
+    for(const auto& Path : {BinaryPath, XMLPath, BinaryAgainPath})
+    {
+        ZoneMap Loaded;
+        TEST_CHECK(ReadConfig(Path, Loaded));
+        CheckSameZones(Loaded, Zones);
+    }
+
+    CZoneBinaryView View;
+    TEST_CHECK(View.Open(BinaryPath));
+    TEST_CHECK(View.Find(7) && View.ZoneName(*View.Find(7)) == "Gate \"A\" <&>");
+    TEST_CHECK(View.Find(40) && *View.Find(40) == 4);
+    TEST_CHECK(!View.Find(5) && !View.Find(1) && !View.Find(41));
+}
+
+// Damaged files are rejected by Open instead of returning wrong zones
+void TestDamagedFiles(const std::filesystem::path& Directory)
+{
+    const auto ValidPath = (Directory / "Valid.bin").string();
+    const auto DamagedPath = (Directory / "Damaged.bin").string();
+    TEST_CHECK(WriteConfigBinary(ValidPath, MakeZones()));
+    const auto Valid = ReadFile(ValidPath);
+    SZoneBinaryHeader Header;
+    std::memcpy(&Header, Valid.data(), sizeof(Header));
+
+    auto EntryAt = [&Header](std::vector<char>& File, std::size_t Index)
+    {
+        return reinterpret_cast<SZoneBinaryEntry*>(File.data() + Header.s_IdTableOffset + Index*sizeof(SZoneBinaryEntry));
+    };
+    auto HeaderOf = [](std::vector<char>& File) { return reinterpret_cast<SZoneBinaryHeader*>(File.data()); };
+
+    const std::vector<std::pair<const char*, std::function<void(std::vector<char>&)>>> Damages{
+        {"truncated", [](std::vector<char>& File) { File.resize(File.size() - 1); }},
+        {"version", [&](std::vector<char>& File) { ++HeaderOf(File)->s_Version; }},
+        {"ids not sorted", [&](std::vector<char>& File) { std::swap(EntryAt(File, 1)->s_ZoneId, EntryAt(File, 2)->s_ZoneId); }},
+        {"duplicate id", [&](std::vector<char>& File) { EntryAt(File, 2)->s_ZoneId = EntryAt(File, 1)->s_ZoneId; }},
+        {"odd first vertex", [&](std::vector<char>& File) { ++EntryAt(File, 1)->s_FirstVertex; }},
+        {"odd vertex count", [&](std::vector<char>& File) { --EntryAt(File, 1)->s_VertexCount; }},
+        {"vertices out of range", [&](std::vector<char>& File) { EntryAt(File, 4)->s_VertexCount += 2; }},
+        {"name out of range", [&](std::vector<char>& File) { EntryAt(File, 4)->s_NameOffset = HeaderOf(File)->s_StringPoolSize; }},
+        {"name not terminated", [&](std::vector<char>& File) { ++EntryAt(File, 0)->s_NameLength; }},
+        {"misaligned table", [&](std::vector<char>& File) { HeaderOf(File)->s_VertexOffset += 4; }},
+        {"table in header", [&](std::vector<char>& File) { HeaderOf(File)->s_IdTableOffset = 0; }},
+    };
+
+    CZoneBinaryView View;
+    TEST_CHECK(View.Open(ValidPath));
+    for(const auto& [Name, Damage] : Damages)
+    {
+        auto Damaged = Valid;
+        Damage(Damaged);
+        WriteFile(DamagedPath, Damaged);
+        ZoneMap Loaded;
+        const bool Opened = View.Open(DamagedPath) || ReadConfigBinary(DamagedPath, Loaded);
+        if(Opened)
+        {
+            std::fprintf(stderr, "damaged file accepted: %s\n", Name);
+        }
+        TEST_CHECK(!Opened);
+    }
+}
+
+
+// Writes which fail, also only when the file is flushed, are reported
+void TestFailedWrites(const std::filesystem::path& Directory)
+{
+    const auto Zones = MakeZones();
+    const auto BinaryPath = (Directory / "Valid.bin").string();
+    TEST_CHECK(WriteConfigBinary(BinaryPath, Zones));
+
+    const auto DirectoryPath = (Directory / "Directory").string();
+    std::filesystem::create_directory(DirectoryPath);
+    TEST_CHECK(!WriteConfigBinary(DirectoryPath, Zones));
+    TEST_CHECK(!ConvertBinaryToXML(BinaryPath, DirectoryPath));
+
+    // Accepts the file but not the data, the small files stay in the stream buffer until closed
+    const std::string FullDevice{"/dev/full"};
+    if(std::filesystem::exists(FullDevice))
+    {
+        TEST_CHECK(!WriteConfigBinary(FullDevice, Zones));
+        TEST_CHECK(!ConvertBinaryToXML(BinaryPath, FullDevice));
+    }
+}
+
+}
+
+int main()
+{
+    const auto Directory = std::filesystem::temp_directory_path() / "ZoneBinaryTest";
+    std::filesystem::remove_all(Directory);
+    std::filesystem::create_directories(Directory);
+
+    TestRoundTrip(Directory);
+    TestDamagedFiles(Directory);
+    TestFailedWrites(Directory);
+    return TestFailures();
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../TinyXml/tinyxml.h"
+#include "../ZoneBinary.h"
+#include "../ZoneConfig.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+using ZoneMap = std::map<int, CMouseEvents::SZone>;
+
+// Different zones for every file, so that the results of two files cannot be mistaken for each other
+CMouseEvents::ZonesType MakeZones(int File)
+{
+    CMouseEvents::ZonesType Zones;
+    for(int Zone = 0; Zone < 1 + File % 5; ++Zone)
+    {
+        CMouseEvents::SZone Added;
+        Added.s_ZoneId = 100 * File + Zone;
+        Added.s_ZoneName = "File " + std::to_string(File) + "  zone " + std::to_string(Zone);
+        for(int Vertex = 0; Vertex < 3 + Zone % 3; ++Vertex)
+        {
+            Added.s_Lines.emplace_back(CMouseEvents::PointType(10 * Vertex + File, Zone), CMouseEvents::PointType(10 * (Vertex + 1) + File, Zone + Vertex));
+        }
+        Added.s_Lines.back().second = Added.s_Lines.front().first;
+        for(std::size_t Line = 1; Line < Added.s_Lines.size(); ++Line)
+        {
+            Added.s_Lines[Line].first = Added.s_Lines[Line - 1].second;
+        }
+        Added.Rotate(File + Zone);
+        Zones.Set(Added.s_ZoneId, Added);
+    }
+    return Zones;
+}
+
+bool SamePoint(const CMouseEvents::PointType& P1, const CMouseEvents::PointType& P2)
+{
+    return P1.x == P2.x && P1.y == P2.y;
+}
+
+bool SameZones(const ZoneMap& Read, const ZoneMap& Expected)
+{
+    if(Read.size() != Expected.size())
+    {
+        return false;
+    }
+    for(const auto& [ZoneId, Zone] : Expected)
+    {
+        const auto It = Read.find(ZoneId);
+        if(It == Read.end() || It->second.s_ZoneName != Zone.s_ZoneName || It->second.s_Angle != Zone.s_Angle ||
+           !SamePoint(It->second.GetCenter(), Zone.GetCenter()) || !SamePoint(It->second.GetArrowHead(), Zone.GetArrowHead()) ||
+           It->second.s_Lines.size() != Zone.s_Lines.size())
+        {
+            return false;
+        }
+        for(std::size_t Line = 0; Line < Zone.s_Lines.size(); ++Line)
+        {
+            if(!SamePoint(It->second.s_Lines[Line].first, Zone.s_Lines[Line].first) || !SamePoint(It->second.s_Lines[Line].second, Zone.s_Lines[Line].second))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// XML and binary files, and files which cannot be read: missing, a directory, truncated XML and binary
+std::vector<std::string> MakeFiles(const std::filesystem::path& Directory)
+{
+    std::vector<std::string> FileNames;
+    for(int File = 0; File < 40; ++File)
+    {
+        const auto Path = (Directory / ("Camera" + std::to_string(File))).string();
+        const auto Zones = MakeZones(File);
+        switch(File % 8)
+        {
+        case 5:
+            FileNames.push_back(Path + ".missing");
+            continue;
+        case 6:
+            std::filesystem::create_directory(Path);
+            break;
+        case 7:
+        {
+            std::ostringstream Oss;
+            WriteConfigXML(Oss, Zones);
+            const auto Xml = Oss.str();
+            std::ofstream(Path, std::ofstream::binary) << Xml.substr(0, Xml.size() / 2);
+            break;
+        }
+        default:
+            if(File % 2)
+            {
+                TEST_CHECK(WriteConfigBinary(Path, Zones));
+                if(File % 8 == 3)
+                {
+                    std::filesystem::resize_file(Path, std::filesystem::file_size(Path) - 4);
+                }
+            }
+            else
+            {
+                std::ofstream Ofs(Path, std::ofstream::binary);
+                WriteConfigXML(Ofs, Zones);
+            }
+            break;
+        }
+        FileNames.push_back(Path);
+    }
+    return FileNames;
+}
+
+// Parses a text with the options given to the document, or with the global settings
+std::string ParsedText(const char* Xml, const TiXmlParseOptions* Options)
+{
+    TiXmlDocument Doc;
+    if(Options)
+    {
+        Doc.SetParseOptions(*Options);
+    }
+    Doc.Parse(Xml);
+    const TiXmlElement* Root = Doc.RootElement();
+    return Root && Root->GetText() ? Root->GetText() : "";
+}
+
+// ReadConfigs gives the results of ReadConfig in the order of the files, for any number of threads. No parse
+// leaves its options behind on the thread, and the options of documents parsed meanwhile are their own.
+void TestReadConfigs(const std::filesystem::path& Directory)
+{
+    const auto FileNames = MakeFiles(Directory);
+    std::vector<std::optional<ZoneMap>> Expected;
+    int Unreadable{0};
+    for(const auto& FileName : FileNames)
+    {
+        ZoneMap Zones;
+        Expected.push_back(ReadConfig(FileName, Zones) ? std::optional<ZoneMap>(Zones) : std::nullopt);
+        Unreadable += Expected.back() ? 0 : 1;
+    }
+    TEST_CHECK(Unreadable == 20);
+    for(std::size_t File = 0; File < Expected.size(); ++File)
+    {
+        if(Expected[File])
+        {
+            const auto Zones = MakeZones(static_cast<int>(File));
+            TEST_CHECK(SameZones(*Expected[File], ZoneMap(Zones.begin(), Zones.end())));
+        }
+    }
+
+    // The zone reader has its own options, other parses use the global settings or theirs
+    TiXmlBase::SetCondenseWhiteSpace(false);
+    const char* const Spaced{"<a>  spaced   out  </a>"};
+    TiXmlParseOptions Condensing;
+    std::atomic<bool> Reading{true};
+    std::atomic<int> WrongTexts{0};
+    std::thread Parser([&]()
+    {
+        while(Reading)
+        {
+            WrongTexts += ParsedText(Spaced, &Condensing) != "spaced out";
+            WrongTexts += ParsedText(Spaced, nullptr) != "  spaced   out  ";
+            std::this_thread::yield();
+        }
+    });
+
+    for(unsigned ThreadCount : {1u, 2u, 3u, 8u, 0u})
+    {
+        for(int Run = 0; Run < 5; ++Run)
+        {
+            const auto Configs = ReadConfigs(FileNames, ThreadCount);
+            TEST_CHECK(Configs.size() == FileNames.size());
+            for(std::size_t File = 0; File < std::min(Configs.size(), Expected.size()); ++File)
+            {
+                const bool Same = Configs[File].has_value() == Expected[File].has_value() && (!Configs[File] || SameZones(*Configs[File], *Expected[File]));
+                if(!Same)
+                {
+                    std::fprintf(stderr, "%u threads: wrong result for %s\n", ThreadCount, FileNames[File].c_str());
+                }
+                TEST_CHECK(Same);
+            }
+
+            // The calling thread is one of the workers
+            TEST_CHECK(!TiXmlParseOptions::Current() && !TiXmlBase::IsWhiteSpaceCondensed());
+        }
+    }
+    Reading = false;
+    Parser.join();
+    TEST_CHECK(WrongTexts == 0);
+    TiXmlBase::SetCondenseWhiteSpace(true);
+
+    TEST_CHECK(ReadConfigs({}, 4).empty());
+}
+
+}
+
+int main()
+{
+    const auto Directory = std::filesystem::temp_directory_path() / "ZoneConfigTest";
+    std::filesystem::remove_all(Directory);
+    std::filesystem::create_directories(Directory);
+
+    TestReadConfigs(Directory);
+    return TestFailures();
+}
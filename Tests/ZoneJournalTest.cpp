@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "../ZoneConfig.h"
+#include "../ZoneJournal.h"
+#include "TestCheck.h"
+
+using namespace mouseevents;
+
+namespace
+{
+
+using ZoneMap = std::map<int, CMouseEvents::SZone>;
+
+const std::string HostileName{"  Gate \"A\" <&> 'B' &amp; &#x41; \t]]> "};
+
+CMouseEvents::SZone MakeZone(int ZoneId, const std::string& ZoneName)
+{
+    CMouseEvents::SZone Zone;
+    Zone.s_ZoneId = ZoneId;
+    Zone.s_ZoneName = ZoneName;
+    Zone.s_Lines = {{{0, 0}, {100 + ZoneId, 0}}, {{100 + ZoneId, 0}, {100, 100}}, {{100, 100}, {0, 0}}};
+    return Zone;
+}
+
+std::string ReadFile(const std::filesystem::path& Path)
+{
+    std::ifstream Ifs(Path, std::ifstream::binary);
+    return std::string(std::istreambuf_iterator<char>(Ifs), std::istreambuf_iterator<char>());
+}
+
+// A fresh directory for the files of one test
+std::filesystem::path MakeDirectory(const std::string& Name)
+{
+    auto Directory = std::filesystem::temp_directory_path() / ("ZoneJournalTest" + Name);
+    std::filesystem::remove_all(Directory);
+    std::filesystem::create_directories(Directory);
+    return Directory;
+}
+
+// Exact comparison, operator== of the application treats nearby points as equal
+bool SameLines(const CMouseEvents::LinesType& Lines1, const CMouseEvents::LinesType& Lines2)
+{
+    auto Same = [](const CMouseEvents::PointType& P1, const CMouseEvents::PointType& P2) { return P1.x == P2.x && P1.y == P2.y; };
+    return std::equal(Lines1.cbegin(), Lines1.cend(), Lines2.cbegin(), Lines2.cend(),
+                      [&Same](const auto& L1, const auto& L2) { return Same(L1.first, L2.first) && Same(L1.second, L2.second); });
+}
+
+void CheckSameZones(const ZoneMap& Loaded, const CMouseEvents::ZonesType& Expected)
+{
+    TEST_CHECK(Loaded.size() == Expected.Size());
+    for(const auto& [ZoneId, Zone] : Expected)
+    {
+        auto It = Loaded.find(ZoneId);
+        TEST_CHECK(It != Loaded.end());
+        if(It != Loaded.end())
+        {
+            TEST_CHECK(It->second.s_ZoneName == Zone.s_ZoneName);
+            TEST_CHECK(SameLines(It->second.s_Lines, Zone.s_Lines));
+            TEST_CHECK(It->second.s_Angle == Zone.s_Angle);
+        }
+    }
+}
+
+// Edits survive a restart through the journal alone and through compactions, whatever the names contain
+void TestReplay(bool Compact)
+{
+    const auto ConfigPath = (MakeDirectory(Compact ? "Compact" : "Replay") / "Config.xml").string();
+    CMouseEvents::ZonesType Zones;
+    {
+        CZoneJournal Journal(ConfigPath, Compact ? 3 : 1000);
+        ZoneMap Loaded;
+        Journal.Load(Loaded);
+        TEST_CHECK(Loaded.empty());
+        for(int ZoneId = 1; ZoneId <= 8; ++ZoneId)
+        {
+            auto Zone = MakeZone(ZoneId, ZoneId == 1 ? HostileName : "Zone " + std::to_string(ZoneId));
+            Zone.Rotate(15*ZoneId);
+            Zones.Set(ZoneId, Zone);
+            Journal.Add(Zone);
+            Journal.Rotate(ZoneId, Zone.s_Angle);
+            Journal.CompactIfNeeded(Zones);
+        }
+        Journal.Delete(3);
+        Zones.Erase(3);
+        auto Renamed = *Zones.Find(4);
+        Renamed.s_ZoneName = HostileName + "4";
+        Zones.Set(4, Renamed);
+        Journal.Rename(4, Renamed.s_ZoneName);
+    }
+
+    CZoneJournal Journal(ConfigPath);
+    ZoneMap Loaded;
+    Journal.Load(Loaded);
+    CheckSameZones(Loaded, Zones);
+
+    // The replayed edits were folded into a configuration which can be read on its own
+    ZoneMap Config;
+    TEST_CHECK(ReadConfig(ConfigPath, Config));
+    CheckSameZones(Config, Zones);
+}
+
+// A configuration which cannot be read is neither replaced by the journal nor by a compaction
+void TestUnreadableConfig()
+{
+    const auto Directory = MakeDirectory("Unreadable");
+    const auto ConfigPath = (Directory / "Config.xml").string();
+    const std::string Broken{"<Zones><Zone ZoneId=\"1\" ZoneName=\"Gate \"A\"\"/></Zones>"};
+    std::ofstream(ConfigPath) << Broken;
+    std::ofstream(ConfigPath + ".journal") << "A 6 0 3 0 0 50 0 50 0 50 50 50 50 0 0 Six\n";
+
+    CMouseEvents::ZonesType Zones;
+    {
+        CZoneJournal Journal(ConfigPath, 1);
+        ZoneMap Loaded;
+        Journal.Load(Loaded);
+        TEST_CHECK(Loaded.size() == 1 && Loaded.count(6) == 1);
+        Zones = CMouseEvents::ZonesType(Loaded.cbegin(), Loaded.cend());
+        Zones.Set(7, MakeZone(7, "Seven"));
+        Journal.Add(*Zones.Find(7));
+        Journal.CompactIfNeeded(Zones);
+        Journal.WaitForCompaction();
+        TEST_CHECK(ReadFile(ConfigPath) == Broken);
+
+        // Saving keeps the unreadable file aside
+        TEST_CHECK(Journal.Save(Zones));
+    }
+    TEST_CHECK(ReadFile(ConfigPath + ".unreadable") == Broken);
+    ZoneMap Config;
+    TEST_CHECK(ReadConfig(ConfigPath, Config));
+    CheckSameZones(Config, Zones);
+}
+
+// Compactions which cannot write the configuration lose no edits
+void TestFailedCompaction()
+{
+    const auto Directory = MakeDirectory("FailedCompaction");
+    const auto ConfigPath = (Directory / "Config.xml").string();
+    std::filesystem::create_directory(ConfigPath + ".tmp"); // the temporary file cannot be written
+
+    CMouseEvents::ZonesType Zones;
+    {
+        CZoneJournal Journal(ConfigPath, 4);
+        ZoneMap Loaded;
+        Journal.Load(Loaded);
+        for(int ZoneId = 1; ZoneId <= 12; ++ZoneId)
+        {
+            Zones.Set(ZoneId, MakeZone(ZoneId, "Zone"));
+            Journal.Add(*Zones.Find(ZoneId));
+            Journal.CompactIfNeeded(Zones);
+            Journal.WaitForCompaction();
+        }
+        TEST_CHECK(!Journal.Save(Zones));
+    }
+    std::filesystem::remove(ConfigPath + ".tmp");
+
+    CZoneJournal Journal(ConfigPath);
+    ZoneMap Loaded;
+    Journal.Load(Loaded);
+    CheckSameZones(Loaded, Zones);
+}
+
+}
+
+int main()
+{
+    TestReplay(false);
+    TestReplay(true);
+    TestUnreadableConfig();
+    TestFailedCompaction();
+    return TestFailures();
+}
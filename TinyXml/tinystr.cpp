@@ -31,7 +31,8 @@ const TiXmlString::size_type TiXmlString::npos = static_cast< TiXmlString::size_
 
 
 // Null rep.
-TiXmlString::Rep TiXmlString::nullrep_ = { 0, 0, { '\0' } };
+char TiXmlString::nullstr_[ 1 ] = { '\0' };
+TiXmlString::Rep TiXmlString::nullrep_ = { 0, 0, TiXmlString::nullstr_ };
 
 
 void TiXmlString::reserve (size_type cap)
@@ -49,7 +50,8 @@ void TiXmlString::reserve (size_type cap)
 TiXmlString& TiXmlString::assign(const char* str, size_type len)
 {
 	size_type cap = capacity();
-	if (len > cap || cap > 3*(len + 8))
+	// A buffer without capacity is shared, it must not be written to.
+	if (!cap || len > cap || cap > 3*(len + 8))
 	{
 		TiXmlString tmp;
 		tmp.init(len);
@@ -67,6 +69,10 @@ TiXmlString& TiXmlString::assign(const char* str, size_type len)
 
 TiXmlString& TiXmlString::append(const char* str, size_type len)
 {
+	if (!len)
+	{
+		return *this;
+	}
 	size_type newsize = length() + len;
 	if (newsize > capacity())
 	{
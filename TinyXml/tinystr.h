@@ -45,12 +45,23 @@ distribution.
 #endif
 
 
+/*	Memory for the string buffers. Allocations are taken from the current
+	TiXmlArena if there is one (see tinyxml.h), otherwise from the heap.
+*/
+void* TiXmlAllocate( size_t size );
+void TiXmlFree( void* p );
+
+
 /*
    TiXmlString is an emulation of a subset of the std::string template.
    Its purpose is to allow compiling TinyXML on compilers with no or poor STL support.
    Only the member functions relevant to the TinyXML project have been implemented.
    The buffer allocation is made by a simplistic power of 2 like mechanism : if we increase
    a string and there's no more room, we allocate a buffer twice as big as we need.
+   Strings of up to smallCapacity characters are stored in the object itself and
+   allocate nothing. A string may also refer to characters it does not own: a buffer
+   of a TiXmlStringPool, or the source of an in-situ parse. Such a string has a
+   capacity of 0 and is copied before it is changed.
 */
 class TiXmlString
 {
@@ -142,6 +153,9 @@ class TiXmlString
 	// Return capacity of string
 	size_type capacity () const { return rep_->capacity; }
 
+	// The buffer owned by the string (from TiXmlAllocate), 0 if there is none.
+	const void* buffer () const { return (capacity() && !isSmall()) ? rep_ : 0; }
+
 
 	// single char extraction
 	const char& at (size_type index) const
@@ -196,12 +210,25 @@ class TiXmlString
 
 	void swap (TiXmlString& other)
 	{
-		Rep* r = rep_;
-		rep_ = other.rep_;
+		// The inline buffers move with their contents, so the reps pointing
+		// into them have to be redirected.
+		Rep* r = isSmall() ? &other.small_.rep : rep_;
+		rep_ = other.isSmall() ? &small_.rep : other.rep_;
 		other.rep_ = r;
+
+		Small s = small_;
+		small_ = other.small_;
+		other.small_ = s;
+		relink();
+		other.relink();
 	}
 
   private:
+	friend class TiXmlStringPool;
+	friend class TiXmlInSitu;
+
+	// Number of characters that fit in the inline buffer.
+	enum { smallCapacity = 15 };
 
 	void init(size_type sz) { init(sz, sz); }
 	void set_size(size_type sz) { rep_->str[ rep_->size = sz ] = '\0'; }
@@ -211,22 +238,38 @@ class TiXmlString
 	struct Rep
 	{
 		size_type size, capacity;
-		char str[1];
+		char* str;
+	};
+
+	// The Rep of inline characters, or of characters owned by someone else.
+	struct Small
+	{
+		Rep rep;
+		char buffer[ smallCapacity + 1 ];
 	};
 
+	bool isSmall() const { return rep_ == &small_.rep; }
+
+	// Inline characters move with the object, their Rep has to follow.
+	void relink() { if (isSmall() && capacity()) rep_->str = small_.buffer; }
+
 	void init(size_type sz, size_type cap)
 	{
-		if (cap)
+		if (cap && cap <= smallCapacity)
+		{
+			rep_ = &small_.rep;
+			rep_->str = small_.buffer;
+			rep_->str[ rep_->size = sz ] = '\0';
+			rep_->capacity = smallCapacity;
+		}
+		else if (cap)
 		{
-			// Lee: the original form:
-			//	rep_ = static_cast<Rep*>(operator new(sizeof(Rep) + cap));
-			// doesn't work in some cases of new being overloaded. Switching
-			// to the normal allocation, although use an 'int' for systems
-			// that are overly picky about structure alignment.
-			const size_type bytesNeeded = sizeof(Rep) + cap;
-			const size_type intsNeeded = ( bytesNeeded + sizeof(int) - 1 ) / sizeof( int ); 
-			rep_ = reinterpret_cast<Rep*>( new int[ intsNeeded ] );
+			// TiXmlAllocate returns memory aligned for any type, so the
+			// Rep can be placed at the start of it, the characters follow.
+			const size_type bytesNeeded = sizeof(Rep) + cap + 1;
+			rep_ = static_cast<Rep*>( TiXmlAllocate( bytesNeeded ) );
 
+			rep_->str = reinterpret_cast<char*>( rep_ + 1 );
 			rep_->str[ rep_->size = sz ] = '\0';
 			rep_->capacity = cap;
 		}
@@ -236,26 +279,38 @@ class TiXmlString
 		}
 	}
 
+	// Refer to 'len' characters owned by someone else.
+	void share(char* str, size_type len)
+	{
+		quit();
+		rep_ = &small_.rep;
+		rep_->str = str;
+		rep_->size = len;
+		rep_->capacity = 0;
+	}
+
 	void quit()
 	{
-		if (rep_ != &nullrep_)
+		// The null rep and pooled buffers have no capacity, they are not owned.
+		if (capacity() && !isSmall())
 		{
-			// The rep_ is really an array of ints. (see the allocator, above).
-			// Cast it back before delete, so the compiler won't incorrectly call destructors.
-			delete [] ( reinterpret_cast<int*>( rep_ ) );
+			// Buffers from an arena are released with the arena.
+			TiXmlFree( rep_ );
 		}
 	}
 
 	Rep * rep_;
+	Small small_;
 	static Rep nullrep_;
+	static char nullstr_[ 1 ];
 
 } ;
 
 
 inline bool operator == (const TiXmlString & a, const TiXmlString & b)
 {
-	return    ( a.length() == b.length() )				// optimization on some platforms
-	       && ( strcmp(a.c_str(), b.c_str()) == 0 );	// actual compare
+	return    ( a.length() == b.length() )						// optimization on some platforms
+	       && ( memcmp(a.data(), b.data(), a.length()) == 0 );	// actual compare
 }
 inline bool operator < (const TiXmlString & a, const TiXmlString & b)
 {
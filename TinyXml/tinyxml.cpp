@@ -29,12 +29,551 @@ distribution.
 #include <iostream>
 #endif
 
+// Numbers are converted with <charconv> where the library supports it fully.
+#if defined( __has_include ) && ( __cplusplus >= 201703L || ( defined( _MSVC_LANG ) && _MSVC_LANG >= 201703L ) )
+	#if __has_include( <charconv> )
+		#include <charconv>
+	#endif
+#endif
+#if defined( __cpp_lib_to_chars )
+	#define TIXML_USE_CHARCONV
+#endif
+
 #include "tinyxml.h"
 
+// LoadFile maps the file into memory where the system supports it. Define
+// TIXML_NO_MMAP to always read it into a buffer instead.
+#if !defined( TIXML_NO_MMAP ) && ( defined( __unix__ ) || defined( __APPLE__ ) )
+	#define TIXML_USE_MMAP
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
 FILE* TiXmlFOpen( const char* filename, const char* mode );
 
+// The only setting shared by all parses, and only read by them. The other
+// shared tables are const, the state of a parse is thread local.
 bool TiXmlBase::condenseWhiteSpace = true;
 
+int TiXmlBase::ToInt( const char* str, int* value )
+{
+	#ifdef TIXML_USE_CHARCONV
+	while ( IsWhiteSpace( *str ) )
+		++str;
+	// sscanf takes a '+', from_chars does not.
+	if ( *str == '+' && str[1] != '-' )
+		++str;
+	std::from_chars_result result = std::from_chars( str, str + strlen( str ), *value );
+	return result.ec == std::errc() ? TIXML_SUCCESS : TIXML_WRONG_TYPE;
+	#else
+	return TIXML_SSCANF( str, "%d", value ) == 1 ? TIXML_SUCCESS : TIXML_WRONG_TYPE;
+	#endif
+}
+
+int TiXmlBase::ToDouble( const char* str, double* value )
+{
+	#ifdef TIXML_USE_CHARCONV
+	while ( IsWhiteSpace( *str ) )
+		++str;
+	const char* number = str;
+	if ( *number == '+' && number[1] != '-' )
+		++number;
+	// Hexadecimal floats are left to sscanf, from_chars would stop at the 'x'. So are
+	// infinity and NaN: sscanf rejects spellings like "infinit", from_chars takes their start.
+	const char* digits = ( *number == '-' ) ? number + 1 : number;
+	const bool hex = digits[0] == '0' && ( digits[1] == 'x' || digits[1] == 'X' );
+	const bool named = digits[0] == 'i' || digits[0] == 'I' || digits[0] == 'n' || digits[0] == 'N';
+	if ( !hex && !named )
+	{
+		// Out of range values are also left to sscanf, which returns infinity or zero for them.
+		std::from_chars_result result = std::from_chars( number, number + strlen( number ), *value );
+		if ( result.ec != std::errc::result_out_of_range )
+			return result.ec == std::errc() ? TIXML_SUCCESS : TIXML_WRONG_TYPE;
+	}
+	#endif
+	return TIXML_SSCANF( str, "%lf", value ) == 1 ? TIXML_SUCCESS : TIXML_WRONG_TYPE;
+}
+
+// The options of the parse on the thread, see TiXmlParseOptionsScope.
+static thread_local const TiXmlParseOptions* currentOptions = 0;
+
+// The arena of the thread, see TiXmlArenaScope.
+static thread_local TiXmlArena* currentArena = 0;
+
+#ifndef TIXML_USE_STL
+// The string pool of the thread, see TiXmlStringPoolScope.
+static thread_local TiXmlStringPool* currentPool = 0;
+// The in-situ parse of the thread, see TiXmlInSituScope.
+static thread_local TiXmlInSitu* currentInSitu = 0;
+#endif
+
+// Every allocation starts with the arena it came from (0 for the heap). The
+// header is as large as the strictest alignment, so the memory after it stays aligned.
+union TiXmlAllocationHeader
+{
+	TiXmlArena* arena;
+	long double align;
+};
+
+void* TiXmlAllocate( size_t size )
+{
+	TiXmlArena* arena = currentArena;
+	size += sizeof( TiXmlAllocationHeader );
+	TiXmlAllocationHeader* header = static_cast<TiXmlAllocationHeader*>( arena ? arena->Allocate( size ) : ::operator new( size ) );
+	header->arena = arena;
+	return header + 1;
+}
+
+
+void TiXmlFree( void* p )
+{
+	if ( !p )
+		return;
+	TiXmlAllocationHeader* header = static_cast<TiXmlAllocationHeader*>( p ) - 1;
+	if ( !header->arena )
+		::operator delete( header );
+}
+
+
+#ifndef TIXML_USE_STL
+// Whether an allocation of TiXmlAllocate() came from an arena. Nothing (0) is
+// as good: there is nothing to free.
+static bool ArenaAllocated( const void* p )
+{
+	return !p || ( static_cast<const TiXmlAllocationHeader*>( p ) - 1 )->arena;
+}
+#endif
+
+
+TiXmlArena::TiXmlArena() : chunks( 0 ), allocated( 0 ), nextChunkSize( 4096 )
+{
+}
+
+
+TiXmlArena::~TiXmlArena()
+{
+	while ( chunks )
+	{
+		Chunk* next = chunks->next;
+		::operator delete( chunks );
+		chunks = next;
+	}
+}
+
+
+// Rounded up to keep the chunk data aligned.
+const size_t TiXmlArena::chunkHeaderSize = ( sizeof( TiXmlArena::Chunk ) + sizeof( TiXmlAllocationHeader ) - 1 )
+											/ sizeof( TiXmlAllocationHeader ) * sizeof( TiXmlAllocationHeader );
+
+TiXmlArena::Chunk* TiXmlArena::NewChunk( size_t size )
+{
+	Chunk* chunk = static_cast<Chunk*>( ::operator new( chunkHeaderSize + size ) );
+	chunk->size = size;
+	chunk->used = 0;
+	return chunk;
+}
+
+
+void* TiXmlArena::Allocate( size_t size )
+{
+	// Keep every allocation at the alignment of the chunk data.
+	const size_t align = sizeof( TiXmlAllocationHeader );
+	size = ( size + align - 1 ) / align * align;
+
+	if ( size > nextChunkSize / 4 )
+	{
+		// Big allocations get a chunk of their own, behind the chunk in use.
+		Chunk* chunk = NewChunk( size );
+		chunk->used = size;
+		if ( chunks )
+		{
+			chunk->next = chunks->next;
+			chunks->next = chunk;
+		}
+		else
+		{
+			chunk->next = 0;
+			chunks = chunk;
+		}
+		allocated += size;
+		return Data( chunk );
+	}
+
+	if ( !chunks || chunks->used + size > chunks->size )
+	{
+		Chunk* chunk = NewChunk( nextChunkSize );
+		chunk->next = chunks;
+		chunks = chunk;
+		if ( nextChunkSize < 1024*1024 )
+			nextChunkSize *= 2;
+	}
+
+	void* p = Data( chunks ) + chunks->used;
+	chunks->used += size;
+	allocated += size;
+	return p;
+}
+
+
+void TiXmlArena::Reset()
+{
+	// Keep the largest chunk, the next document is likely of similar size.
+	Chunk* keep = 0;
+	while ( chunks )
+	{
+		Chunk* next = chunks->next;
+		if ( !keep || chunks->size > keep->size )
+		{
+			if ( keep )
+				::operator delete( keep );
+			keep = chunks;
+		}
+		else
+		{
+			::operator delete( chunks );
+		}
+		chunks = next;
+	}
+	if ( keep )
+	{
+		keep->next = 0;
+		keep->used = 0;
+	}
+	chunks = keep;
+	allocated = 0;
+}
+
+
+int TiXmlArena::ChunkCount() const
+{
+	int count = 0;
+	for ( const Chunk* chunk = chunks; chunk; chunk = chunk->next )
+		++count;
+	return count;
+}
+
+
+const TiXmlParseOptions* TiXmlParseOptions::Current()
+{
+	return currentOptions;
+}
+
+
+TiXmlParseOptionsScope::TiXmlParseOptionsScope( const TiXmlParseOptions* options ) : previous( currentOptions )
+{
+	currentOptions = options;
+}
+
+
+TiXmlParseOptionsScope::~TiXmlParseOptionsScope()
+{
+	currentOptions = previous;
+}
+
+
+bool TiXmlBase::IsWhiteSpaceCondensed()
+{
+	return currentOptions ? currentOptions->condenseWhiteSpace : condenseWhiteSpace;
+}
+
+
+TiXmlArena* TiXmlArena::Current()
+{
+	return currentArena;
+}
+
+
+TiXmlArenaScope::TiXmlArenaScope( TiXmlArena* arena ) : previous( currentArena )
+{
+	currentArena = arena;
+}
+
+
+TiXmlArenaScope::~TiXmlArenaScope()
+{
+	currentArena = previous;
+}
+
+
+// Hash of the names in the string pool and the name indexes.
+static size_t HashChars( const char* str, size_t len )
+{
+	// FNV-1a
+	size_t hash = 2166136261u;
+	for ( size_t i=0; i<len; ++i )
+	{
+		hash ^= (unsigned char) str[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+#ifndef TIXML_USE_STL
+TiXmlStringPool::TiXmlStringPool() : table( 0 ), tableSize( 0 ), count( 0 )
+{
+}
+
+
+TiXmlStringPool::~TiXmlStringPool()
+{
+	delete [] table;
+}
+
+
+void TiXmlStringPool::Grow()
+{
+	size_t newSize = tableSize ? tableSize * 2 : 64;
+	Rep** newTable = new Rep*[ newSize ];
+	memset( newTable, 0, newSize * sizeof( Rep* ) );
+
+	for ( size_t i=0; i<tableSize; ++i )
+	{
+		Rep* rep = table[i];
+		if ( rep )
+		{
+			size_t slot = HashChars( rep->str, rep->size ) & ( newSize - 1 );
+			while ( newTable[slot] )
+				slot = ( slot + 1 ) & ( newSize - 1 );
+			newTable[slot] = rep;
+		}
+	}
+	delete [] table;
+	table = newTable;
+	tableSize = newSize;
+}
+
+
+void TiXmlStringPool::Intern( const char* str, size_t len, TiXmlString* out )
+{
+	if ( len <= TiXmlString::smallCapacity )
+	{
+		out->assign( str, len );
+		return;
+	}
+
+	// Keep the table at most half full.
+	if ( ( count + 1 ) * 2 > tableSize )
+		Grow();
+
+	size_t slot = HashChars( str, len ) & ( tableSize - 1 );
+	Rep* rep = table[slot];
+	while ( rep && ( rep->size != len || memcmp( rep->str, str, len ) != 0 ) )
+	{
+		slot = ( slot + 1 ) & ( tableSize - 1 );
+		rep = table[slot];
+	}
+
+	if ( !rep )
+	{
+		// A capacity of 0 keeps the strings from writing to the shared buffer.
+		rep = static_cast<Rep*>( storage.Allocate( sizeof( Rep ) + len + 1 ) );
+		rep->str = reinterpret_cast<char*>( rep + 1 );
+		rep->size = len;
+		rep->capacity = 0;
+		memcpy( rep->str, str, len );
+		rep->str[len] = '\0';
+		table[slot] = rep;
+		++count;
+	}
+
+	out->quit();
+	out->rep_ = rep;
+}
+
+
+void TiXmlStringPool::Clear()
+{
+	if ( table )
+		memset( table, 0, tableSize * sizeof( Rep* ) );
+	count = 0;
+	storage.Reset();
+}
+
+
+TiXmlStringPool* TiXmlStringPool::Current()
+{
+	return currentPool;
+}
+
+
+TiXmlStringPoolScope::TiXmlStringPoolScope( TiXmlStringPool* pool ) : previous( currentPool )
+{
+	currentPool = pool;
+}
+
+
+TiXmlStringPoolScope::~TiXmlStringPoolScope()
+{
+	currentPool = previous;
+}
+
+
+TiXmlInSitu::TiXmlInSitu() : data( 0 ), terminators( 0 ), terminatorCount( 0 ), terminatorCapacity( 0 )
+{
+}
+
+
+TiXmlInSitu::~TiXmlInSitu()
+{
+	delete [] terminators;
+}
+
+
+char* TiXmlInSitu::NewSource( size_t length )
+{
+	// A few zeros follow the terminator: a truncated UTF-8 character at the
+	// end is read (and decoded) past it, and has to stay in the buffer.
+	const size_t padding = 4;
+	char* source = static_cast<char*>( sources.Allocate( length + 1 + padding ) );
+	memset( source + length, 0, 1 + padding );
+	return source;
+}
+
+
+void TiXmlInSitu::View( char* str, size_t len, TiXmlString* out )
+{
+	if ( !len )
+	{
+		*out = "";
+		return;
+	}
+
+	if ( terminatorCount == terminatorCapacity )
+	{
+		size_t newCapacity = terminatorCapacity ? terminatorCapacity * 2 : 256;
+		char** newTerminators = new char*[ newCapacity ];
+		if ( terminatorCount )
+			memcpy( newTerminators, terminators, terminatorCount * sizeof( char* ) );
+		delete [] terminators;
+		terminators = newTerminators;
+		terminatorCapacity = newCapacity;
+	}
+	terminators[ terminatorCount++ ] = str + len;
+
+	out->share( str, len );
+}
+
+
+void TiXmlInSitu::Finish()
+{
+	for ( size_t i=0; i<terminatorCount; ++i )
+		*terminators[i] = 0;
+	terminatorCount = 0;
+}
+
+
+void TiXmlInSitu::Clear()
+{
+	terminatorCount = 0;
+	sources.Reset();
+}
+
+
+TiXmlInSitu* TiXmlInSitu::Current()
+{
+	return currentInSitu;
+}
+
+
+TiXmlInSituScope::TiXmlInSituScope( TiXmlInSitu* inSitu, TiXmlParsingData* data ) : previous( currentInSitu )
+{
+	currentInSitu = inSitu;
+	if ( inSitu )
+		inSitu->data = data;
+}
+
+
+TiXmlInSituScope::~TiXmlInSituScope()
+{
+	if ( currentInSitu )
+	{
+		currentInSitu->Finish();
+		currentInSitu->data = 0;
+	}
+	currentInSitu = previous;
+}
+#endif
+
+
+/*	The index of a node or attribute set: open addressing table from a name to
+	the first and the last item with that name. The table is built at once for
+	a known number of items and never grows; a change of the items drops it.
+*/
+class TiXmlNameIndex
+{
+public:
+	struct Entry
+	{
+		size_t hash;
+		const TIXML_STRING* name;	// The name of 'first', 0 for an empty slot.
+		void* first;
+		void* last;
+	};
+
+	TiXmlNameIndex( size_t count )
+	{
+		// Keep the table at most half full.
+		tableSize = 16;
+		while ( tableSize < count * 2 )
+			tableSize *= 2;
+		table = new Entry[ tableSize ];
+		memset( table, 0, tableSize * sizeof( Entry ) );
+	}
+
+	~TiXmlNameIndex()	{ delete [] table; }
+
+	// The entry of the 'len' characters at 'name', 0 if no item has that name.
+	const Entry* Find( const char* name, size_t len ) const
+	{
+		const Entry* entry = Slot( HashChars( name, len ), name, len );
+		return entry->name ? entry : 0;
+	}
+
+	// Add an item after the items with the same name. 'name' has to stay
+	// unchanged as long as the index exists. Returns the previous last item
+	// with the name, 0 if there was none.
+	void* Add( const TIXML_STRING* name, void* item )
+	{
+		size_t hash = HashChars( name->c_str(), name->length() );
+		Entry* entry = Slot( hash, name->c_str(), name->length() );
+		void* last = entry->last;
+		if ( !entry->name )
+		{
+			entry->hash = hash;
+			entry->name = name;
+			entry->first = item;
+		}
+		entry->last = item;
+		return last;
+	}
+
+private:
+	TiXmlNameIndex( const TiXmlNameIndex& );		// not allowed.
+	void operator=( const TiXmlNameIndex& );		// not allowed.
+
+	// The entry of the name, or the empty slot where it goes.
+	Entry* Slot( size_t hash, const char* name, size_t len ) const
+	{
+		size_t slot = hash & ( tableSize - 1 );
+		while ( table[slot].name
+				&& ( table[slot].hash != hash
+					 || table[slot].name->length() != len
+					 || memcmp( table[slot].name->c_str(), name, len ) != 0 ) )
+		{
+			slot = ( slot + 1 ) & ( tableSize - 1 );
+		}
+		return table + slot;
+	}
+
+	Entry* table;
+	size_t tableSize;
+};
+
+// Lookups by name which scan more items than this build the index, if allowed.
+static const int indexScanLength = 8;
+
+
 // Microsoft compiler security
 FILE* TiXmlFOpen( const char* filename, const char* mode )
 {
@@ -49,9 +588,24 @@ FILE* TiXmlFOpen( const char* filename, const char* mode )
 	#endif
 }
 
+// Length of the start of a string that EncodeString() copies unchanged.
+static size_t PlainLength( const char* str )
+{
+	const unsigned char* p = (const unsigned char*) str;
+	while (    *p >= 32
+			&& *p != '&' && *p != '<' && *p != '>' && *p != '\"' && *p != '\'' )
+	{
+		++p;
+	}
+	return p - (const unsigned char*) str;
+}
+
+
 void TiXmlBase::EncodeString( const TIXML_STRING& str, TIXML_STRING* outString )
 {
-	int i=0;
+	// Most strings have nothing to encode, or only little at the end.
+	int i = (int) PlainLength( str.c_str() );
+	outString->append( str.c_str(), i );
 
 	while( i<(int)str.length() )
 	{
@@ -133,6 +687,245 @@ void TiXmlBase::EncodeString( const TIXML_STRING& str, TIXML_STRING* outString )
 }
 
 
+/*	Prints nodes in the format of TiXmlNode::Print(). The output is collected in a
+	buffer that is written to the file in large blocks, instead of a few small
+	fprintf calls per node.
+*/
+class TiXmlFilePrinter : public TiXmlVisitor
+{
+public:
+	TiXmlFilePrinter( FILE* _cfile, int _depth ) : cfile( _cfile ), depth( _depth ), level( 0 ), inDocument( false ), used( 0 ) {}
+	~TiXmlFilePrinter()		{ Flush(); }
+
+	virtual bool VisitEnter( const TiXmlDocument& )
+	{
+		inDocument = true;
+		return true;
+	}
+
+	virtual bool VisitEnter( const TiXmlElement& element, const TiXmlAttribute* firstAttribute )
+	{
+		StartNode();
+		Indent();
+		Put( '<' );
+		Put( element.Value() );
+
+		for( const TiXmlAttribute* attrib = firstAttribute; attrib; attrib = attrib->Next() )
+		{
+			const char quote = strchr( attrib->Value(), '\"' ) ? '\'' : '\"';
+			Put( ' ' );
+			PutEncoded( attrib->NameTStr() );
+			Put( '=' );
+			Put( quote );
+			PutEncoded( attrib->ValueTStr() );
+			Put( quote );
+		}
+
+		// There are 3 different formatting approaches:
+		// 1) An element without children is printed as a <foo /> node
+		// 2) An element with only a text child is printed as <foo> text </foo>
+		// 3) An element with children is printed on multiple lines.
+		if ( !element.FirstChild() )
+			Put( " />" );
+		else
+			Put( '>' );
+		++depth;
+		++level;
+		return true;
+	}
+
+	virtual bool VisitExit( const TiXmlElement& element )
+	{
+		--depth;
+		--level;
+		if ( element.FirstChild() )
+		{
+			// An element with only a text child is printed on one line.
+			if ( element.FirstChild() != element.LastChild() || !element.FirstChild()->ToText() )
+			{
+				Put( '\n' );
+				Indent();
+			}
+			Put( "</" );
+			Put( element.Value() );
+			Put( '>' );
+		}
+		EndNode();
+		return true;
+	}
+
+	virtual bool Visit( const TiXmlDeclaration& declaration )
+	{
+		StartNode();
+		TIXML_STRING str;
+		declaration.Print( 0, 0, &str );
+		Put( str.c_str(), str.length() );
+		EndNode();
+		return true;
+	}
+
+	virtual bool Visit( const TiXmlText& text )
+	{
+		if ( text.CDATA() )
+		{
+			Put( '\n' );
+			Indent();
+			Put( "<![CDATA[" );
+			Put( text.Value() );
+			Put( "]]>\n" );		// unformatted output
+		}
+		else
+		{
+			PutEncoded( text.ValueTStr() );
+		}
+		EndNode();
+		return true;
+	}
+
+	virtual bool Visit( const TiXmlComment& comment )
+	{
+		StartNode();
+		Indent();
+		Put( "<!--" );
+		Put( comment.Value() );
+		Put( "-->" );
+		EndNode();
+		return true;
+	}
+
+	virtual bool Visit( const TiXmlUnknown& unknown )
+	{
+		StartNode();
+		Indent();
+		Put( '<' );
+		Put( unknown.Value() );
+		Put( '>' );
+		EndNode();
+		return true;
+	}
+
+private:
+	// Every node but text starts on a new line inside an element.
+	void StartNode()
+	{
+		if ( level > 0 )
+			Put( '\n' );
+	}
+
+	// The top level nodes of a document end with a new line.
+	void EndNode()
+	{
+		if ( level == 0 && inDocument )
+			Put( '\n' );
+	}
+
+	void Indent()
+	{
+		for ( int i=0; i<depth; ++i )
+			Put( "    ", 4 );
+	}
+
+	void PutEncoded( const TIXML_STRING& str )
+	{
+		if ( PlainLength( str.c_str() ) == str.length() )
+		{
+			Put( str.c_str(), str.length() );
+		}
+		else
+		{
+			TIXML_STRING encoded;
+			TiXmlBase::EncodeString( str, &encoded );
+			Put( encoded.c_str(), encoded.length() );
+		}
+	}
+
+	void Put( char c )
+	{
+		if ( used == sizeof( buffer ) )
+			Flush();
+		buffer[used++] = c;
+	}
+
+	void Put( const char* str )		{ Put( str, strlen( str ) ); }
+
+	void Put( const char* str, size_t length )
+	{
+		if ( length > sizeof( buffer ) - used )
+		{
+			Flush();
+			if ( length >= sizeof( buffer ) )
+			{
+				fwrite( str, 1, length, cfile );
+				return;
+			}
+		}
+		memcpy( buffer + used, str, length );
+		used += length;
+	}
+
+	void Flush()
+	{
+		if ( used )
+			fwrite( buffer, 1, used, cfile );
+		used = 0;
+	}
+
+	FILE* cfile;
+	int depth;
+	int level;			// number of open elements
+	bool inDocument;
+	size_t used;
+	char buffer[ 8*1024 ];
+};
+
+
+// Accept() of elements and documents. The parent and sibling links lead the way
+// through the tree, so deep documents do not recurse. As with a recursive visit,
+// a false from the visitor skips the children (VisitEnter) or the following
+// siblings (Visit, VisitExit) of a node.
+static bool AcceptTree( const TiXmlNode* root, TiXmlVisitor* visitor )
+{
+	const TiXmlNode* node = root;
+	for( ;; )
+	{
+		bool result = false;
+		if ( node->Type() == TiXmlNode::TINYXML_ELEMENT || node->Type() == TiXmlNode::TINYXML_DOCUMENT )
+		{
+			bool enter = ( node->Type() == TiXmlNode::TINYXML_ELEMENT )
+						 ? visitor->VisitEnter( *static_cast<const TiXmlElement*>( node ), static_cast<const TiXmlElement*>( node )->FirstAttribute() )
+						 : visitor->VisitEnter( *static_cast<const TiXmlDocument*>( node ) );
+			if ( enter && node->FirstChild() )
+			{
+				node = node->FirstChild();
+				continue;
+			}
+		}
+		else
+		{
+			result = node->Accept( visitor );
+		}
+
+		// Up to the next node to visit, leaving the elements done on the way.
+		for( ;; )
+		{
+			if ( node->Type() == TiXmlNode::TINYXML_ELEMENT )
+				result = visitor->VisitExit( *static_cast<const TiXmlElement*>( node ) );
+			else if ( node->Type() == TiXmlNode::TINYXML_DOCUMENT )
+				result = visitor->VisitExit( *static_cast<const TiXmlDocument*>( node ) );
+
+			if ( node == root )
+				return result;
+			if ( result && node->NextSibling() )
+			{
+				node = node->NextSibling();
+				break;
+			}
+			node = node->Parent();
+		}
+	}
+}
+
+
 TiXmlNode::TiXmlNode( NodeType _type ) : TiXmlBase()
 {
 	parent = 0;
@@ -141,20 +934,15 @@ TiXmlNode::TiXmlNode( NodeType _type ) : TiXmlBase()
 	lastChild = 0;
 	prev = 0;
 	next = 0;
+	indexNames = false;
+	index = 0;
+	nextSameName = 0;
 }
 
 
 TiXmlNode::~TiXmlNode()
 {
-	TiXmlNode* node = firstChild;
-	TiXmlNode* temp = 0;
-
-	while ( node )
-	{
-		temp = node;
-		node = node->next;
-		delete temp;
-	}	
+	Clear();
 }
 
 
@@ -163,18 +951,84 @@ void TiXmlNode::CopyTo( TiXmlNode* target ) const
 	target->SetValue (value.c_str() );
 	target->userData = userData; 
 	target->location = location;
+	target->indexNames = indexNames;
+}
+
+
+void TiXmlNode::MoveTo( TiXmlNode* target )
+{
+	assert( !target->firstChild );
+
+	target->value.swap( value );
+	value = "";
+	target->ValueChanged();
+	ValueChanged();
+	target->userData = userData;
+	target->location = location;
+	target->indexNames = indexNames;
+
+	// Only the children have to know their new parent.
+	for ( TiXmlNode* node = firstChild; node; node = node->next )
+		node->parent = target;
+	target->firstChild = firstChild;
+	target->lastChild = lastChild;
+	target->index = index;
+	firstChild = 0;
+	lastChild = 0;
+	index = 0;
+}
+
+
+void TiXmlNode::Index() const
+{
+	size_t count = 0;
+	for ( const TiXmlNode* node = firstChild; node; node = node->next )
+		++count;
+
+	index = new TiXmlNameIndex( count );
+	for ( TiXmlNode* node = firstChild; node; node = node->next )
+	{
+		node->nextSameName = 0;
+		TiXmlNode* last = static_cast<TiXmlNode*>( index->Add( &node->value, node ) );
+		if ( last )
+			last->nextSameName = node;
+	}
+}
+
+
+void TiXmlNode::DropIndex()
+{
+	delete index;
+	index = 0;
 }
 
 
 void TiXmlNode::Clear()
 {
+	DropIndex();
+
+	// The children of a node are spliced into the list right after it, before
+	// it is deleted: no destructor has anything left to delete below it, and
+	// the nodes go in document order.
 	TiXmlNode* node = firstChild;
 	TiXmlNode* temp = 0;
 
 	while ( node )
 	{
+		if ( node->firstChild )
+		{
+			node->lastChild->next = node->next;
+			node->next = node->firstChild;
+			node->firstChild = 0;
+			node->lastChild = 0;
+		}
+
 		temp = node;
 		node = node->next;
+		#ifndef TIXML_USE_STL
+		if ( temp->InArena() )
+			continue;		// released with the arena
+		#endif
 		delete temp;
 	}	
 
@@ -183,6 +1037,14 @@ void TiXmlNode::Clear()
 }
 
 
+#ifndef TIXML_USE_STL
+bool TiXmlNode::InArena() const
+{
+	return !index && ArenaAllocated( this ) && ArenaAllocated( value.buffer() );
+}
+#endif
+
+
 TiXmlNode* TiXmlNode::LinkEndChild( TiXmlNode* node )
 {
 	assert( node->parent == 0 || node->parent == this );
@@ -196,6 +1058,7 @@ TiXmlNode* TiXmlNode::LinkEndChild( TiXmlNode* node )
 		return 0;
 	}
 
+	DropIndex();
 	node->parent = this;
 
 	node->prev = lastChild;
@@ -242,6 +1105,27 @@ TiXmlNode* TiXmlNode::InsertBeforeChild( TiXmlNode* beforeThis, const TiXmlNode&
 	TiXmlNode* node = addThis.Clone();
 	if ( !node )
 		return 0;
+	return LinkBeforeChild( beforeThis, node );
+}
+
+
+TiXmlNode* TiXmlNode::LinkBeforeChild( TiXmlNode* beforeThis, TiXmlNode* node )
+{
+	assert( node->parent == 0 );
+
+	if ( !beforeThis || beforeThis->parent != this ) {
+		delete node;
+		return 0;
+	}
+	if ( node->Type() == TiXmlNode::TINYXML_DOCUMENT )
+	{
+		delete node;
+		if ( GetDocument() ) 
+			GetDocument()->SetError( TIXML_ERROR_DOCUMENT_TOP_ONLY, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return 0;
+	}
+
+	DropIndex();
 	node->parent = this;
 
 	node->next = beforeThis;
@@ -275,6 +1159,27 @@ TiXmlNode* TiXmlNode::InsertAfterChild( TiXmlNode* afterThis, const TiXmlNode& a
 	TiXmlNode* node = addThis.Clone();
 	if ( !node )
 		return 0;
+	return LinkAfterChild( afterThis, node );
+}
+
+
+TiXmlNode* TiXmlNode::LinkAfterChild( TiXmlNode* afterThis, TiXmlNode* node )
+{
+	assert( node->parent == 0 );
+
+	if ( !afterThis || afterThis->parent != this ) {
+		delete node;
+		return 0;
+	}
+	if ( node->Type() == TiXmlNode::TINYXML_DOCUMENT )
+	{
+		delete node;
+		if ( GetDocument() ) 
+			GetDocument()->SetError( TIXML_ERROR_DOCUMENT_TOP_ONLY, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return 0;
+	}
+
+	DropIndex();
 	node->parent = this;
 
 	node->prev = afterThis;
@@ -312,6 +1217,29 @@ TiXmlNode* TiXmlNode::ReplaceChild( TiXmlNode* replaceThis, const TiXmlNode& wit
 	TiXmlNode* node = withThis.Clone();
 	if ( !node )
 		return 0;
+	return LinkReplaceChild( replaceThis, node );
+}
+
+
+TiXmlNode* TiXmlNode::LinkReplaceChild( TiXmlNode* replaceThis, TiXmlNode* node )
+{
+	assert( node->parent == 0 );
+
+	if ( !replaceThis || replaceThis->parent != this )
+	{
+		delete node;
+		return 0;
+	}
+
+	if ( node->ToDocument() ) {
+		delete node;
+		TiXmlDocument* document = GetDocument();
+		if ( document ) 
+			document->SetError( TIXML_ERROR_DOCUMENT_TOP_ONLY, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return 0;
+	}
+
+	DropIndex();
 
 	node->next = replaceThis->next;
 	node->prev = replaceThis->prev;
@@ -344,6 +1272,7 @@ bool TiXmlNode::RemoveChild( TiXmlNode* removeThis )
 		return false;
 	}
 
+	DropIndex();
 	if ( removeThis->next )
 		removeThis->next->prev = removeThis->prev;
 	else
@@ -360,13 +1289,22 @@ bool TiXmlNode::RemoveChild( TiXmlNode* removeThis )
 
 const TiXmlNode* TiXmlNode::FirstChild( const char * _value ) const
 {
+	if ( index )
+	{
+		const TiXmlNameIndex::Entry* entry = index->Find( _value, strlen( _value ) );
+		return entry ? static_cast<const TiXmlNode*>( entry->first ) : 0;
+	}
+
 	const TiXmlNode* node;
-	for ( node = firstChild; node; node = node->next )
+	int scanned = 0;
+	for ( node = firstChild; node; node = node->next, ++scanned )
 	{
 		if ( strcmp( node->Value(), _value ) == 0 )
-			return node;
+			break;
 	}
-	return 0;
+	if ( indexNames && scanned > indexScanLength )
+		Index();
+	return node;
 }
 
 
@@ -412,13 +1350,20 @@ const TiXmlNode* TiXmlNode::IterateChildren( const char * val, const TiXmlNode*
 
 const TiXmlNode* TiXmlNode::NextSibling( const char * _value ) const 
 {
+	// The index links the siblings with the same value, which is the usual lookup.
+	if ( parent && parent->index && strcmp( Value(), _value ) == 0 )
+		return nextSameName;
+
 	const TiXmlNode* node;
-	for ( node = next; node; node = node->next )
+	int scanned = 0;
+	for ( node = next; node; node = node->next, ++scanned )
 	{
 		if ( strcmp( node->Value(), _value ) == 0 )
-			return node;
+			break;
 	}
-	return 0;
+	if ( parent && parent->indexNames && !parent->index && scanned > indexScanLength )
+		parent->Index();
+	return node;
 }
 
 
@@ -540,18 +1485,36 @@ TiXmlElement::TiXmlElement( const std::string& _value )
 #endif
 
 
-TiXmlElement::TiXmlElement( const TiXmlElement& copy)
+TiXmlElement::TiXmlElement( const TiXmlElement& copy)
+	: TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
+{
+	firstChild = lastChild = 0;
+	copy.CopyTo( this );	
+}
+
+
+TiXmlElement& TiXmlElement::operator=( const TiXmlElement& base )
+{
+	ClearThis();
+	base.CopyTo( this );
+	return *this;
+}
+
+
+TiXmlElement::TiXmlElement( TiXmlElement&& other )
 	: TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
 {
-	firstChild = lastChild = 0;
-	copy.CopyTo( this );	
+	other.MoveTo( this );
 }
 
 
-TiXmlElement& TiXmlElement::operator=( const TiXmlElement& base )
+TiXmlElement& TiXmlElement::operator=( TiXmlElement&& other )
 {
-	ClearThis();
-	base.CopyTo( this );
+	if ( &other != this )
+	{
+		ClearThis();
+		other.MoveTo( this );
+	}
 	return *this;
 }
 
@@ -737,6 +1700,44 @@ int TiXmlElement::QueryDoubleAttribute( const std::string& name, double* dval )
 #endif
 
 
+int TiXmlElement::QueryIntAttributes( const char* const* names, int* values, int count ) const
+{
+	int read = 0;
+	for( const TiXmlAttribute* attrib = attributeSet.First(); attrib; attrib = attrib->Next() )
+	{
+		for( int i=0; i<count; ++i )
+		{
+			if ( strcmp( attrib->Name(), names[i] ) == 0 )
+			{
+				if ( attrib->QueryIntValue( &values[i] ) == TIXML_SUCCESS )
+					++read;
+				break;
+			}
+		}
+	}
+	return read;
+}
+
+
+int TiXmlElement::QueryDoubleAttributes( const char* const* names, double* values, int count ) const
+{
+	int read = 0;
+	for( const TiXmlAttribute* attrib = attributeSet.First(); attrib; attrib = attrib->Next() )
+	{
+		for( int i=0; i<count; ++i )
+		{
+			if ( strcmp( attrib->Name(), names[i] ) == 0 )
+			{
+				if ( attrib->QueryDoubleValue( &values[i] ) == TIXML_SUCCESS )
+					++read;
+				break;
+			}
+		}
+	}
+	return read;
+}
+
+
 void TiXmlElement::SetAttribute( const char * name, int val )
 {	
 	TiXmlAttribute* attrib = attributeSet.FindOrCreate( name );
@@ -799,54 +1800,9 @@ void TiXmlElement::SetAttribute( const std::string& _name, const std::string& _v
 
 void TiXmlElement::Print( FILE* cfile, int depth ) const
 {
-	int i;
 	assert( cfile );
-	for ( i=0; i<depth; i++ ) {
-		fprintf( cfile, "    " );
-	}
-
-	fprintf( cfile, "<%s", value.c_str() );
-
-	const TiXmlAttribute* attrib;
-	for ( attrib = attributeSet.First(); attrib; attrib = attrib->Next() )
-	{
-		fprintf( cfile, " " );
-		attrib->Print( cfile, depth );
-	}
-
-	// There are 3 different formatting approaches:
-	// 1) An element without children is printed as a <foo /> node
-	// 2) An element with only a text child is printed as <foo> text </foo>
-	// 3) An element with children is printed on multiple lines.
-	TiXmlNode* node;
-	if ( !firstChild )
-	{
-		fprintf( cfile, " />" );
-	}
-	else if ( firstChild == lastChild && firstChild->ToText() )
-	{
-		fprintf( cfile, ">" );
-		firstChild->Print( cfile, depth + 1 );
-		fprintf( cfile, "</%s>", value.c_str() );
-	}
-	else
-	{
-		fprintf( cfile, ">" );
-
-		for ( node = firstChild; node; node=node->NextSibling() )
-		{
-			if ( !node->ToText() )
-			{
-				fprintf( cfile, "\n" );
-			}
-			node->Print( cfile, depth+1 );
-		}
-		fprintf( cfile, "\n" );
-		for( i=0; i<depth; ++i ) {
-			fprintf( cfile, "    " );
-		}
-		fprintf( cfile, "</%s>", value.c_str() );
-	}
+	TiXmlFilePrinter printer( cfile, depth );
+	Accept( &printer );
 }
 
 
@@ -864,6 +1820,7 @@ void TiXmlElement::CopyTo( TiXmlElement* target ) const
 	{
 		target->SetAttribute( attribute->Name(), attribute->Value() );
 	}
+	target->attributeSet.SetIndexNames( attributeSet.IndexNames() );
 
 	TiXmlNode* node = 0;
 	for ( node = firstChild; node; node = node->NextSibling() )
@@ -872,18 +1829,25 @@ void TiXmlElement::CopyTo( TiXmlElement* target ) const
 	}
 }
 
+
+void TiXmlElement::MoveTo( TiXmlElement* target )
+{
+	TiXmlNode::MoveTo( target );
+	attributeSet.MoveTo( &target->attributeSet );
+}
+
 bool TiXmlElement::Accept( TiXmlVisitor* visitor ) const
 {
-	if ( visitor->VisitEnter( *this, attributeSet.First() ) ) 
-	{
-		for ( const TiXmlNode* node=FirstChild(); node; node=node->NextSibling() )
-		{
-			if ( !node->Accept( visitor ) )
-				break;
-		}
-	}
-	return visitor->VisitExit( *this );
+	return AcceptTree( this, visitor );
+}
+
+
+#ifndef TIXML_USE_STL
+bool TiXmlElement::InArena() const
+{
+	return TiXmlNode::InArena() && attributeSet.InArena();
 }
+#endif
 
 
 TiXmlNode* TiXmlElement::Clone() const
@@ -914,6 +1878,14 @@ TiXmlDocument::TiXmlDocument() : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
+	useArena = false;
+	arena = 0;
+	ownOptions = false;
+	#ifndef TIXML_USE_STL
+	names = 0;
+	useInSitu = false;
+	inSitu = 0;
+	#endif
 	ClearError();
 }
 
@@ -921,6 +1893,14 @@ TiXmlDocument::TiXmlDocument( const char * documentName ) : TiXmlNode( TiXmlNode
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
+	useArena = false;
+	arena = 0;
+	ownOptions = false;
+	#ifndef TIXML_USE_STL
+	names = 0;
+	useInSitu = false;
+	inSitu = 0;
+	#endif
 	value = documentName;
 	ClearError();
 }
@@ -931,6 +1911,9 @@ TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiX
 {
 	tabsize = 4;
 	useMicrosoftBOM = false;
+	useArena = false;
+	arena = 0;
+	ownOptions = false;
     value = documentName;
 	ClearError();
 }
@@ -939,10 +1922,27 @@ TiXmlDocument::TiXmlDocument( const std::string& documentName ) : TiXmlNode( TiX
 
 TiXmlDocument::TiXmlDocument( const TiXmlDocument& copy ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
 {
+	arena = 0;
+	#ifndef TIXML_USE_STL
+	names = 0;
+	inSitu = 0;
+	#endif
 	copy.CopyTo( this );
 }
 
 
+TiXmlDocument::~TiXmlDocument()
+{
+	// The nodes may live in the arena, so they have to go first.
+	Clear();
+	delete arena;
+	#ifndef TIXML_USE_STL
+	delete names;
+	delete inSitu;
+	#endif
+}
+
+
 TiXmlDocument& TiXmlDocument::operator=( const TiXmlDocument& copy )
 {
 	Clear();
@@ -951,6 +1951,28 @@ TiXmlDocument& TiXmlDocument::operator=( const TiXmlDocument& copy )
 }
 
 
+TiXmlDocument::TiXmlDocument( TiXmlDocument&& other ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
+{
+	arena = 0;
+	#ifndef TIXML_USE_STL
+	names = 0;
+	inSitu = 0;
+	#endif
+	other.MoveTo( this );
+}
+
+
+TiXmlDocument& TiXmlDocument::operator=( TiXmlDocument&& other )
+{
+	if ( &other != this )
+	{
+		Clear();
+		other.MoveTo( this );
+	}
+	return *this;
+}
+
+
 bool TiXmlDocument::LoadFile( TiXmlEncoding encoding )
 {
 	return LoadFile( Value(), encoding );
@@ -983,6 +2005,51 @@ bool TiXmlDocument::LoadFile( const char* _filename, TiXmlEncoding encoding )
 	}
 }
 
+// Normalize the new lines of the null terminated buffer of a loaded file.
+static void NormalizeNewlines( char* buf, long length )
+{
+	// Process the buffer in place to normalize new lines. (See the comment in LoadFile.)
+	// Copies from the 'p' to 'q' pointer, where p can advance faster if
+	// a newline-carriage return is hit.
+	//
+	// Wikipedia:
+	// Systems based on ASCII or a compatible character set use either LF  (Line feed, '\n', 0x0A, 10 in decimal) or 
+	// CR (Carriage return, '\r', 0x0D, 13 in decimal) individually, or CR followed by LF (CR+LF, 0x0D 0x0A)...
+	//		* LF:    Multics, Unix and Unix-like systems (GNU/Linux, AIX, Xenix, Mac OS X, FreeBSD, etc.), BeOS, Amiga, RISC OS, and others
+    //		* CR+LF: DEC RT-11 and most other early non-Unix, non-IBM OSes, CP/M, MP/M, DOS, OS/2, Microsoft Windows, Symbian OS
+    //		* CR:    Commodore 8-bit machines, Apple II family, Mac OS up to version 9 and OS-9
+
+	const char CR = 0x0d;
+	const char LF = 0x0a;
+	(void)length;	// only checked by the asserts
+
+	// Everything before the first CR stays as it is, and is not written to.
+	char* q = strchr( buf, CR );	// the write head
+	if ( !q )
+		return;
+	const char* p = q;				// the read head
+
+	while( *p ) {
+		assert( p < (buf+length) );
+		assert( q <= (buf+length) );
+		assert( q <= p );
+
+		if ( *p == CR ) {
+			*q++ = LF;
+			p++;
+			if ( *p == LF ) {		// check for CR+LF (and skip LF)
+				p++;
+			}
+		}
+		else {
+			*q++ = *p++;
+		}
+	}
+	assert( q <= (buf+length) );
+	*q = 0;
+}
+
+
 bool TiXmlDocument::LoadFile( FILE* file, TiXmlEncoding encoding )
 {
 	if ( !file ) 
@@ -1029,6 +2096,42 @@ bool TiXmlDocument::LoadFile( FILE* file, TiXmlEncoding encoding )
 	}
 	*/
 
+	#ifndef TIXML_USE_STL
+	// The file is read into the source of an in-situ parse.
+	if ( useInSitu )
+	{
+		char* source = NewSource( length );
+		if ( fread( source, length, 1, file ) != 1 ) {
+			SetError( TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+			return false;
+		}
+		NormalizeNewlines( source, length );
+		ParseSource( source, 0, encoding );
+		return !Error();
+	}
+	#endif
+
+	#ifdef TIXML_USE_MMAP
+	// Map the file privately: the pages are shared with the page cache and only
+	// copied when normalizing the new lines writes to them. The system fills the
+	// rest of the last page with zeros, which terminates the buffer, so a file
+	// ending exactly at a page boundary is read the usual way instead.
+	const long pageSize = sysconf( _SC_PAGESIZE );
+	if ( pageSize > 0 && length % pageSize != 0 )
+	{
+		void* map = mmap( 0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno( file ), 0 );
+		if ( map != MAP_FAILED )
+		{
+			char* buf = static_cast<char*>( map );
+			NormalizeNewlines( buf, length );
+			Parse( buf, 0, encoding );
+
+			munmap( map, length );
+			return !Error();
+		}
+	}
+	#endif
+
 	char* buf = new char[ length+1 ];
 	buf[0] = 0;
 
@@ -1038,41 +2141,8 @@ bool TiXmlDocument::LoadFile( FILE* file, TiXmlEncoding encoding )
 		return false;
 	}
 
-	// Process the buffer in place to normalize new lines. (See comment above.)
-	// Copies from the 'p' to 'q' pointer, where p can advance faster if
-	// a newline-carriage return is hit.
-	//
-	// Wikipedia:
-	// Systems based on ASCII or a compatible character set use either LF  (Line feed, '\n', 0x0A, 10 in decimal) or 
-	// CR (Carriage return, '\r', 0x0D, 13 in decimal) individually, or CR followed by LF (CR+LF, 0x0D 0x0A)...
-	//		* LF:    Multics, Unix and Unix-like systems (GNU/Linux, AIX, Xenix, Mac OS X, FreeBSD, etc.), BeOS, Amiga, RISC OS, and others
-    //		* CR+LF: DEC RT-11 and most other early non-Unix, non-IBM OSes, CP/M, MP/M, DOS, OS/2, Microsoft Windows, Symbian OS
-    //		* CR:    Commodore 8-bit machines, Apple II family, Mac OS up to version 9 and OS-9
-
-	const char* p = buf;	// the read head
-	char* q = buf;			// the write head
-	const char CR = 0x0d;
-	const char LF = 0x0a;
-
 	buf[length] = 0;
-	while( *p ) {
-		assert( p < (buf+length) );
-		assert( q <= (buf+length) );
-		assert( q <= p );
-
-		if ( *p == CR ) {
-			*q++ = LF;
-			p++;
-			if ( *p == LF ) {		// check for CR+LF (and skip LF)
-				p++;
-			}
-		}
-		else {
-			*q++ = *p++;
-		}
-	}
-	assert( q <= (buf+length) );
-	*q = 0;
+	NormalizeNewlines( buf, length );
 
 	Parse( buf, 0, encoding );
 
@@ -1122,6 +2192,12 @@ void TiXmlDocument::CopyTo( TiXmlDocument* target ) const
 	target->tabsize = tabsize;
 	target->errorLocation = errorLocation;
 	target->useMicrosoftBOM = useMicrosoftBOM;
+	target->useArena = useArena;
+	target->options = options;
+	target->ownOptions = ownOptions;
+	#ifndef TIXML_USE_STL
+	target->useInSitu = useInSitu;
+	#endif
 
 	TiXmlNode* node = 0;
 	for ( node = firstChild; node; node = node->NextSibling() )
@@ -1131,6 +2207,37 @@ void TiXmlDocument::CopyTo( TiXmlDocument* target ) const
 }
 
 
+void TiXmlDocument::MoveTo( TiXmlDocument* target )
+{
+	TiXmlNode::MoveTo( target );
+
+	target->error = error;
+	target->errorId = errorId;
+	target->errorDesc = errorDesc;
+	target->tabsize = tabsize;
+	target->errorLocation = errorLocation;
+	target->useMicrosoftBOM = useMicrosoftBOM;
+	target->useArena = useArena;
+	target->options = options;
+	target->ownOptions = ownOptions;
+
+	// The nodes may live in the arena and refer to the pooled names and the
+	// source, so these go with them. 'this' gets the (unused) ones of the target.
+	TiXmlArena* targetArena = target->arena;
+	target->arena = arena;
+	arena = targetArena;
+	#ifndef TIXML_USE_STL
+	target->useInSitu = useInSitu;
+	TiXmlStringPool* targetNames = target->names;
+	target->names = names;
+	names = targetNames;
+	TiXmlInSitu* targetInSitu = target->inSitu;
+	target->inSitu = inSitu;
+	inSitu = targetInSitu;
+	#endif
+}
+
+
 TiXmlNode* TiXmlDocument::Clone() const
 {
 	TiXmlDocument* clone = new TiXmlDocument();
@@ -1145,25 +2252,21 @@ TiXmlNode* TiXmlDocument::Clone() const
 void TiXmlDocument::Print( FILE* cfile, int depth ) const
 {
 	assert( cfile );
-	for ( const TiXmlNode* node=FirstChild(); node; node=node->NextSibling() )
-	{
-		node->Print( cfile, depth );
-		fprintf( cfile, "\n" );
-	}
+	TiXmlFilePrinter printer( cfile, depth );
+	Accept( &printer );
 }
 
 
 bool TiXmlDocument::Accept( TiXmlVisitor* visitor ) const
 {
-	if ( visitor->VisitEnter( *this ) )
-	{
-		for ( const TiXmlNode* node=FirstChild(); node; node=node->NextSibling() )
-		{
-			if ( !node->Accept( visitor ) )
-				break;
-		}
-	}
-	return visitor->VisitExit( *this );
+	return AcceptTree( this, visitor );
+}
+
+
+void TiXmlAttribute::NameChanged()
+{
+	if ( set )
+		set->DropIndex();
 }
 
 
@@ -1235,22 +2338,20 @@ void TiXmlAttribute::Print( FILE* cfile, int /*depth*/, TIXML_STRING* str ) cons
 
 int TiXmlAttribute::QueryIntValue( int* ival ) const
 {
-	if ( TIXML_SSCANF( value.c_str(), "%d", ival ) == 1 )
-		return TIXML_SUCCESS;
-	return TIXML_WRONG_TYPE;
+	return ToInt( value.c_str(), ival );
 }
 
 int TiXmlAttribute::QueryDoubleValue( double* dval ) const
 {
-	if ( TIXML_SSCANF( value.c_str(), "%lf", dval ) == 1 )
-		return TIXML_SUCCESS;
-	return TIXML_WRONG_TYPE;
+	return ToDouble( value.c_str(), dval );
 }
 
 void TiXmlAttribute::SetIntValue( int _value )
 {
 	char buf [64];
-	#if defined(TIXML_SNPRINTF)		
+	#if defined(TIXML_USE_CHARCONV)
+		*std::to_chars( buf, buf + sizeof(buf) - 1, _value ).ptr = 0;
+	#elif defined(TIXML_SNPRINTF)		
 		TIXML_SNPRINTF(buf, sizeof(buf), "%d", _value);
 	#else
 		sprintf (buf, "%d", _value);
@@ -1261,7 +2362,10 @@ void TiXmlAttribute::SetIntValue( int _value )
 void TiXmlAttribute::SetDoubleValue( double _value )
 {
 	char buf [256];
-	#if defined(TIXML_SNPRINTF)		
+	#if defined(TIXML_USE_CHARCONV)
+		// The same as "%g"
+		*std::to_chars( buf, buf + sizeof(buf) - 1, _value, std::chars_format::general, 6 ).ptr = 0;
+	#elif defined(TIXML_SNPRINTF)		
 		TIXML_SNPRINTF( buf, sizeof(buf), "%g", _value);
 	#else
 		sprintf (buf, "%g", _value);
@@ -1271,12 +2375,16 @@ void TiXmlAttribute::SetDoubleValue( double _value )
 
 int TiXmlAttribute::IntValue() const
 {
-	return atoi (value.c_str ());
+	int i = 0;
+	ToInt( value.c_str(), &i );
+	return i;
 }
 
 double  TiXmlAttribute::DoubleValue() const
 {
-	return atof (value.c_str ());
+	double d = 0.0;
+	ToDouble( value.c_str(), &d );
+	return d;
 }
 
 
@@ -1297,11 +2405,8 @@ TiXmlComment& TiXmlComment::operator=( const TiXmlComment& base )
 void TiXmlComment::Print( FILE* cfile, int depth ) const
 {
 	assert( cfile );
-	for ( int i=0; i<depth; i++ )
-	{
-		fprintf( cfile,  "    " );
-	}
-	fprintf( cfile, "<!--%s-->", value.c_str() );
+	TiXmlFilePrinter printer( cfile, depth );
+	Accept( &printer );
 }
 
 
@@ -1332,21 +2437,8 @@ TiXmlNode* TiXmlComment::Clone() const
 void TiXmlText::Print( FILE* cfile, int depth ) const
 {
 	assert( cfile );
-	if ( cdata )
-	{
-		int i;
-		fprintf( cfile, "\n" );
-		for ( i=0; i<depth; i++ ) {
-			fprintf( cfile, "    " );
-		}
-		fprintf( cfile, "<![CDATA[%s]]>\n", value.c_str() );	// unformatted output
-	}
-	else
-	{
-		TIXML_STRING buffer;
-		EncodeString( value, &buffer );
-		fprintf( cfile, "%s", buffer.c_str() );
-	}
+	TiXmlFilePrinter printer( cfile, depth );
+	Accept( &printer );
 }
 
 
@@ -1453,6 +2545,17 @@ bool TiXmlDeclaration::Accept( TiXmlVisitor* visitor ) const
 }
 
 
+#ifndef TIXML_USE_STL
+bool TiXmlDeclaration::InArena() const
+{
+	return TiXmlNode::InArena()
+		&& ArenaAllocated( version.buffer() )
+		&& ArenaAllocated( encoding.buffer() )
+		&& ArenaAllocated( standalone.buffer() );
+}
+#endif
+
+
 TiXmlNode* TiXmlDeclaration::Clone() const
 {	
 	TiXmlDeclaration* clone = new TiXmlDeclaration();
@@ -1467,9 +2570,9 @@ TiXmlNode* TiXmlDeclaration::Clone() const
 
 void TiXmlUnknown::Print( FILE* cfile, int depth ) const
 {
-	for ( int i=0; i<depth; i++ )
-		fprintf( cfile, "    " );
-	fprintf( cfile, "<%s>", value.c_str() );
+	assert( cfile );
+	TiXmlFilePrinter printer( cfile, depth );
+	Accept( &printer );
 }
 
 
@@ -1501,6 +2604,8 @@ TiXmlAttributeSet::TiXmlAttributeSet()
 {
 	sentinel.next = &sentinel;
 	sentinel.prev = &sentinel;
+	indexNames = false;
+	index = 0;
 }
 
 
@@ -1508,6 +2613,66 @@ TiXmlAttributeSet::~TiXmlAttributeSet()
 {
 	assert( sentinel.next == &sentinel );
 	assert( sentinel.prev == &sentinel );
+	delete index;
+}
+
+
+#ifndef TIXML_USE_STL
+bool TiXmlAttributeSet::InArena() const
+{
+	if ( index )
+		return false;
+	for( const TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
+	{
+		if (    !ArenaAllocated( node )
+			 || !ArenaAllocated( node->name.buffer() )
+			 || !ArenaAllocated( node->value.buffer() ) )
+			return false;
+	}
+	return true;
+}
+#endif
+
+
+void TiXmlAttributeSet::Index() const
+{
+	size_t count = 0;
+	for( const TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
+		++count;
+
+	index = new TiXmlNameIndex( count );
+	for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
+		index->Add( &node->name, node );
+}
+
+
+void TiXmlAttributeSet::DropIndex()
+{
+	delete index;
+	index = 0;
+}
+
+
+void TiXmlAttributeSet::MoveTo( TiXmlAttributeSet* target )
+{
+	assert( target->sentinel.next == &target->sentinel );
+
+	if ( sentinel.next != &sentinel )
+	{
+		target->sentinel.next = sentinel.next;
+		target->sentinel.prev = sentinel.prev;
+		sentinel.next->prev = &target->sentinel;
+		sentinel.prev->next = &target->sentinel;
+		sentinel.next = &sentinel;
+		sentinel.prev = &sentinel;
+	}
+	for( TiXmlAttribute* node = target->sentinel.next; node != &target->sentinel; node = node->next )
+		node->set = target;
+
+	target->DropIndex();
+	target->indexNames = indexNames;
+	target->index = index;
+	index = 0;
 }
 
 
@@ -1519,6 +2684,8 @@ void TiXmlAttributeSet::Add( TiXmlAttribute* addMe )
 	assert( !Find( addMe->Name() ) );	// Shouldn't be multiply adding to the set.
 	#endif
 
+	DropIndex();
+	addMe->set = this;
 	addMe->next = &sentinel;
 	addMe->prev = sentinel.prev;
 
@@ -1534,6 +2701,8 @@ void TiXmlAttributeSet::Remove( TiXmlAttribute* removeMe )
 	{
 		if ( node == removeMe )
 		{
+			DropIndex();
+			node->set = 0;
 			node->prev->next = node->next;
 			node->next->prev = node->prev;
 			node->next = 0;
@@ -1546,16 +2715,6 @@ void TiXmlAttributeSet::Remove( TiXmlAttribute* removeMe )
 
 
 #ifdef TIXML_USE_STL
-TiXmlAttribute* TiXmlAttributeSet::Find( const std::string& name ) const
-{
-	for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
-	{
-		if ( node->name == name )
-			return node;
-	}
-	return 0;
-}
-
 TiXmlAttribute* TiXmlAttributeSet::FindOrCreate( const std::string& _name )
 {
 	TiXmlAttribute* attrib = Find( _name );
@@ -1571,12 +2730,43 @@ TiXmlAttribute* TiXmlAttributeSet::FindOrCreate( const std::string& _name )
 
 TiXmlAttribute* TiXmlAttributeSet::Find( const char* name ) const
 {
-	for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
+	if ( index )
+	{
+		const TiXmlNameIndex::Entry* entry = index->Find( name, strlen( name ) );
+		return entry ? static_cast<TiXmlAttribute*>( entry->first ) : 0;
+	}
+
+	TiXmlAttribute* node;
+	int scanned = 0;
+	for( node = sentinel.next; node != &sentinel; node = node->next, ++scanned )
 	{
 		if ( strcmp( node->name.c_str(), name ) == 0 )
-			return node;
+			break;
 	}
-	return 0;
+	if ( indexNames && scanned > indexScanLength )
+		Index();
+	return node != &sentinel ? node : 0;
+}
+
+
+TiXmlAttribute* TiXmlAttributeSet::Find( const TIXML_STRING& name ) const
+{
+	if ( index )
+	{
+		const TiXmlNameIndex::Entry* entry = index->Find( name.c_str(), name.length() );
+		return entry ? static_cast<TiXmlAttribute*>( entry->first ) : 0;
+	}
+
+	TiXmlAttribute* node;
+	int scanned = 0;
+	for( node = sentinel.next; node != &sentinel; node = node->next, ++scanned )
+	{
+		if ( node->name == name )
+			break;
+	}
+	if ( indexNames && scanned > indexScanLength )
+		Index();
+	return node != &sentinel ? node : 0;
 }
 
 
@@ -81,14 +81,23 @@ distribution.
 #endif	
 
 class TiXmlDocument;
+class TiXmlArena;
+class TiXmlStringPool;
+class TiXmlInSitu;
+class TiXmlNameIndex;
 class TiXmlElement;
 class TiXmlComment;
 class TiXmlUnknown;
 class TiXmlAttribute;
+class TiXmlAttributeSet;
 class TiXmlText;
 class TiXmlDeclaration;
 class TiXmlParsingData;
 
+// Memory for nodes, attributes and string buffers (see TiXmlArena.)
+void* TiXmlAllocate( size_t size );
+void TiXmlFree( void* p );
+
 const int TIXML_MAJOR_VERSION = 2;
 const int TIXML_MINOR_VERSION = 6;
 const int TIXML_PATCH_VERSION = 2;
@@ -106,6 +115,56 @@ struct TiXmlCursor
 };
 
 
+/**	Settings of the parser. A TiXmlDocument or TiXmlSaxReader given its own
+	options (see TiXmlDocument::SetParseOptions()) does not use the global
+	settings, so documents with different settings can be parsed on several
+	threads at the same time.
+*/
+struct TiXmlParseOptions
+{
+	TiXmlParseOptions() : condenseWhiteSpace( true ), locateNodes( true ), indexNames( false ) {}
+
+	bool condenseWhiteSpace;	///< See TiXmlBase::SetCondenseWhiteSpace().
+
+	/** Record the row and column of every node (see TiXmlBase::Row().) If false,
+		nodes have no location and the position is only counted when an error
+		occurs, which makes the parse of known good documents faster. The error
+		location is the same in both cases.
+	*/
+	bool locateNodes;
+
+	/** Let the parsed nodes index their children and attributes by name. The
+		index of a node is built by the first name lookup that has to scan many
+		children (or attributes), after which FirstChild(), NextSibling(),
+		FirstChildElement(), NextSiblingElement() and TiXmlElement::Attribute()
+		with a name take constant time on average. Any change of the children or
+		attributes drops the index until the next long lookup.
+
+		The index is built by const methods, so a document with this option must
+		not be read by several threads at the same time.
+	*/
+	bool indexNames;
+
+	/// The options of the parse running on the current thread, 0 if it uses the global settings.
+	static const TiXmlParseOptions* Current();
+};
+
+
+/// Makes the options (or the global settings, if 0) the ones of the parse on the thread while the scope exists.
+class TiXmlParseOptionsScope
+{
+public:
+	TiXmlParseOptionsScope( const TiXmlParseOptions* options );
+	~TiXmlParseOptionsScope();
+
+private:
+	TiXmlParseOptionsScope( const TiXmlParseOptionsScope& );	// not allowed.
+	void operator=( const TiXmlParseOptionsScope& );			// not allowed.
+
+	const TiXmlParseOptions* previous;
+};
+
+
 /**
 	Implements the interface to the "Visitor pattern" (see the Accept() method.)
 	If you call the Accept() method, it requires being passed a TiXmlVisitor
@@ -196,11 +255,16 @@ class TiXmlBase
 	friend class TiXmlNode;
 	friend class TiXmlElement;
 	friend class TiXmlDocument;
+	friend class TiXmlSaxReader;
 
 public:
 	TiXmlBase()	:	userData(0)		{}
 	virtual ~TiXmlBase()			{}
 
+	/// Nodes and attributes are allocated from the current arena, if there is one. (See TiXmlArena.)
+	static void* operator new( size_t size )	{ return TiXmlAllocate( size ); }
+	static void operator delete( void* p )		{ TiXmlFree( p ); }
+
 	/**	All TinyXml classes can print themselves to a filestream
 		or the string class (TiXmlString in non-STL mode, std::string
 		in STL mode.) Either or both cfile and str can be null.
@@ -216,12 +280,23 @@ public:
 		not. In order to make everyone happy, these global, static functions
 		are provided to set whether or not TinyXml will condense all white space
 		into a single space or not. The default is to condense. Note changing this
-		value is not thread safe.
+		value is not thread safe: documents parsed concurrently should have their
+		own setting, see TiXmlDocument::SetParseOptions().
 	*/
 	static void SetCondenseWhiteSpace( bool condense )		{ condenseWhiteSpace = condense; }
 
-	/// Return the current white space setting.
-	static bool IsWhiteSpaceCondensed()						{ return condenseWhiteSpace; }
+	/// Return the current white space setting: the one of the parse running on the thread, if it has its own.
+	static bool IsWhiteSpaceCondensed();
+
+	/** Convert a string to a number, accepting the same input as sscanf's "%d"
+		and "%lf": leading white space and a '+' are skipped, and anything after
+		the number is ignored. Returns TIXML_SUCCESS or TIXML_WRONG_TYPE.
+
+		Where the library has <charconv>, the conversion does not depend on the
+		locale, and integers out of range are TIXML_WRONG_TYPE.
+	*/
+	static int ToInt( const char* str, int* value );
+	static int ToDouble( const char* str, double* value );	///< See ToInt().
 
 	/** Return the position, in the original source file, of this node or attribute.
 		The row and column are 1-based. (That is the first row and first column is
@@ -301,6 +376,8 @@ protected:
 	#ifdef TIXML_USE_STL
 	static bool	StreamWhiteSpace( std::istream * in, TIXML_STRING * tag );
 	static bool StreamTo( std::istream * in, int character, TIXML_STRING * tag );
+	// Like StreamTo(), but reads the character as well.
+	static bool StreamPast( std::istream * in, int character, TIXML_STRING * tag );
 	#endif
 
 	/*	Reads an XML name into the string provided. Returns
@@ -368,7 +445,7 @@ protected:
 								bool ignoreCase,
 								TiXmlEncoding encoding );
 
-	static const char* errorString[ TIXML_ERROR_STRING_COUNT ];
+	static const char* const errorString[ TIXML_ERROR_STRING_COUNT ];
 
 	TiXmlCursor location;
 
@@ -409,7 +486,7 @@ private:
 		MAX_ENTITY_LENGTH = 6
 
 	};
-	static Entity entity[ NUM_ENTITY ];
+	static const Entity entity[ NUM_ENTITY ];
 	static bool condenseWhiteSpace;
 };
 
@@ -505,14 +582,17 @@ public:
 		Text:		the text string
 		@endverbatim
 	*/
-	void SetValue(const char * _value) { value = _value;}
+	void SetValue(const char * _value) { value = _value; ValueChanged(); }
 
     #ifdef TIXML_USE_STL
 	/// STL std::string form.
-	void SetValue( const std::string& _value )	{ value = _value; }
+	void SetValue( const std::string& _value )	{ value = _value; ValueChanged(); }
 	#endif
 
-	/// Delete all the children of this node. Does not affect 'this'.
+	/** Delete all the children of this node. Does not affect 'this'.
+		The descendants are deleted one after the other, so deep documents
+		do not recurse.
+	*/
 	void Clear();
 
 	/// One step up the DOM.
@@ -597,16 +677,31 @@ public:
 	*/
 	TiXmlNode* InsertBeforeChild( TiXmlNode* beforeThis, const TiXmlNode& addThis );
 
+	/** Like InsertBeforeChild(), but 'addThis' is linked instead of copied, and
+		owned by tinyXml from now on (deleted if an error occurs.) See LinkEndChild().
+	*/
+	TiXmlNode* LinkBeforeChild( TiXmlNode* beforeThis, TiXmlNode* addThis );
+
 	/** Add a new node related to this. Adds a child after the specified child.
 		Returns a pointer to the new object or NULL if an error occured.
 	*/
 	TiXmlNode* InsertAfterChild(  TiXmlNode* afterThis, const TiXmlNode& addThis );
 
+	/** Like InsertAfterChild(), but 'addThis' is linked instead of copied, and
+		owned by tinyXml from now on (deleted if an error occurs.) See LinkEndChild().
+	*/
+	TiXmlNode* LinkAfterChild( TiXmlNode* afterThis, TiXmlNode* addThis );
+
 	/** Replace a child of this node.
 		Returns a pointer to the new object or NULL if an error occured.
 	*/
 	TiXmlNode* ReplaceChild( TiXmlNode* replaceThis, const TiXmlNode& withThis );
 
+	/** Like ReplaceChild(), but 'withThis' is linked instead of copied, and
+		owned by tinyXml from now on (deleted if an error occurs.) See LinkEndChild().
+	*/
+	TiXmlNode* LinkReplaceChild( TiXmlNode* replaceThis, TiXmlNode* withThis );
+
 	/// Delete a child of this node.
 	bool RemoveChild( TiXmlNode* removeThis );
 
@@ -744,6 +839,10 @@ protected:
 	// and the assignment operator.
 	void CopyTo( TiXmlNode* target ) const;
 
+	// Move the value and the children to 'target', which has none. Shared
+	// functionality between the move constructors and assignment operators.
+	void MoveTo( TiXmlNode* target );
+
 	#ifdef TIXML_USE_STL
 	    // The real work of the input operator.
 	virtual void StreamIn( std::istream* in, TIXML_STRING* tag ) = 0;
@@ -763,9 +862,25 @@ protected:
 	TiXmlNode*		prev;
 	TiXmlNode*		next;
 
+	// Whether the lookups by name may index the children (see TiXmlParseOptions::indexNames.)
+	bool			indexNames;
+
+	#ifndef TIXML_USE_STL
+	// Whether the node and everything it owns (but its children) came from an
+	// arena, so that Clear() can drop it without running its destructor.
+	virtual bool InArena() const;
+	#endif
+
 private:
 	TiXmlNode( const TiXmlNode& );				// not implemented.
 	void operator=( const TiXmlNode& base );	// not allowed.
+
+	void Index() const;
+	void DropIndex();
+	void ValueChanged()		{ if ( parent && parent->index ) parent->DropIndex(); }
+
+	mutable TiXmlNameIndex*	index;			// children by value, 0 if not built
+	TiXmlNode*		nextSameName;			// next sibling with the same value, while the parent has an index
 };
 
 
@@ -785,6 +900,7 @@ public:
 	TiXmlAttribute() : TiXmlBase()
 	{
 		document = 0;
+		set = 0;
 		prev = next = 0;
 	}
 
@@ -795,6 +911,7 @@ public:
 		name = _name;
 		value = _value;
 		document = 0;
+		set = 0;
 		prev = next = 0;
 	}
 	#endif
@@ -805,6 +922,7 @@ public:
 		name = _name;
 		value = _value;
 		document = 0;
+		set = 0;
 		prev = next = 0;
 	}
 
@@ -818,6 +936,7 @@ public:
 
 	// Get the tinyxml string representation
 	const TIXML_STRING& NameTStr() const { return name; }
+	const TIXML_STRING& ValueTStr() const { return value; }
 
 	/** QueryIntValue examines the value string. It is an alternative to the
 		IntValue() method with richer error checking.
@@ -832,7 +951,7 @@ public:
 	/// QueryDoubleValue examines the value string. See QueryIntValue().
 	int QueryDoubleValue( double* _value ) const;
 
-	void SetName( const char* _name )	{ name = _name; }				///< Set the name of this attribute.
+	void SetName( const char* _name )	{ name = _name; NameChanged(); }	///< Set the name of this attribute.
 	void SetValue( const char* _value )	{ value = _value; }				///< Set the value.
 
 	void SetIntValue( int _value );										///< Set the value from an integer.
@@ -840,7 +959,7 @@ public:
 
     #ifdef TIXML_USE_STL
 	/// STL std::string form.
-	void SetName( const std::string& _name )	{ name = _name; }	
+	void SetName( const std::string& _name )	{ name = _name; NameChanged(); }
 	/// STL std::string form.	
 	void SetValue( const std::string& _value )	{ value = _value; }
 	#endif
@@ -880,7 +999,10 @@ private:
 	TiXmlAttribute( const TiXmlAttribute& );				// not implemented.
 	void operator=( const TiXmlAttribute& base );	// not allowed.
 
+	void NameChanged();
+
 	TiXmlDocument*	document;	// A pointer back to a document, for error reporting.
+	TiXmlAttributeSet*	set;	// The set the attribute is in, to keep its index up to date.
 	TIXML_STRING name;
 	TIXML_STRING value;
 	TiXmlAttribute*	prev;
@@ -915,13 +1037,24 @@ public:
 	TiXmlAttribute* Last()					{ return ( sentinel.prev == &sentinel ) ? 0 : sentinel.prev; }
 
 	TiXmlAttribute*	Find( const char* _name ) const;
+	TiXmlAttribute*	Find( const TIXML_STRING& _name ) const;
 	TiXmlAttribute* FindOrCreate( const char* _name );
 
 #	ifdef TIXML_USE_STL
-	TiXmlAttribute*	Find( const std::string& _name ) const;
 	TiXmlAttribute* FindOrCreate( const std::string& _name );
 #	endif
 
+	// Move all attributes to the empty 'target'.
+	void MoveTo( TiXmlAttributeSet* target );
+
+	// Let Find() index the attributes by name (see TiXmlParseOptions::indexNames.)
+	void SetIndexNames( bool _indexNames )	{ indexNames = _indexNames; if ( !indexNames ) DropIndex(); }
+	bool IndexNames() const					{ return indexNames; }
+
+	#ifndef TIXML_USE_STL
+	// Whether all attributes and their strings came from an arena.
+	bool InArena() const;
+	#endif
 
 private:
 	//*ME:	Because of hidden/disabled copy-construktor in TiXmlAttribute (sentinel-element),
@@ -929,7 +1062,14 @@ private:
 	TiXmlAttributeSet( const TiXmlAttributeSet& );	// not allowed
 	void operator=( const TiXmlAttributeSet& );	// not allowed (as TiXmlAttribute)
 
+	friend class TiXmlAttribute;
+
+	void Index() const;
+	void DropIndex();
+
 	TiXmlAttribute sentinel;
+	bool indexNames;
+	mutable TiXmlNameIndex* index;	// attributes by name, 0 if not built
 };
 
 
@@ -952,6 +1092,13 @@ public:
 
 	TiXmlElement& operator=( const TiXmlElement& base );
 
+	/** Take the name, attributes and children of 'other' without copying them.
+		'other' is left empty (but still linked where it was.)
+	*/
+	TiXmlElement( TiXmlElement&& other );
+
+	TiXmlElement& operator=( TiXmlElement&& other );
+
 	virtual ~TiXmlElement();
 
 	/** Given an attribute name, Attribute() returns the value
@@ -992,6 +1139,15 @@ public:
 	int QueryBoolAttribute( const char* name, bool* _value ) const;
 	/// QueryDoubleAttribute examines the attribute - see QueryIntAttribute().
 	int QueryDoubleAttribute( const char* name, double* _value ) const;
+	/** QueryIntAttributes reads several integer attributes with a single pass
+		over the attributes of the element. The value of names[i] is stored in
+		values[i], as QueryIntAttribute() would. Values of attributes that are
+		missing or not integers are left unchanged. Returns the number of
+		values read.
+	*/
+	int QueryIntAttributes( const char* const* names, int* values, int count ) const;
+	/// QueryDoubleAttributes reads several attributes - see QueryIntAttributes().
+	int QueryDoubleAttributes( const char* const* names, double* values, int count ) const;
 	/// QueryFloatAttribute examines the attribute - see QueryIntAttribute().
 	int QueryFloatAttribute( const char* name, float* _value ) const {
 		double d;
@@ -1140,6 +1296,7 @@ public:
 protected:
 
 	void CopyTo( TiXmlElement* target ) const;
+	void MoveTo( TiXmlElement* target );
 	void ClearThis();	// like clear, but initializes 'this' object as well
 
 	// Used to be public [internal use]
@@ -1153,6 +1310,10 @@ protected:
 	const char* ReadValue( const char* in, TiXmlParsingData* prevData, TiXmlEncoding encoding );
 
 private:
+	#ifndef TIXML_USE_STL
+	virtual bool InArena() const;
+	#endif
+
 	TiXmlAttributeSet attributeSet;
 };
 
@@ -1337,6 +1498,9 @@ protected:
 	#endif
 
 private:
+	#ifndef TIXML_USE_STL
+	virtual bool InArena() const;
+	#endif
 
 	TIXML_STRING version;
 	TIXML_STRING encoding;
@@ -1406,7 +1570,14 @@ public:
 	TiXmlDocument( const TiXmlDocument& copy );
 	TiXmlDocument& operator=( const TiXmlDocument& copy );
 
-	virtual ~TiXmlDocument() {}
+	/** Take the nodes of 'other' without copying them, together with its arena,
+		name pool and in-situ source (the memory of the nodes.) 'other' is left
+		empty. This is the cheap way to hand a parsed document to another thread.
+	*/
+	TiXmlDocument( TiXmlDocument&& other );
+	TiXmlDocument& operator=( TiXmlDocument&& other );
+
+	virtual ~TiXmlDocument();
 
 	/** Load a file using the current document value.
 		Returns true if successful. Will delete any existing
@@ -1505,6 +1676,49 @@ public:
 
 	int TabSize() const	{ return tabsize; }
 
+	/** SetUseArena() makes the parser allocate nodes, attributes and strings from
+		a per-document arena (see TiXmlArena), so that a parse is a handful of large
+		allocations. The arena is released at once when the document is destroyed,
+		and reused when an empty document is parsed again (e.g. by LoadFile().)
+		Nodes and strings created after the parse are allocated as usual.
+
+		Like the tab size, it needs to be enabled before the parse or load.
+	*/
+	void SetUseArena( bool use )		{ useArena = use; }
+
+	bool UseArena() const	{ return useArena; }
+
+	/// The arena of the document, 0 if it was never used.
+	const TiXmlArena* Arena() const		{ return arena; }
+
+	/** SetParseOptions() gives the document its own parser settings, used instead
+		of the global ones by Parse() and LoadFile(). Documents with their own
+		options can be parsed on several threads at the same time.
+	*/
+	void SetParseOptions( const TiXmlParseOptions& _options )	{ options = _options; ownOptions = true; }
+
+	/// The options of the document, 0 if it uses the global settings.
+	const TiXmlParseOptions* ParseOptions() const	{ return ownOptions ? &options : 0; }
+
+	#ifndef TIXML_USE_STL
+	/** SetInSitu() makes Parse() and LoadFile() keep the source in the document
+		and parse it in place: names, text, comments and attribute values are not
+		copied but refer to the source, entities are decoded over it. Parse()
+		copies its input once, LoadFile() reads the file straight into the source.
+
+		The source is released when the document is destroyed, and reused when
+		an empty document is parsed again. A string of a node is copied before it
+		is changed, so the nodes can be used as usual. Nodes detached from the
+		document must not outlive it, or be kept across a parse of the empty
+		document.
+
+		Like the tab size, it needs to be enabled before the parse or load.
+	*/
+	void SetInSitu( bool use )		{ useInSitu = use; }
+
+	bool InSitu() const	{ return useInSitu; }
+	#endif
+
 	/** If you have handled the error, it can be reset with this call. The error
 		state is automatically cleared if you Parse a new XML block.
 	*/
@@ -1545,6 +1759,13 @@ protected :
 
 private:
 	void CopyTo( TiXmlDocument* target ) const;
+	void MoveTo( TiXmlDocument* target );
+	// Parse 'p' in place if parsing in situ.
+	const char* ParseSource( const char* p, TiXmlParsingData* prevData, TiXmlEncoding encoding );
+	#ifndef TIXML_USE_STL
+	// A buffer for the in-situ source, of 'length' characters plus the terminator.
+	char* NewSource( size_t length );
+	#endif
 
 	bool error;
 	int  errorId;
@@ -1552,9 +1773,213 @@ private:
 	int tabsize;
 	TiXmlCursor errorLocation;
 	bool useMicrosoftBOM;		// the UTF-8 BOM were found when read. Note this, and try to write.
+	bool useArena;
+	TiXmlArena* arena;
+	TiXmlParseOptions options;
+	bool ownOptions;
+	#ifndef TIXML_USE_STL
+	TiXmlStringPool* names;		// the names of the parsed nodes and attributes
+	bool useInSitu;
+	TiXmlInSitu* inSitu;		// the sources the nodes refer to
+	#endif
+};
+
+
+/**	A bump allocator with chunked growth. Memory is taken from large chunks and
+	only released all at once by Reset() or the destructor.
+
+	While a TiXmlArenaScope is active, all TinyXml nodes, attributes and (non-STL)
+	string buffers of the thread are allocated from its arena. Deleting them does
+	not free anything; the memory is reused after the next Reset(). Without STL,
+	nodes which own nothing outside of the arena are not even destroyed when
+	their parent is cleared: they are simply left to the arena. Allocations
+	made outside of a scope go to the heap as usual, and the two kinds can be
+	mixed freely in one document.
+
+	Normally you do not use this class directly: see TiXmlDocument::SetUseArena().
+*/
+class TiXmlArena
+{
+public:
+	TiXmlArena();
+	~TiXmlArena();
+
+	/// Allocate memory aligned for any type.
+	void* Allocate( size_t size );
+
+	/** Release all allocations. The largest chunk is kept for reuse. Nothing
+		allocated from the arena may be used afterwards.
+	*/
+	void Reset();
+
+	/// Number of chunks currently held.
+	int ChunkCount() const;
+	/// Number of bytes handed out since the last Reset().
+	size_t BytesAllocated() const		{ return allocated; }
+
+	/// The arena used by the current thread, 0 if none.
+	static TiXmlArena* Current();
+
+private:
+	friend class TiXmlArenaScope;
+
+	TiXmlArena( const TiXmlArena& );		// not allowed.
+	void operator=( const TiXmlArena& );	// not allowed.
+
+	struct Chunk
+	{
+		Chunk* next;
+		size_t size;
+		size_t used;
+	};
+
+	Chunk* NewChunk( size_t size );
+	static char* Data( Chunk* chunk )	{ return reinterpret_cast<char*>( chunk ) + chunkHeaderSize; }
+
+	static const size_t chunkHeaderSize;	// the data of a chunk follows its header
+
+	Chunk* chunks;				// the chunk in use is the first one
+	size_t allocated;
+	size_t nextChunkSize;
 };
 
 
+/// Makes an arena (or none, if 0) the current one of the thread while the scope exists.
+class TiXmlArenaScope
+{
+public:
+	TiXmlArenaScope( TiXmlArena* arena );
+	~TiXmlArenaScope();
+
+private:
+	TiXmlArenaScope( const TiXmlArenaScope& );	// not allowed.
+	void operator=( const TiXmlArenaScope& );	// not allowed.
+
+	TiXmlArena* previous;
+};
+
+
+#ifndef TIXML_USE_STL
+/**	A set of read-only strings. Equal names read by the parser share one buffer
+	of the pool instead of each allocating their own. Names short enough for the
+	inline buffer of TiXmlString are not pooled, they need no allocation anyway.
+
+	The buffers live until Clear() or the destruction of the pool. A string that
+	is changed first copies its buffer, so pooled names can be modified as usual.
+
+	Normally you do not use this class directly: every TiXmlDocument has one for
+	the names it parses.
+*/
+class TiXmlStringPool
+{
+public:
+	TiXmlStringPool();
+	~TiXmlStringPool();
+
+	/// Make 'out' share the pooled copy of the 'len' characters at 'str'.
+	void Intern( const char* str, size_t len, TiXmlString* out );
+
+	/// Release all buffers. No string may share one of them anymore.
+	void Clear();
+
+	/// Number of distinct strings in the pool.
+	size_t Size() const		{ return count; }
+
+	/// The pool used by the parser on the current thread, 0 if none.
+	static TiXmlStringPool* Current();
+
+private:
+	friend class TiXmlStringPoolScope;
+
+	TiXmlStringPool( const TiXmlStringPool& );		// not allowed.
+	void operator=( const TiXmlStringPool& );		// not allowed.
+
+	typedef TiXmlString::Rep Rep;
+
+	void Grow();
+
+	TiXmlArena storage;		// the pooled buffers
+	Rep** table;			// open addressing, the size is a power of 2
+	size_t tableSize;
+	size_t count;
+};
+
+
+/// Makes a string pool (or none, if 0) the current one of the thread while the scope exists.
+class TiXmlStringPoolScope
+{
+public:
+	TiXmlStringPoolScope( TiXmlStringPool* pool );
+	~TiXmlStringPoolScope();
+
+private:
+	TiXmlStringPoolScope( const TiXmlStringPoolScope& );	// not allowed.
+	void operator=( const TiXmlStringPoolScope& );			// not allowed.
+
+	TiXmlStringPool* previous;
+};
+
+
+/**	The sources of in-situ parses. The strings read by the parser refer to the
+	source instead of copying it. The character following a view is still needed
+	by the parser, so the views are terminated when the parse is done: see
+	Finish().
+
+	Normally you do not use this class directly: see TiXmlDocument::SetInSitu().
+*/
+class TiXmlInSitu
+{
+public:
+	TiXmlInSitu();
+	~TiXmlInSitu();
+
+	/// A buffer for 'length' characters plus the terminator, which lives until Clear().
+	char* NewSource( size_t length );
+
+	/// Make 'out' refer to the 'len' characters at 'str', a part of a source.
+	void View( char* str, size_t len, TiXmlString* out );
+
+	/// Terminate the views made since the last call.
+	void Finish();
+
+	/// Release all sources. No string may refer to them anymore.
+	void Clear();
+
+	/// The in-situ parse of the current thread, 0 if none.
+	static TiXmlInSitu* Current();
+
+	/// [internal use] The position of the parse. Text decoded in place is counted before it changes.
+	TiXmlParsingData* data;
+
+private:
+	friend class TiXmlInSituScope;
+
+	TiXmlInSitu( const TiXmlInSitu& );			// not allowed.
+	void operator=( const TiXmlInSitu& );		// not allowed.
+
+	TiXmlArena sources;
+	char** terminators;			// where the views end
+	size_t terminatorCount;
+	size_t terminatorCapacity;
+};
+
+
+/// Makes an in-situ parse (or none, if 0) the current one of the thread while the scope exists, and finishes it.
+class TiXmlInSituScope
+{
+public:
+	TiXmlInSituScope( TiXmlInSitu* inSitu, TiXmlParsingData* data );
+	~TiXmlInSituScope();
+
+private:
+	TiXmlInSituScope( const TiXmlInSituScope& );	// not allowed.
+	void operator=( const TiXmlInSituScope& );		// not allowed.
+
+	TiXmlInSitu* previous;
+};
+#endif
+
+
 /**
 	A TiXmlHandle is a class that wraps a node pointer with null checks; this is
 	an incredibly useful thing. Note that TiXmlHandle is not part of the TinyXml
@@ -1783,6 +2208,8 @@ public:
 
 private:
 	void DoIndent()	{
+		if ( indent.empty() )
+			return;		// deep documents would spin for nothing
 		for( int i=0; i<depth; ++i )
 			buffer += indent;
 	}
@@ -1798,6 +2225,115 @@ private:
 };
 
 
+/**	Implements the callbacks of the streaming parser (see TiXmlSaxReader.)
+	Events are delivered in document order: StartElement(), then one Attribute()
+	call per attribute, then the content (Text() and nested elements), then
+	EndElement(). Empty elements (<foo/>) get an EndElement() right after their
+	attributes. Comments, declarations and unknown nodes are skipped.
+
+	The strings passed to the callbacks are only valid during the call.
+
+	If you return 'false' from a callback, parsing stops. All methods have a
+	default implementation that returns 'true' (continue parsing).
+*/
+class TiXmlSaxHandler
+{
+public:
+	virtual ~TiXmlSaxHandler() {}
+
+	/// An element has been opened.
+	virtual bool StartElement( const char* /*name*/ )							{ return true; }
+	/// An attribute of the element opened last.
+	virtual bool Attribute( const char* /*name*/, const char* /*value*/ )		{ return true; }
+	/// Text content of the current element. Entities are translated, CDATA sections are passed as is.
+	virtual bool Text( const char* /*text*/, bool /*cdata*/ )					{ return true; }
+	/// An element has been closed.
+	virtual bool EndElement( const char* /*name*/ )								{ return true; }
+};
+
+
+/**	A streaming, callback-driven parser. It uses the same scanning code as
+	TiXmlDocument::Parse(), but does not build any nodes: the events go
+	straight to a TiXmlSaxHandler. Only the names of the open elements are
+	kept, so memory does not grow with the size of the document.
+	Unlike the DOM, duplicate attributes are not reported as an error.
+
+	LoadFile() reads the file in chunks; the chunk buffer only grows if a
+	single tag or text run does not fit into it.
+
+	@verbatim
+	MyHandler handler;
+	TiXmlSaxReader reader( &handler );
+	if ( !reader.LoadFile( "zones.xml" ) )
+		printf( "%s at %d,%d\n", reader.ErrorDesc(), reader.ErrorRow(), reader.ErrorCol() );
+	@endverbatim
+*/
+class TiXmlSaxReader
+{
+public:
+	TiXmlSaxReader( TiXmlSaxHandler* _handler );
+	~TiXmlSaxReader();
+
+	/// Parse a null terminated document. Returns true if there was no error (also if the handler stopped the parse.)
+	bool Parse( const char* p, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+
+	/// Stream a file through the handler. Returns true if there was no error.
+	bool LoadFile( const char* filename, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+	/// Stream an open file through the handler, starting at the current position. The file is not closed.
+	bool LoadFile( FILE* file, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+
+	/// True if the handler stopped the parse.
+	bool Stopped() const				{ return stopped; }
+
+	/// Error reporting, same as in TiXmlDocument.
+	bool Error() const					{ return error; }
+	int ErrorId() const					{ return errorId; }
+	const char* ErrorDesc() const		{ return errorDesc.c_str(); }
+	int ErrorRow() const				{ return errorLocation.row+1; }
+	int ErrorCol() const				{ return errorLocation.col+1; }
+
+	/// Tab size used for the error location, see TiXmlDocument::SetTabSize()
+	void SetTabSize( int _tabsize )		{ tabsize = _tabsize; }
+	int TabSize() const					{ return tabsize; }
+
+	/// Parser settings used instead of the global ones, see TiXmlDocument::SetParseOptions()
+	void SetParseOptions( const TiXmlParseOptions& _options )	{ options = _options; ownOptions = true; }
+	const TiXmlParseOptions* ParseOptions() const	{ return ownOptions ? &options : 0; }
+
+private:
+	TiXmlSaxReader( const TiXmlSaxReader& );		// not allowed.
+	void operator=( const TiXmlSaxReader& );		// not allowed.
+
+	void Reset();
+
+	// Parse the complete items (tags, text runs, comments...) in the buffer. Returns the
+	// start of the first incomplete item, or 0 if the parse is finished (done, error, or stopped.)
+	const char* ParseItems( const char* p, bool last, TiXmlParsingData* data, TiXmlEncoding* encoding );
+	const char* ParseElement( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding );
+	const char* ParseEndTag( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding );
+
+	// Returns the end of the item at p (for text, past the '<' which ends it), or 0 if the buffer ends before the item does.
+	static const char* FindItemEnd( const char* p, TiXmlEncoding encoding );
+
+	void SetError( int err, const char* pError, TiXmlParsingData* data, TiXmlEncoding encoding );
+
+	TiXmlSaxHandler* handler;
+	TIXML_STRING* openElements;		// names of the open elements, one string per depth
+	int depth;
+	int capacity;
+	bool started;					// a node has been read
+	bool done;						// reached the end of the document content
+	bool stopped;
+	bool error;
+	int errorId;
+	TIXML_STRING errorDesc;
+	TiXmlCursor errorLocation;
+	int tabsize;
+	TiXmlParseOptions options;
+	bool ownOptions;
+};
+
+
 #ifdef _MSC_VER
 #pragma warning( pop )
 #endif
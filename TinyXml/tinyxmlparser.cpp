@@ -37,10 +37,189 @@ distribution.
 #	endif
 #endif
 
+// The scanners below look at 16 (SSE2) or 32 (AVX2) bytes at a time to find the
+// next byte the parser has to look at. They only skip ASCII, everything else is
+// left to the byte-wise code. Define TIXML_NO_SIMD to turn them off.
+#if !defined( TIXML_NO_SIMD ) && defined( __AVX2__ )
+#	include <immintrin.h>
+#	define TIXML_SIMD
+#	define TIXML_SIMD_WIDTH 32
+#elif !defined( TIXML_NO_SIMD ) && ( defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+#	include <emmintrin.h>
+#	define TIXML_SIMD
+#	define TIXML_SIMD_WIDTH 16
+#endif
+
+#ifdef TIXML_SIMD
+
+#if defined( _MSC_VER )
+#	include <intrin.h>
+#endif
+
+// A vector load may read past the null terminator, but never into the next
+// page, so it cannot fault. Address sanitizers do not know that.
+#if defined( __GNUC__ ) || defined( __clang__ )
+#	define TIXML_NO_SANITIZE __attribute__(( no_sanitize_address ))
+#else
+#	define TIXML_NO_SANITIZE
+#endif
+
+namespace
+{
+	#if TIXML_SIMD_WIDTH == 32
+	typedef __m256i Vector;
+	TIXML_NO_SANITIZE inline Vector Load( const char* p )	{ return _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) ); }
+	inline Vector Splat( char c )					{ return _mm256_set1_epi8( c ); }
+	inline Vector Equal( Vector a, Vector b )		{ return _mm256_cmpeq_epi8( a, b ); }
+	inline Vector Greater( Vector a, Vector b )		{ return _mm256_cmpgt_epi8( a, b ); }	// signed
+	inline Vector And( Vector a, Vector b )			{ return _mm256_and_si256( a, b ); }
+	inline Vector Or( Vector a, Vector b )			{ return _mm256_or_si256( a, b ); }
+	inline unsigned Mask( Vector a )				{ return (unsigned) _mm256_movemask_epi8( a ); }
+	const unsigned allBytes = 0xffffffffu;
+	#else
+	typedef __m128i Vector;
+	TIXML_NO_SANITIZE inline Vector Load( const char* p )	{ return _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) ); }
+	inline Vector Splat( char c )					{ return _mm_set1_epi8( c ); }
+	inline Vector Equal( Vector a, Vector b )		{ return _mm_cmpeq_epi8( a, b ); }
+	inline Vector Greater( Vector a, Vector b )		{ return _mm_cmpgt_epi8( a, b ); }	// signed
+	inline Vector And( Vector a, Vector b )			{ return _mm_and_si128( a, b ); }
+	inline Vector Or( Vector a, Vector b )			{ return _mm_or_si128( a, b ); }
+	inline unsigned Mask( Vector a )				{ return (unsigned) _mm_movemask_epi8( a ); }
+	const unsigned allBytes = 0xffffu;
+	#endif
+
+	inline int FirstBit( unsigned mask )
+	{
+		#if defined( _MSC_VER )
+		unsigned long index;
+		_BitScanForward( &index, mask );
+		return (int) index;
+		#else
+		return __builtin_ctz( mask );
+		#endif
+	}
+
+	inline bool InOnePage( const char* p )
+	{
+		// Pages are at least 4k everywhere.
+		return ( reinterpret_cast<size_t>( p ) & 4095 ) <= 4096 - TIXML_SIMD_WIDTH;
+	}
+
+	// Returns p advanced over the bytes the class accepts. The null terminator is never accepted.
+	template< class CharClass >
+	TIXML_NO_SANITIZE const char* Scan( const char* p, const CharClass& charClass )
+	{
+		for( ;; )
+		{
+			if ( InOnePage( p ) )
+			{
+				unsigned stop = ~charClass.Accept( Load( p ) ) & allBytes;
+				if ( stop )
+					return p + FirstBit( stop );
+				p += TIXML_SIMD_WIDTH;
+			}
+			else
+			{
+				if ( !charClass.Accept( *p ) )
+					return p;
+				++p;
+			}
+		}
+	}
+
+	// ' ', '\t', '\n', '\v', '\f', '\r': the white space of isspace() in the "C" locale.
+	struct SpaceClass
+	{
+		SpaceClass() : space( Splat( ' ' ) ), belowTab( Splat( '\t' - 1 ) ), aboveReturn( Splat( '\r' + 1 ) ) {}
+
+		unsigned Accept( Vector v ) const
+		{
+			return Mask( Or( Equal( v, space ), And( Greater( v, belowTab ), Greater( aboveReturn, v ) ) ) );
+		}
+		bool Accept( char c ) const		{ return c == ' ' || ( c >= '\t' && c <= '\r' ); }
+
+		Vector space, belowTab, aboveReturn;
+	};
+
+	// Text copied as it is: ASCII above 'lowest', except for entities and the 'stop' character.
+	struct TextClass
+	{
+		TextClass( char _stop, char _lowest ) : stop( _stop ), lowest( _lowest ),
+			stopVector( Splat( _stop ) ), lowestVector( Splat( _lowest ) ), amp( Splat( '&' ) ) {}
+
+		unsigned Accept( Vector v ) const
+		{
+			return Mask( Greater( v, lowestVector ) ) & ~Mask( Or( Equal( v, stopVector ), Equal( v, amp ) ) );
+		}
+		bool Accept( char c ) const		{ return (signed char) c > lowest && c != stop && c != '&'; }
+
+		char stop, lowest;
+		Vector stopVector, lowestVector, amp;
+	};
+
+	// ASCII letters, digits, '_', '-', '.' and ':'.
+	struct NameClass
+	{
+		NameClass() : lowerCase( Splat( 0x20 ) ), belowA( Splat( 'a' - 1 ) ), aboveZ( Splat( 'z' + 1 ) ),
+			belowDash( Splat( '-' - 1 ) ), aboveColon( Splat( ':' + 1 ) ), slash( Splat( '/' ) ), underscore( Splat( '_' ) ) {}
+
+		unsigned Accept( Vector v ) const
+		{
+			Vector lower = Or( v, lowerCase );
+			Vector letter = And( Greater( lower, belowA ), Greater( aboveZ, lower ) );
+			// '-' to ':' are "-./0123456789:"
+			Vector digitEtc = And( Greater( v, belowDash ), Greater( aboveColon, v ) );
+			return Mask( Or( Or( letter, digitEtc ), Equal( v, underscore ) ) ) & ~Mask( Equal( v, slash ) );
+		}
+		bool Accept( char c ) const
+		{
+			return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '-' && c <= ':' && c != '/' ) || c == '_';
+		}
+
+		Vector lowerCase, belowA, aboveZ, belowDash, aboveColon, slash, underscore;
+	};
+}
+
+#endif	// TIXML_SIMD
+
+
+// Skip ASCII white space quickly. What remains is for the byte-wise checks.
+static const char* ScanWhiteSpace( const char* p )
+{
+	#ifdef TIXML_SIMD
+	return Scan( p, SpaceClass() );
+	#else
+	return p;
+	#endif
+}
+
+
+// Skip ASCII name characters quickly.
+static const char* ScanName( const char* p )
+{
+	#ifdef TIXML_SIMD
+	return Scan( p, NameClass() );
+	#else
+	return p;
+	#endif
+}
+
+
+// Skip text that is copied as it is: ASCII above 'lowest', no entities and no 'stop'.
+static const char* ScanText( const char* p, char stop, char lowest )
+{
+	#ifdef TIXML_SIMD
+	return Scan( p, TextClass( stop, lowest ) );
+	#else
+	(void) stop; (void) lowest;
+	return p;
+	#endif
+}
+
 // Note tha "PutString" hardcodes the same list. This
 // is less flexible than it appears. Changing the entries
 // or order will break putstring.	
-TiXmlBase::Entity TiXmlBase::entity[ TiXmlBase::NUM_ENTITY ] = 
+const TiXmlBase::Entity TiXmlBase::entity[ TiXmlBase::NUM_ENTITY ] = 
 {
 	{ "&amp;",  5, '&' },
 	{ "&lt;",   4, '<' },
@@ -171,25 +350,37 @@ void TiXmlBase::ConvertUTF32ToUTF8( unsigned long input, char* output, int* leng
 class TiXmlParsingData
 {
 	friend class TiXmlDocument;
+	friend class TiXmlSaxReader;
   public:
 	void Stamp( const char* now, TiXmlEncoding encoding );
 
 	const TiXmlCursor& Cursor() const	{ return cursor; }
 
+	// Whether the nodes record their location. If not, Stamp() is only called
+	// for errors, and counts the position from the last stamp up to the error.
+	bool LocateNodes() const			{ return locateNodes; }
+
+	// Whether the elements may index their children and attributes by name.
+	bool IndexNames() const				{ return indexNames; }
+
   private:
 	// Only used by the document!
-	TiXmlParsingData( const char* start, int _tabsize, int row, int col )
+	TiXmlParsingData( const char* start, int _tabsize, int row, int col, bool _locateNodes = true, bool _indexNames = false )
 	{
 		assert( start );
 		stamp = start;
 		tabsize = _tabsize;
 		cursor.row = row;
 		cursor.col = col;
+		locateNodes = _locateNodes;
+		indexNames = _indexNames;
 	}
 
 	TiXmlCursor		cursor;
 	const char*		stamp;
 	int				tabsize;
+	bool			locateNodes;
+	bool			indexNames;
 };
 
 
@@ -321,6 +512,7 @@ const char* TiXmlBase::SkipWhiteSpace( const char* p, TiXmlEncoding encoding )
 	{
 		while ( *p )
 		{
+			p = ScanWhiteSpace( p );
 			const unsigned char* pU = (const unsigned char*)p;
 			
 			// Skip the stupid Microsoft UTF-8 Byte order marks
@@ -354,6 +546,7 @@ const char* TiXmlBase::SkipWhiteSpace( const char* p, TiXmlEncoding encoding )
 	}
 	else
 	{
+		p = ScanWhiteSpace( p );
 		while ( *p && IsWhiteSpace( *p ) )
 			++p;
 	}
@@ -364,40 +557,89 @@ const char* TiXmlBase::SkipWhiteSpace( const char* p, TiXmlEncoding encoding )
 #ifdef TIXML_USE_STL
 /*static*/ bool TiXmlBase::StreamWhiteSpace( std::istream * in, TIXML_STRING * tag )
 {
+	if ( !in->good() ) return false;
+
+	// Straight from the stream buffer: peek() and get() are expensive for a
+	// single character, and the indentation is read for every line.
+	std::streambuf* buffer = in->rdbuf();
 	for( ;; )
 	{
-		if ( !in->good() ) return false;
-
-		int c = in->peek();
+		int c = buffer->sgetc();
+		if ( c == std::char_traits<char>::eof() )
+		{
+			in->setstate( std::ios::eofbit );
+			return true;
+		}
 		// At this scope, we can't get to a document. So fail silently.
 		if ( !IsWhiteSpace( c ) || c <= 0 )
 			return true;
 
-		*tag += (char) in->get();
+		*tag += (char) buffer->sbumpc();
 	}
 }
 
 /*static*/ bool TiXmlBase::StreamTo( std::istream * in, int character, TIXML_STRING * tag )
 {
 	//assert( character > 0 && character < 128 );	// else it won't work in utf-8
-	while ( in->good() )
+	if ( !in->good() )
+		return false;
+
+	// Scan the stream buffer itself, peek() and get() are expensive for a single
+	// character. The characters are appended to the tag in blocks.
+	std::streambuf* source = in->rdbuf();
+	char buffer[ 4*1024 ];
+	size_t length = 0;
+	int c;
+	for( ;; )
 	{
-		int c = in->peek();
-		if ( c == character )
-			return true;
-		if ( c <= 0 )		// Silent failure: can't get document at this scope
-			return false;
+		c = source->sgetc();
+		if ( c == character || c <= 0 )
+			break;
+		buffer[ length++ ] = (char) c;
+		if ( length == sizeof( buffer ) )
+		{
+			tag->append( buffer, length );
+			length = 0;
+		}
+		source->sbumpc();
+	}
+	tag->append( buffer, length );
+
+	if ( c == std::char_traits<char>::eof() )
+		in->setstate( std::ios::eofbit );
+	return c == character;		// Silent failure: can't get document at this scope
+}
 
-		in->get();
-		*tag += (char) c;
+/*static*/ bool TiXmlBase::StreamPast( std::istream * in, int character, TIXML_STRING * tag )
+{
+	if ( !StreamTo( in, character, tag ) )
+	{
+		in->get();		// the null, or the end of the stream
+		return false;
 	}
-	return false;
+	*tag += (char) in->rdbuf()->sbumpc();
+	return true;
 }
 #endif
 
 // One of TinyXML's more performance demanding functions. Try to keep the memory overhead down. The
 // "assign" optimization removes over 10% of the execution time.
 //
+// Set a string to the characters of the source from 'start' to 'end'. In an
+// in-situ parse, the string refers to them instead of copying.
+static void AssignSource( TIXML_STRING* str, const char* start, const char* end )
+{
+	#ifndef TIXML_USE_STL
+	if ( TiXmlInSitu* inSitu = TiXmlInSitu::Current() )
+	{
+		inSitu->View( const_cast<char*>( start ), end - start, str );
+		return;
+	}
+	#endif
+	str->assign( start, end - start );
+}
+
+
 const char* TiXmlBase::ReadName( const char* p, TIXML_STRING * name, TiXmlEncoding encoding )
 {
 	// Oddly, not supported on some comilers,
@@ -426,9 +668,18 @@ const char* TiXmlBase::ReadName( const char* p, TIXML_STRING * name, TiXmlEncodi
 		{
 			//(*name) += *p; // expensive
 			++p;
+			p = ScanName( p );
 		}
 		if ( p-start > 0 ) {
-			name->assign( start, p-start );
+			#ifndef TIXML_USE_STL
+			// Names repeat a lot, a document shares them in its pool. An
+			// in-situ parse does not copy them at all.
+			TiXmlStringPool* pool = TiXmlStringPool::Current();
+			if ( pool && !TiXmlInSitu::Current() )
+				pool->Intern( start, p-start, name );
+			else
+			#endif
+			AssignSource( name, start, p );
 		}
 		return p;
 	}
@@ -571,6 +822,77 @@ bool TiXmlBase::StringEqual( const char* p,
 	return false;
 }
 
+// Where ReadText puts the characters it reads: appended to the text or, in an
+// in-situ parse, decoded over the source, which the text then refers to.
+class TiXmlTextOutput
+{
+  public:
+	TiXmlTextOutput( TIXML_STRING* _text, TiXmlEncoding _encoding ) : text( _text )
+	{
+		#ifndef TIXML_USE_STL
+		inSitu = TiXmlInSitu::Current();
+		encoding = _encoding;
+		start = q = 0;
+		#else
+		(void) _encoding;
+		#endif
+	}
+
+	// The text starts at 'p'.
+	void Start( const char* p )
+	{
+		#ifndef TIXML_USE_STL
+		start = q = const_cast<char*>( p );
+		#else
+		(void) p;
+		#endif
+	}
+
+	// Put the 'len' characters at 'str', read from the source up to 'p'.
+	void Put( const char* str, int len, const char* p )
+	{
+		#ifndef TIXML_USE_STL
+		if ( inSitu )
+		{
+			if ( !len )
+				return;
+			// The decoded text is never longer than the source, so it is written
+			// behind the read position. Characters already in place are skipped.
+			if ( q + len != p || ( str != q && memcmp( q, str, len ) != 0 ) )
+			{
+				// Positions are counted on the source, so before it changes.
+				if ( inSitu->data )
+					inSitu->data->Stamp( p, encoding );
+				memmove( q, str, len );
+			}
+			q += len;
+			return;
+		}
+		#else
+		(void) p;
+		#endif
+		text->append( str, len );
+	}
+
+	void Finish()
+	{
+		#ifndef TIXML_USE_STL
+		if ( inSitu )
+			inSitu->View( start, q - start, text );
+		#endif
+	}
+
+  private:
+	TIXML_STRING* text;
+	#ifndef TIXML_USE_STL
+	TiXmlInSitu* inSitu;
+	TiXmlEncoding encoding;
+	char* start;
+	char* q;			// the write head
+	#endif
+};
+
+
 const char* TiXmlBase::ReadText(	const char* p, 
 									TIXML_STRING * text, 
 									bool trimWhiteSpace, 
@@ -579,18 +901,29 @@ const char* TiXmlBase::ReadText(	const char* p,
 									TiXmlEncoding encoding )
 {
     *text = "";
+	TiXmlTextOutput output( text, encoding );
 	if (    !trimWhiteSpace			// certain tags always keep whitespace
-		 || !condenseWhiteSpace )	// if true, whitespace is always kept
+		 || !IsWhiteSpaceCondensed() )	// if true, whitespace is always kept
 	{
 		// Keep all the white space.
+		output.Start( p );
 		while (	   p && *p
 				&& !StringEqual( p, endTag, caseInsensitive, encoding )
 			  )
 		{
+			// Plain text, which cannot contain the end tag, is copied at once.
+			const char* plain = caseInsensitive ? p : ScanText( p, *endTag, 0 );
+			if ( plain != p )
+			{
+				output.Put( p, (int)( plain - p ), plain );
+				p = plain;
+				continue;
+			}
+
 			int len;
 			char cArr[4] = { 0, 0, 0, 0 };
 			p = GetChar( p, cArr, &len, encoding );
-			text->append( cArr, len );
+			output.Put( cArr, len, p );
 		}
 	}
 	else
@@ -599,6 +932,7 @@ const char* TiXmlBase::ReadText(	const char* p,
 
 		// Remove leading white space:
 		p = SkipWhiteSpace( p, encoding );
+		output.Start( p );
 		while (	   p && *p
 				&& !StringEqual( p, endTag, caseInsensitive, encoding ) )
 		{
@@ -618,19 +952,25 @@ const char* TiXmlBase::ReadText(	const char* p,
 				// new character. Any whitespace just becomes a space.
 				if ( whitespace )
 				{
-					(*text) += ' ';
+					output.Put( " ", 1, p );
 					whitespace = false;
 				}
+				// Plain text without white space is copied at once.
+				const char* plain = caseInsensitive ? p : ScanText( p, *endTag, ' ' );
+				if ( plain != p )
+				{
+					output.Put( p, (int)( plain - p ), plain );
+					p = plain;
+					continue;
+				}
 				int len;
 				char cArr[4] = { 0, 0, 0, 0 };
 				p = GetChar( p, cArr, &len, encoding );
-				if ( len == 1 )
-					(*text) += cArr[0];	// more efficient
-				else
-					text->append( cArr, len );
+				output.Put( cArr, len, p );
 			}
 		}
 	}
+	output.Finish();
 	if ( p && *p )
 		p += strlen( endTag );
 	return ( p && *p ) ? p : 0;
@@ -656,15 +996,10 @@ void TiXmlDocument::StreamIn( std::istream * in, TIXML_STRING * tag )
 	while ( in->good() )
 	{
 		int tagIndex = (int) tag->length();
-		while ( in->good() && in->peek() != '>' )
+		if ( !StreamTo( in, '>', tag ) )
 		{
-			int c = in->get();
-			if ( c <= 0 )
-			{
-				SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
-				break;
-			}
-			(*tag) += (char) c;
+			in->get();
+			SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
 		}
 
 		if ( in->good() )
@@ -702,9 +1037,55 @@ void TiXmlDocument::StreamIn( std::istream * in, TIXML_STRING * tag )
 #endif
 
 const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiXmlEncoding encoding )
+{
+	#ifndef TIXML_USE_STL
+	// Parse a copy in place, and map the end of the parse back to the input.
+	if ( useInSitu && p && *p )
+	{
+		size_t length = strlen( p );
+		char* source = NewSource( length );
+		memcpy( source, p, length );
+		const char* end = ParseSource( source, prevData, encoding );
+		return end ? p + ( end - source ) : 0;
+	}
+	#endif
+	return ParseSource( p, prevData, encoding );
+}
+
+
+#ifndef TIXML_USE_STL
+char* TiXmlDocument::NewSource( size_t length )
+{
+	// Like the arena, the sources of an empty document can be reused.
+	if ( inSitu && !firstChild )
+		inSitu->Clear();
+	if ( !inSitu )
+		inSitu = new TiXmlInSitu();
+	return inSitu->NewSource( length );
+}
+#endif
+
+
+const char* TiXmlDocument::ParseSource( const char* p, TiXmlParsingData* prevData, TiXmlEncoding encoding )
 {
 	ClearError();
 
+	// Nothing lives in the arena of an empty document anymore, so it can be reused.
+	// The same goes for its pooled names.
+	if ( arena && !firstChild )
+		arena->Reset();
+	if ( useArena && !arena )
+		arena = new TiXmlArena();
+	TiXmlArenaScope arenaScope( useArena ? arena : 0 );
+
+	#ifndef TIXML_USE_STL
+	if ( names && !firstChild )
+		names->Clear();
+	if ( !names )
+		names = new TiXmlStringPool();
+	TiXmlStringPoolScope poolScope( names );
+	#endif
+
 	// Parse away, at the document level. Since a document
 	// contains nothing but other tags, most of what happens
 	// here is skipping white space.
@@ -728,8 +1109,17 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
 		location.row = 0;
 		location.col = 0;
 	}
-	TiXmlParsingData data( p, TabSize(), location.row, location.col );
+	const TiXmlParseOptions* parseOptions = ParseOptions();
+	TiXmlParsingData data( p, TabSize(), location.row, location.col,
+						   !parseOptions || parseOptions->locateNodes, parseOptions && parseOptions->indexNames );
 	location = data.Cursor();
+	indexNames = data.IndexNames();
+	TiXmlParseOptionsScope optionsScope( parseOptions );
+
+	#ifndef TIXML_USE_STL
+	// The views into the source are terminated when the scope ends.
+	TiXmlInSituScope inSituScope( useInSitu ? inSitu : 0, &data );
+	#endif
 
 	if ( encoding == TIXML_ENCODING_UNKNOWN )
 	{
@@ -801,6 +1191,9 @@ void TiXmlDocument::SetError( int err, const char* pError, TiXmlParsingData* dat
 	if ( error )
 		return;
 
+	// The error belongs to the document, not to the parsed nodes.
+	TiXmlArenaScope arenaScope( 0 );
+
 	assert( err > 0 && err < TIXML_ERROR_STRING_COUNT );
 	error   = true;
 	errorId = err;
@@ -904,20 +1297,12 @@ void TiXmlElement::StreamIn (std::istream * in, TIXML_STRING * tag)
 {
 	// We're called with some amount of pre-parsing. That is, some of "this"
 	// element is in "tag". Go ahead and stream to the closing ">"
-	while( in->good() )
+	if ( in->good() && !StreamPast( in, '>', tag ) )
 	{
-		int c = in->get();
-		if ( c <= 0 )
-		{
-			TiXmlDocument* document = GetDocument();
-			if ( document )
-				document->SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
-			return;
-		}
-		(*tag) += (char) c ;
-		
-		if ( c == '>' )
-			break;
+		TiXmlDocument* document = GetDocument();
+		if ( document )
+			document->SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return;
 	}
 
 	if ( tag->length() < 3 ) return;
@@ -949,6 +1334,11 @@ void TiXmlElement::StreamIn (std::istream * in, TIXML_STRING * tag)
 				TiXmlText text( "" );
 				text.StreamIn( in, tag );
 
+				// Stopped by a null: the text node has no document to
+				// report it to, and would read nothing more.
+				if ( in->good() && in->peek() != '<' )
+					return;
+
 				// What follows text is a closing tag or another node.
 				// Go around again and figure it out.
 				continue;
@@ -960,47 +1350,20 @@ void TiXmlElement::StreamIn (std::istream * in, TIXML_STRING * tag)
 			assert( in->peek() == '<' );
 			int tagIndex = (int) tag->length();
 
-			bool closingTag = false;
-			bool firstCharFound = false;
-
-			for( ;; )
+			// Read up to the '>'. Text in a CDATA section may contain a '>',
+			// but the text node reads on to the "]]>" anyway.
+			if ( !StreamTo( in, '>', tag ) )
 			{
-				if ( !in->good() )
-					return;
-
-				int c = in->peek();
-				if ( c <= 0 )
-				{
-					TiXmlDocument* document = GetDocument();
-					if ( document )
-						document->SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
-					return;
-				}
-				
-				if ( c == '>' )
-					break;
-
-				*tag += (char) c;
-				in->get();
-
-				// Early out if we find the CDATA id.
-				if ( c == '[' && tag->size() >= 9 )
-				{
-					size_t len = tag->size();
-					const char* start = tag->c_str() + len - 9;
-					if ( strcmp( start, "<![CDATA[" ) == 0 ) {
-						assert( !closingTag );
-						break;
-					}
-				}
-
-				if ( !firstCharFound && c != '<' && !IsWhiteSpace( c ) )
-				{
-					firstCharFound = true;
-					if ( c == '/' )
-						closingTag = true;
-				}
+				TiXmlDocument* document = GetDocument();
+				if ( document )
+					document->SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
+				return;
 			}
+
+			const char* firstChar = tag->c_str() + tagIndex;
+			while ( *firstChar == '<' || IsWhiteSpace( *firstChar ) )
+				++firstChar;
+			bool closingTag = ( *firstChar == '/' );
 			// If it was a closing tag, then read in the closing '>' to clean up the input stream.
 			// If it was not, the streaming will be done by the tag.
 			if ( closingTag )
@@ -1051,7 +1414,7 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 		return 0;
 	}
 
-	if ( data )
+	if ( data && data->LocateNodes() )
 	{
 		data->Stamp( p, encoding );
 		location = data->Cursor();
@@ -1063,6 +1426,9 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 		return 0;
 	}
 
+	if ( data && data->IndexNames() )
+		indexNames = true;
+
 	p = SkipWhiteSpace( p+1, encoding );
 
 	// Read the name.
@@ -1098,6 +1464,7 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 				if ( document ) document->SetError( TIXML_ERROR_PARSING_EMPTY, p, data, encoding );		
 				return 0;
 			}
+			attributeSet.SetIndexNames( indexNames );
 			return (p+1);
 		}
 		else if ( *p == '>' )
@@ -1105,6 +1472,9 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 			// Done with attributes (if there were any.)
 			// Read the value -- which can include other
 			// elements -- read the end tag, and return.
+			// The attributes are indexed from now on, the
+			// duplicate check of each new one would drop it.
+			attributeSet.SetIndexNames( indexNames );
 			++p;
 			p = ReadValue( p, data, encoding );		// Note this is an Element method, and will set the error if one happens.
 			if ( !p || !*p ) {
@@ -1147,7 +1517,22 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 
 			attrib->SetDocument( document );
 			pErr = p;
-			p = attrib->Parse( p, data, encoding );
+			#ifndef TIXML_USE_STL
+			if ( data && TiXmlInSitu::Current() )
+			{
+				// In place, decoding the value stamps positions inside it. The errors
+				// of the attribute are reported at its start, from a stamp taken there.
+				data->Stamp( pErr, encoding );
+				const TiXmlParsingData atAttribute( *data );
+				p = attrib->Parse( p, data, encoding );
+				if ( !p || !*p || attributeSet.Find( attrib->NameTStr() ) )
+					*data = atAttribute;
+			}
+			else
+			#endif
+			{
+				p = attrib->Parse( p, data, encoding );
+			}
 
 			if ( !p || !*p )
 			{
@@ -1157,11 +1542,7 @@ const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 			}
 
 			// Handle the strange case of double attributes:
-			#ifdef TIXML_USE_STL
 			TiXmlAttribute* node = attributeSet.Find( attrib->NameTStr() );
-			#else
-			TiXmlAttribute* node = attributeSet.Find( attrib->Name() );
-			#endif
 			if ( node )
 			{
 				if ( document ) document->SetError( TIXML_ERROR_PARSING_ELEMENT, pErr, data, encoding );
@@ -1250,23 +1631,11 @@ const char* TiXmlElement::ReadValue( const char* p, TiXmlParsingData* data, TiXm
 #ifdef TIXML_USE_STL
 void TiXmlUnknown::StreamIn( std::istream * in, TIXML_STRING * tag )
 {
-	while ( in->good() )
+	if ( in->good() && !StreamPast( in, '>', tag ) )
 	{
-		int c = in->get();	
-		if ( c <= 0 )
-		{
-			TiXmlDocument* document = GetDocument();
-			if ( document )
-				document->SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
-			return;
-		}
-		(*tag) += (char) c;
-
-		if ( c == '>' )
-		{
-			// All is well.
-			return;		
-		}
+		TiXmlDocument* document = GetDocument();
+		if ( document )
+			document->SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
 	}
 }
 #endif
@@ -1277,7 +1646,7 @@ const char* TiXmlUnknown::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 	TiXmlDocument* document = GetDocument();
 	p = SkipWhiteSpace( p, encoding );
 
-	if ( data )
+	if ( data && data->LocateNodes() )
 	{
 		data->Stamp( p, encoding );
 		location = data->Cursor();
@@ -1290,11 +1659,10 @@ const char* TiXmlUnknown::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 	++p;
     value = "";
 
+	const char* start = p;
 	while ( p && *p && *p != '>' )
-	{
-		value += *p;
 		++p;
-	}
+	AssignSource( &value, start, p );
 
 	if ( !p )
 	{
@@ -1311,8 +1679,7 @@ void TiXmlComment::StreamIn( std::istream * in, TIXML_STRING * tag )
 {
 	while ( in->good() )
 	{
-		int c = in->get();	
-		if ( c <= 0 )
+		if ( !StreamPast( in, '>', tag ) )
 		{
 			TiXmlDocument* document = GetDocument();
 			if ( document )
@@ -1320,10 +1687,7 @@ void TiXmlComment::StreamIn( std::istream * in, TIXML_STRING * tag )
 			return;
 		}
 
-		(*tag) += (char) c;
-
-		if ( c == '>' 
-			 && tag->at( tag->length() - 2 ) == '-'
+		if (    tag->at( tag->length() - 2 ) == '-'
 			 && tag->at( tag->length() - 3 ) == '-' )
 		{
 			// All is well.
@@ -1341,7 +1705,7 @@ const char* TiXmlComment::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 
 	p = SkipWhiteSpace( p, encoding );
 
-	if ( data )
+	if ( data && data->LocateNodes() )
 	{
 		data->Stamp( p, encoding );
 		location = data->Cursor();
@@ -1377,11 +1741,14 @@ const char* TiXmlComment::Parse( const char* p, TiXmlParsingData* data, TiXmlEnc
 
     value = "";
 	// Keep all the white space.
+	const char* start = p;
 	while (	p && *p && !StringEqual( p, endTag, false, encoding ) )
 	{
-		value.append( p, 1 );
-		++p;
+		// Entities are not parsed in comments, but ScanText stops at them.
+		const char* plain = ScanText( p, *endTag, 0 );
+		p = ( plain == p ) ? p + 1 : plain;
 	}
+	AssignSource( &value, start, p );
 	if ( p && *p ) 
 		p += strlen( endTag );
 
@@ -1394,7 +1761,7 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
 	p = SkipWhiteSpace( p, encoding );
 	if ( !p || !*p ) return 0;
 
-	if ( data )
+	if ( data && data->LocateNodes() )
 	{
 		data->Stamp( p, encoding );
 		location = data->Cursor();
@@ -1444,6 +1811,7 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
 		// But this is such a common error that the parser will try
 		// its best, even without them.
 		value = "";
+		const char* start = p;
 		while (    p && *p											// existence
 				&& !IsWhiteSpace( *p )								// whitespace
 				&& *p != '/' && *p != '>' )							// tag end
@@ -1455,9 +1823,9 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
 				if ( document ) document->SetError( TIXML_ERROR_READING_ATTRIBUTES, p, data, encoding );
 				return 0;
 			}
-			value += *p;
 			++p;
 		}
+		AssignSource( &value, start, p );
 	}
 	return p;
 }
@@ -1467,12 +1835,8 @@ void TiXmlText::StreamIn( std::istream * in, TIXML_STRING * tag )
 {
 	while ( in->good() )
 	{
-		int c = in->peek();	
-		if ( !cdata && (c == '<' ) ) 
-		{
-			return;
-		}
-		if ( c <= 0 )
+		// Text runs up to the next tag, CDATA up to the "]]>".
+		if ( !StreamTo( in, cdata ? '>' : '<', tag ) )
 		{
 			TiXmlDocument* document = GetDocument();
 			if ( document )
@@ -1480,10 +1844,11 @@ void TiXmlText::StreamIn( std::istream * in, TIXML_STRING * tag )
 			return;
 		}
 
-		(*tag) += (char) c;
-		in->get();	// "commits" the peek made above
+		if ( !cdata )
+			return;
 
-		if ( cdata && c == '>' && tag->size() >= 3 ) {
+		*tag += (char) in->get();
+		if ( tag->size() >= 3 ) {
 			size_t len = tag->size();
 			if ( (*tag)[len-2] == ']' && (*tag)[len-3] == ']' ) {
 				// terminator of cdata.
@@ -1499,7 +1864,7 @@ const char* TiXmlText::Parse( const char* p, TiXmlParsingData* data, TiXmlEncodi
 	value = "";
 	TiXmlDocument* document = GetDocument();
 
-	if ( data )
+	if ( data && data->LocateNodes() )
 	{
 		data->Stamp( p, encoding );
 		location = data->Cursor();
@@ -1521,13 +1886,14 @@ const char* TiXmlText::Parse( const char* p, TiXmlParsingData* data, TiXmlEncodi
 		p += strlen( startTag );
 
 		// Keep all the white space, ignore the encoding, etc.
+		const char* start = p;
 		while (	   p && *p
 				&& !StringEqual( p, endTag, false, encoding )
 			  )
 		{
-			value += *p;
 			++p;
 		}
+		AssignSource( &value, start, p );
 
 		TIXML_STRING dummy; 
 		p = ReadText( p, &dummy, false, endTag, false, encoding );
@@ -1548,23 +1914,11 @@ const char* TiXmlText::Parse( const char* p, TiXmlParsingData* data, TiXmlEncodi
 #ifdef TIXML_USE_STL
 void TiXmlDeclaration::StreamIn( std::istream * in, TIXML_STRING * tag )
 {
-	while ( in->good() )
+	if ( in->good() && !StreamPast( in, '>', tag ) )
 	{
-		int c = in->get();
-		if ( c <= 0 )
-		{
-			TiXmlDocument* document = GetDocument();
-			if ( document )
-				document->SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
-			return;
-		}
-		(*tag) += (char) c;
-
-		if ( c == '>' )
-		{
-			// All is well.
-			return;
-		}
+		TiXmlDocument* document = GetDocument();
+		if ( document )
+			document->SetError( TIXML_ERROR_EMBEDDED_NULL, 0, 0, TIXML_ENCODING_UNKNOWN );
 	}
 }
 #endif
@@ -1580,7 +1934,7 @@ const char* TiXmlDeclaration::Parse( const char* p, TiXmlParsingData* data, TiXm
 		if ( document ) document->SetError( TIXML_ERROR_PARSING_DECLARATION, 0, 0, _encoding );
 		return 0;
 	}
-	if ( data )
+	if ( data && data->LocateNodes() )
 	{
 		data->Stamp( p, _encoding );
 		location = data->Cursor();
@@ -1604,19 +1958,19 @@ const char* TiXmlDeclaration::Parse( const char* p, TiXmlParsingData* data, TiXm
 		{
 			TiXmlAttribute attrib;
 			p = attrib.Parse( p, data, _encoding );		
-			version = attrib.Value();
+			version = attrib.ValueTStr();
 		}
 		else if ( StringEqual( p, "encoding", true, _encoding ) )
 		{
 			TiXmlAttribute attrib;
 			p = attrib.Parse( p, data, _encoding );		
-			encoding = attrib.Value();
+			encoding = attrib.ValueTStr();
 		}
 		else if ( StringEqual( p, "standalone", true, _encoding ) )
 		{
 			TiXmlAttribute attrib;
 			p = attrib.Parse( p, data, _encoding );		
-			standalone = attrib.Value();
+			standalone = attrib.ValueTStr();
 		}
 		else
 		{
@@ -1636,3 +1990,501 @@ bool TiXmlText::Blank() const
 	return true;
 }
 
+
+FILE* TiXmlFOpen( const char* filename, const char* mode );
+
+TiXmlSaxReader::TiXmlSaxReader( TiXmlSaxHandler* _handler )
+	: handler( _handler ), openElements( 0 ), depth( 0 ), capacity( 0 ), tabsize( 4 ), ownOptions( false )
+{
+	assert( handler );
+	Reset();
+}
+
+
+TiXmlSaxReader::~TiXmlSaxReader()
+{
+	delete [] openElements;
+}
+
+
+void TiXmlSaxReader::Reset()
+{
+	depth = 0;
+	started = false;
+	done = false;
+	stopped = false;
+	error = false;
+	errorId = 0;
+	errorDesc = "";
+	errorLocation.Clear();
+}
+
+
+bool TiXmlSaxReader::Parse( const char* p, TiXmlEncoding encoding )
+{
+	Reset();
+	if ( !p || !*p )
+	{
+		SetError( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return false;
+	}
+
+	TiXmlParsingData data( p, tabsize, 0, 0 );
+	TiXmlParseOptionsScope optionsScope( ParseOptions() );
+
+	// Check for the Microsoft UTF-8 lead bytes, as the document does.
+	const unsigned char* pU = (const unsigned char*)p;
+	if (	encoding == TIXML_ENCODING_UNKNOWN
+		 && *(pU+0) == TIXML_UTF_LEAD_0
+		 && *(pU+1) == TIXML_UTF_LEAD_1
+		 && *(pU+2) == TIXML_UTF_LEAD_2 )
+	{
+		encoding = TIXML_ENCODING_UTF8;
+	}
+
+	ParseItems( p, true, &data, &encoding );
+	return !error;
+}
+
+
+bool TiXmlSaxReader::LoadFile( const char* filename, TiXmlEncoding encoding )
+{
+	FILE* file = TiXmlFOpen( filename, "rb" );
+	if ( !file )
+	{
+		Reset();
+		SetError( TiXmlBase::TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return false;
+	}
+	bool result = LoadFile( file, encoding );
+	fclose( file );
+	return result;
+}
+
+
+bool TiXmlSaxReader::LoadFile( FILE* file, TiXmlEncoding encoding )
+{
+	Reset();
+	if ( !file )
+	{
+		SetError( TiXmlBase::TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return false;
+	}
+
+	const char CR = 0x0d;
+	const char LF = 0x0a;
+
+	// The buffer holds the unparsed rest of the last chunk plus the next chunk.
+	size_t size = 64 * 1024;
+	size_t length = 0;
+	char* buf = new char[ size+1 ];
+	buf[0] = 0;
+
+	TiXmlParsingData data( buf, tabsize, 0, 0 );
+	TiXmlParseOptionsScope optionsScope( ParseOptions() );
+	bool eof = false;
+	bool skipLF = false;
+	bool first = true;
+
+	while ( !error && !stopped && !done )
+	{
+		if ( length == size )
+		{
+			// A single item does not fit, make room for it.
+			char* bigger = new char[ size*2+1 ];
+			memcpy( bigger, buf, length+1 );
+			data.stamp = bigger + ( data.stamp - buf );
+			delete [] buf;
+			buf = bigger;
+			size *= 2;
+		}
+
+		size_t read = fread( buf+length, 1, size-length, file );
+		if ( read < size-length )
+		{
+			if ( ferror( file ) )
+			{
+				SetError( TiXmlBase::TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+				break;
+			}
+			eof = true;
+		}
+
+		// Normalize new lines in place, as TiXmlDocument::LoadFile() does. A CR at the end
+		// of a chunk may be followed by the LF at the start of the next one.
+		const char* r = buf + length;
+		const char* end = r + read;
+		char* q = buf + length;
+		if ( skipLF && r < end && *r == LF )
+			++r;
+		skipLF = false;
+		while ( r < end )
+		{
+			if ( *r == CR )
+			{
+				*q++ = LF;
+				++r;
+				if ( r == end )
+					skipLF = true;
+				else if ( *r == LF )
+					++r;
+			}
+			else if ( *r == 0 )
+			{
+				// Like the document, stop at an embedded null.
+				eof = true;
+				break;
+			}
+			else
+			{
+				*q++ = *r++;
+			}
+		}
+		length = q - buf;
+		buf[length] = 0;
+
+		if ( first )
+		{
+			first = false;
+			if ( length == 0 )
+			{
+				SetError( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, TIXML_ENCODING_UNKNOWN );
+				break;
+			}
+			const unsigned char* pU = (const unsigned char*)buf;
+			if (	encoding == TIXML_ENCODING_UNKNOWN
+				 && *(pU+0) == TIXML_UTF_LEAD_0
+				 && *(pU+1) == TIXML_UTF_LEAD_1
+				 && *(pU+2) == TIXML_UTF_LEAD_2 )
+			{
+				encoding = TIXML_ENCODING_UTF8;
+			}
+		}
+
+		const char* p = ParseItems( buf, eof, &data, &encoding );
+		if ( eof || !p )
+			break;
+
+		// Drop the parsed part, keeping the error location in step.
+		data.Stamp( p, encoding );
+		data.stamp = buf;
+		length -= p - buf;
+		memmove( buf, p, length+1 );
+	}
+
+	delete [] buf;
+	return !error;
+}
+
+
+const char* TiXmlSaxReader::ParseItems( const char* p, bool last, TiXmlParsingData* data, TiXmlEncoding* encoding )
+{
+	while ( p && *p )
+	{
+		const char* start = TiXmlBase::SkipWhiteSpace( p, *encoding );
+		if ( !start || !*start )
+		{
+			// Only white space left, which may still belong to a text run.
+			if ( !last )
+				return p;
+			p = start ? start : p + strlen( p );
+			break;
+		}
+
+		if ( *start != '<' && depth == 0 )
+		{
+			// Text outside of the root element ends the document, as in TiXmlDocument::Parse()
+			done = true;
+			return 0;
+		}
+
+		// Text and CDATA sections which end the buffer cannot be read yet: their
+		// parse fails if nothing follows.
+		const char* end = last ? 0 : FindItemEnd( start, *encoding );
+		if ( !last && ( !end || !*end ) )
+			return p;
+
+		started = true;
+		if ( *start != '<' )
+		{
+			TiXmlText text( "" );
+			p = text.Parse( TiXmlBase::IsWhiteSpaceCondensed() ? start : p, 0, *encoding );
+			if ( !p )
+			{
+				SetError( TiXmlBase::TIXML_ERROR_READING_ELEMENT_VALUE, 0, 0, *encoding );
+				return 0;
+			}
+
+			const char* value = text.Value();
+			while ( *value && TiXmlBase::IsWhiteSpace( *value ) )
+				++value;
+			if ( *value && !handler->Text( text.Value(), false ) )
+			{
+				stopped = true;
+				return 0;
+			}
+		}
+		else if ( depth > 0 && TiXmlBase::StringEqual( start, "</", false, *encoding ) )
+		{
+			p = ParseEndTag( start, data, *encoding );
+		}
+		else if ( TiXmlBase::StringEqual( start, "<?xml", true, *encoding ) )
+		{
+			TiXmlDeclaration declaration;
+			p = declaration.Parse( start, 0, *encoding );
+			if ( !p )
+			{
+				SetError( TiXmlBase::TIXML_ERROR_PARSING_DECLARATION, start, data, *encoding );
+				return 0;
+			}
+
+			// Did we get encoding info?
+			if ( *encoding == TIXML_ENCODING_UNKNOWN )
+			{
+				const char* enc = declaration.Encoding();
+				if (	*enc == 0
+					 || TiXmlBase::StringEqual( enc, "UTF-8", true, TIXML_ENCODING_UNKNOWN )
+					 || TiXmlBase::StringEqual( enc, "UTF8", true, TIXML_ENCODING_UNKNOWN ) )
+					*encoding = TIXML_ENCODING_UTF8;
+				else
+					*encoding = TIXML_ENCODING_LEGACY;
+			}
+		}
+		else if ( TiXmlBase::StringEqual( start, "<!--", false, *encoding ) )
+		{
+			TiXmlComment comment;
+			p = comment.Parse( start, 0, *encoding );
+		}
+		else if ( TiXmlBase::StringEqual( start, "<![CDATA[", false, *encoding ) )
+		{
+			TiXmlText text( "" );
+			text.SetCDATA( true );
+			p = text.Parse( start, 0, *encoding );
+			if ( !p )
+			{
+				SetError( TiXmlBase::TIXML_ERROR_PARSING_CDATA, start, data, *encoding );
+				return 0;
+			}
+			if ( !handler->Text( text.Value(), true ) )
+			{
+				stopped = true;
+				return 0;
+			}
+		}
+		else if (	!TiXmlBase::StringEqual( start, "<!", false, *encoding )
+				 && ( TiXmlBase::IsAlpha( *(start+1), *encoding ) || *(start+1) == '_' ) )
+		{
+			p = ParseElement( start, data, *encoding );
+		}
+		else
+		{
+			TiXmlUnknown unknown;
+			p = unknown.Parse( start, 0, *encoding );
+		}
+	}
+
+	if ( !p || error || stopped )
+		return 0;
+
+	if ( last )
+	{
+		if ( depth > 0 )
+			SetError( TiXmlBase::TIXML_ERROR_READING_ELEMENT_VALUE, 0, 0, *encoding );
+		else if ( !started )
+			SetError( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, *encoding );
+		return 0;
+	}
+	return p;
+}
+
+
+const char* TiXmlSaxReader::ParseElement( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
+{
+	if ( depth == capacity )
+	{
+		int newCapacity = capacity ? capacity*2 : 16;
+		TIXML_STRING* names = new TIXML_STRING[ newCapacity ];
+		for( int i=0; i<depth; ++i )
+			names[i].swap( openElements[i] );
+		delete [] openElements;
+		openElements = names;
+		capacity = newCapacity;
+	}
+
+	p = TiXmlBase::SkipWhiteSpace( p+1, encoding );
+
+	// Read the name.
+	const char* pErr = p;
+	TIXML_STRING& name = openElements[depth];
+	p = TiXmlBase::ReadName( p, &name, encoding );
+	if ( !p || !*p )
+	{
+		SetError( TiXmlBase::TIXML_ERROR_FAILED_TO_READ_ELEMENT_NAME, pErr, data, encoding );
+		return 0;
+	}
+	++depth;
+
+	if ( !handler->StartElement( name.c_str() ) )
+	{
+		stopped = true;
+		return 0;
+	}
+
+	// Report the attributes up to the end of the start tag.
+	TiXmlAttribute attrib;
+	while ( p && *p )
+	{
+		pErr = p;
+		p = TiXmlBase::SkipWhiteSpace( p, encoding );
+		if ( !p || !*p )
+		{
+			SetError( TiXmlBase::TIXML_ERROR_READING_ATTRIBUTES, pErr, data, encoding );
+			return 0;
+		}
+		if ( *p == '/' )
+		{
+			++p;
+			// Empty tag.
+			if ( *p != '>' )
+			{
+				SetError( TiXmlBase::TIXML_ERROR_PARSING_EMPTY, p, data, encoding );
+				return 0;
+			}
+			--depth;
+			if ( !handler->EndElement( name.c_str() ) )
+			{
+				stopped = true;
+				return 0;
+			}
+			return p+1;
+		}
+		else if ( *p == '>' )
+		{
+			return p+1;
+		}
+		else
+		{
+			pErr = p;
+			p = attrib.Parse( p, 0, encoding );
+			if ( !p || !*p )
+			{
+				// Parse the attribute again, this time into a document, to get the exact error.
+				TiXmlDocument errorDocument;
+				TiXmlAttribute errorAttrib;
+				errorAttrib.SetDocument( &errorDocument );
+				errorAttrib.Parse( pErr, data, encoding );
+				if ( errorDocument.Error() )
+				{
+					SetError( errorDocument.ErrorId(), 0, 0, encoding );
+					errorLocation.row = errorDocument.ErrorRow() - 1;
+					errorLocation.col = errorDocument.ErrorCol() - 1;
+				}
+				SetError( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT, pErr, data, encoding );
+				return 0;
+			}
+			if ( !handler->Attribute( attrib.Name(), attrib.Value() ) )
+			{
+				stopped = true;
+				return 0;
+			}
+		}
+	}
+	return p;
+}
+
+
+const char* TiXmlSaxReader::ParseEndTag( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
+{
+	// note that:
+	// </foo > and
+	// </foo>
+	// are both valid end tags.
+	const TIXML_STRING& name = openElements[depth-1];
+	if ( !TiXmlBase::StringEqual( p+2, name.c_str(), false, encoding ) )
+	{
+		SetError( TiXmlBase::TIXML_ERROR_READING_END_TAG, p, data, encoding );
+		return 0;
+	}
+	p = TiXmlBase::SkipWhiteSpace( p + 2 + name.length(), encoding );
+	if ( !p || *p != '>' )
+	{
+		SetError( TiXmlBase::TIXML_ERROR_READING_END_TAG, p, data, encoding );
+		return 0;
+	}
+
+	--depth;
+	if ( !handler->EndElement( name.c_str() ) )
+	{
+		stopped = true;
+		return 0;
+	}
+	return p+1;
+}
+
+
+const char* TiXmlSaxReader::FindItemEnd( const char* p, TiXmlEncoding encoding )
+{
+	if ( *p != '<' )
+	{
+		// Text runs up to the next tag. Reading the text also reads its '<'.
+		const char* end = strchr( p, '<' );
+		return end ? end+1 : 0;
+	}
+
+	const char* end = 0;
+	if ( TiXmlBase::StringEqual( p, "<!--", false, encoding ) )
+	{
+		end = strstr( p+4, "-->" );
+		return end ? end+3 : 0;
+	}
+	if ( TiXmlBase::StringEqual( p, "<![CDATA[", false, encoding ) )
+	{
+		end = strstr( p+9, "]]>" );
+		return end ? end+3 : 0;
+	}
+	if ( *(p+1) == '!' || *(p+1) == '?' )
+	{
+		end = strchr( p, '>' );
+		return end ? end+1 : 0;
+	}
+
+	// Start or end tag: the first '>' which is not part of a quoted attribute value.
+	char quote = 0;
+	for ( ++p; *p; ++p )
+	{
+		if ( quote )
+		{
+			if ( *p == quote )
+				quote = 0;
+		}
+		else if ( *p == '\'' || *p == '\"' )
+		{
+			quote = *p;
+		}
+		else if ( *p == '>' )
+		{
+			return p+1;
+		}
+	}
+	return 0;
+}
+
+
+void TiXmlSaxReader::SetError( int err, const char* pError, TiXmlParsingData* data, TiXmlEncoding encoding )
+{
+	// The first error in a chain is more accurate - don't set again!
+	if ( error )
+		return;
+
+	assert( err > 0 && err < TiXmlBase::TIXML_ERROR_STRING_COUNT );
+	error   = true;
+	errorId = err;
+	errorDesc = TiXmlBase::errorString[ errorId ];
+
+	errorLocation.Clear();
+	if ( pError && data )
+	{
+		data->Stamp( pError, encoding );
+		errorLocation = data->Cursor();
+	}
+}
@@ -0,0 +1,255 @@
+#include "ZoneBinary.h"
+#include "ZoneConfig.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace mouseevents
+{
+
+namespace
+{
+
+const std::string BinaryConfigExtension{".bin"};
+
+// Offset of the next table, keeps every table 8-byte aligned
+std::uint64_t Align(std::uint64_t Offset)
+{
+    return (Offset + 7) & ~std::uint64_t{7};
+}
+
+bool InRange(std::uint64_t Offset, std::uint64_t Count, std::uint64_t ElementSize, std::uint64_t FileSize)
+{
+    return Offset <= FileSize && Count <= (FileSize - Offset) / ElementSize;
+}
+
+SZoneBinaryPoint ToBinary(const CMouseEvents::PointType& Point)
+{
+    return {Point.x, Point.y};
+}
+
+CMouseEvents::PointType FromBinary(const SZoneBinaryPoint& Point)
+{
+    return {Point.s_X, Point.s_Y};
+}
+
+template<typename T>
+void Put(std::vector<char>& Buffer, std::uint64_t Offset, const T& Value)
+{
+    std::memcpy(Buffer.data() + Offset, &Value, sizeof(T));
+}
+
+}
+
+bool CZoneBinaryView::Open(const std::string& FileName)
+{
+    namespace bip = boost::interprocess;
+
+    m_Header = nullptr;
+    try
+    {
+        m_File = bip::file_mapping(FileName.c_str(), bip::read_only);
+        m_Region = bip::mapped_region(m_File, bip::read_only);
+    }
+    catch(const bip::interprocess_exception&)
+    {
+        return false;
+    }
+
+    const auto* Base = static_cast<const char*>(m_Region.get_address());
+    const std::uint64_t FileSize = m_Region.get_size();
+    if(FileSize < sizeof(SZoneBinaryHeader))
+    {
+        return false;
+    }
+
+    const auto* Header = reinterpret_cast<const SZoneBinaryHeader*>(Base);
+    if(std::memcmp(Header->s_Magic, ZoneBinaryMagic, sizeof(ZoneBinaryMagic)) != 0 || Header->s_Version != ZoneBinaryVersion)
+    {
+        return false;
+    }
+
+    // Every table starts after the header, aligned for its elements
+    for(auto Offset : {Header->s_IdTableOffset, Header->s_VertexOffset, Header->s_DirectionOffset, Header->s_AngleOffset})
+    {
+        if(Offset < sizeof(SZoneBinaryHeader) || Offset != Align(Offset))
+        {
+            return false;
+        }
+    }
+    if(!InRange(Header->s_IdTableOffset, Header->s_ZoneCount, sizeof(SZoneBinaryEntry), FileSize) ||
+       !InRange(Header->s_VertexOffset, Header->s_VertexCount, sizeof(SZoneBinaryPoint), FileSize) ||
+       !InRange(Header->s_DirectionOffset, Header->s_ZoneCount, sizeof(SZoneBinaryDirection), FileSize) ||
+       !InRange(Header->s_AngleOffset, Header->s_ZoneCount, sizeof(std::int32_t), FileSize) ||
+       !InRange(Header->s_StringPoolOffset, Header->s_StringPoolSize, 1, FileSize))
+    {
+        return false;
+    }
+
+    // Find relies on the order of the ids, Zone on whole lines and names on their null terminator
+    const auto* Entries = reinterpret_cast<const SZoneBinaryEntry*>(Base + Header->s_IdTableOffset);
+    const auto* StringPool = Base + Header->s_StringPoolOffset;
+    for(std::uint32_t i = 0; i < Header->s_ZoneCount; ++i)
+    {
+        const auto& Entry = Entries[i];
+        if((i > 0 && Entries[i-1].s_ZoneId >= Entry.s_ZoneId) ||
+           Entry.s_FirstVertex % 2 != 0 || Entry.s_VertexCount % 2 != 0 ||
+           Entry.s_FirstVertex > Header->s_VertexCount || Entry.s_VertexCount > Header->s_VertexCount - Entry.s_FirstVertex ||
+           Entry.s_NameOffset >= Header->s_StringPoolSize || Entry.s_NameLength >= Header->s_StringPoolSize - Entry.s_NameOffset ||
+           StringPool[Entry.s_NameOffset + Entry.s_NameLength] != '\0')
+        {
+            return false;
+        }
+    }
+
+    m_Entries = Entries;
+    m_Vertices = reinterpret_cast<const SZoneBinaryPoint*>(Base + Header->s_VertexOffset);
+    m_Directions = reinterpret_cast<const SZoneBinaryDirection*>(Base + Header->s_DirectionOffset);
+    m_Angles = reinterpret_cast<const std::int32_t*>(Base + Header->s_AngleOffset);
+    m_StringPool = StringPool;
+    m_Header = Header;
+    return true;
+}
+
+std::string_view CZoneBinaryView::ZoneName(std::size_t Index) const
+{
+    return {m_StringPool + m_Entries[Index].s_NameOffset, m_Entries[Index].s_NameLength};
+}
+
+CMouseEvents::PointType CZoneBinaryView::Center(std::size_t Index) const
+{
+    return FromBinary(m_Directions[Index].s_Center);
+}
+
+CMouseEvents::PointType CZoneBinaryView::ArrowHead(std::size_t Index) const
+{
+    return FromBinary(m_Directions[Index].s_ArrowHead);
+}
+
+std::optional<std::size_t> CZoneBinaryView::Find(int ZoneId) const
+{
+    auto End = m_Entries + Size();
+    auto It = std::lower_bound(m_Entries, End, ZoneId, [](const SZoneBinaryEntry& Entry, int Id) { return Entry.s_ZoneId < Id; });
+    if(It == End || It->s_ZoneId != ZoneId)
+    {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(It - m_Entries);
+}
+
+CMouseEvents::SZone CZoneBinaryView::Zone(std::size_t Index) const
+{
+    CMouseEvents::SZone Zone;
+    Zone.s_ZoneId = ZoneId(Index);
+    Zone.s_ZoneName = std::string(ZoneName(Index));
+    const auto* Points = Vertices(Index);
+    for(std::size_t i = 0; i + 1 < VertexCount(Index); i += 2)
+    {
+        Zone.s_Lines.emplace_back(FromBinary(Points[i]), FromBinary(Points[i+1]));
+    }
+    Zone.s_Center = Center(Index);
+    Zone.s_ArrowHead = ArrowHead(Index);
+    Zone.s_Angle = Angle(Index);
+    return Zone;
+}
+
+bool IsBinaryConfigPath(const std::string& FileName)
+{
+    return FileName.size() >= BinaryConfigExtension.size() &&
+           FileName.compare(FileName.size() - BinaryConfigExtension.size(), BinaryConfigExtension.size(), BinaryConfigExtension) == 0;
+}
+
+bool IsBinaryConfigFile(const std::string& FileName)
+{
+    std::ifstream Ifs(FileName, std::ifstream::binary);
+    char Magic[sizeof(ZoneBinaryMagic)]{};
+    return Ifs.read(Magic, sizeof(Magic)) && std::memcmp(Magic, ZoneBinaryMagic, sizeof(Magic)) == 0;
+}
+
+bool WriteConfigBinary(const std::string& FileName, const CMouseEvents::ZonesType& Zones)
+{
+    SZoneBinaryHeader Header{};
+    std::memcpy(Header.s_Magic, ZoneBinaryMagic, sizeof(ZoneBinaryMagic));
+    Header.s_Version = ZoneBinaryVersion;
+    for(const auto& [ZoneId, Zone] : Zones)
+    {
+        ++Header.s_ZoneCount;
+        Header.s_VertexCount += static_cast<std::uint32_t>(2*Zone.s_Lines.size());
+        Header.s_StringPoolSize += static_cast<std::uint32_t>(Zone.s_ZoneName.size() + 1);
+    }
+    Header.s_IdTableOffset = Align(sizeof(SZoneBinaryHeader));
+    Header.s_VertexOffset = Align(Header.s_IdTableOffset + Header.s_ZoneCount*sizeof(SZoneBinaryEntry));
+    Header.s_DirectionOffset = Align(Header.s_VertexOffset + Header.s_VertexCount*sizeof(SZoneBinaryPoint));
+    Header.s_AngleOffset = Align(Header.s_DirectionOffset + Header.s_ZoneCount*sizeof(SZoneBinaryDirection));
+    Header.s_StringPoolOffset = Align(Header.s_AngleOffset + Header.s_ZoneCount*sizeof(std::int32_t));
+
+    std::vector<char> Buffer(Header.s_StringPoolOffset + Header.s_StringPoolSize, 0);
+    Put(Buffer, 0, Header);
+
+    // Zones are iterated in id order, so the id table is sorted
+    std::uint32_t Index{0}, Vertex{0}, NameOffset{0};
+    for(const auto& [ZoneId, Zone] : Zones)
+    {
+        SZoneBinaryEntry Entry{ZoneId, Vertex, static_cast<std::uint32_t>(2*Zone.s_Lines.size()),
+                               NameOffset, static_cast<std::uint32_t>(Zone.s_ZoneName.size())};
+        Put(Buffer, Header.s_IdTableOffset + Index*sizeof(SZoneBinaryEntry), Entry);
+
+        for(const auto& Line : Zone.s_Lines)
+        {
+            Put(Buffer, Header.s_VertexOffset + Vertex++*sizeof(SZoneBinaryPoint), ToBinary(Line.first));
+            Put(Buffer, Header.s_VertexOffset + Vertex++*sizeof(SZoneBinaryPoint), ToBinary(Line.second));
+        }
+
+        SZoneBinaryDirection Direction{ToBinary(Zone.GetCenter()), ToBinary(Zone.GetArrowHead())};
+        Put(Buffer, Header.s_DirectionOffset + Index*sizeof(SZoneBinaryDirection), Direction);
+        Put(Buffer, Header.s_AngleOffset + Index*sizeof(std::int32_t), static_cast<std::int32_t>(Zone.s_Angle));
+
+        std::memcpy(Buffer.data() + Header.s_StringPoolOffset + NameOffset, Zone.s_ZoneName.c_str(), Zone.s_ZoneName.size() + 1);
+        NameOffset += Entry.s_NameLength + 1;
+        ++Index;
+    }
+
+    std::ofstream Ofs(FileName, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    Ofs.write(Buffer.data(), static_cast<std::streamsize>(Buffer.size()));
+    Ofs.close(); // the last write may only fail when the buffer is flushed
+    return static_cast<bool>(Ofs);
+}
+
+bool ReadConfigBinary(const std::string& FileName, std::map<int, CMouseEvents::SZone>& Zones)
+{
+    CZoneBinaryView View;
+    if(!View.Open(FileName))
+    {
+        return false;
+    }
+
+    for(std::size_t i = 0; i < View.Size(); ++i)
+    {
+        Zones[View.ZoneId(i)] = View.Zone(i);
+    }
+    return true;
+}
+
+bool ConvertXMLToBinary(const std::string& XMLFileName, const std::string& BinaryFileName)
+{
+    std::map<int, CMouseEvents::SZone> Zones;
+    return ReadConfigXML(XMLFileName, Zones) && WriteConfigBinary(BinaryFileName, CMouseEvents::ZonesType(Zones.cbegin(), Zones.cend()));
+}
+
+bool ConvertBinaryToXML(const std::string& BinaryFileName, const std::string& XMLFileName)
+{
+    std::map<int, CMouseEvents::SZone> Zones;
+    if(!ReadConfigBinary(BinaryFileName, Zones))
+    {
+        return false;
+    }
+
+    std::ofstream Ofs(XMLFileName, std::ofstream::out | std::ofstream::trunc);
+    WriteConfigXML(Ofs, CMouseEvents::ZonesType(Zones.cbegin(), Zones.cend()));
+    Ofs.close();
+    return static_cast<bool>(Ofs);
+}
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "MouseEvents.h"
+
+namespace mouseevents
+{
+
+// Versioned binary zone format which is memory-mapped and used in place, without parsing.
+// All values are stored in native byte order, all tables are 8-byte aligned:
+//
+//   SZoneBinaryHeader
+//   SZoneBinaryEntry[ZoneCount]          id table, sorted by zone id
+//   SZoneBinaryPoint[VertexCount]        flat vertex array, 2 vertices per line
+//   SZoneBinaryDirection[ZoneCount]      centers and arrow heads
+//   std::int32_t[ZoneCount]              angles
+//   char[StringPoolSize]                 zone names, each null terminated
+constexpr char ZoneBinaryMagic[4]{'M', 'E', 'Z', 'B'};
+constexpr std::uint32_t ZoneBinaryVersion{1};
+
+struct SZoneBinaryHeader
+{
+    char s_Magic[4];
+    std::uint32_t s_Version;
+    std::uint32_t s_ZoneCount;
+    std::uint32_t s_VertexCount;
+    std::uint32_t s_StringPoolSize;
+    std::uint32_t s_Reserved;
+    std::uint64_t s_IdTableOffset;
+    std::uint64_t s_VertexOffset;
+    std::uint64_t s_DirectionOffset;
+    std::uint64_t s_AngleOffset;
+    std::uint64_t s_StringPoolOffset;
+};
+
+struct SZoneBinaryEntry
+{
+    std::int32_t s_ZoneId;
+    std::uint32_t s_FirstVertex;
+    std::uint32_t s_VertexCount;
+    std::uint32_t s_NameOffset;
+    std::uint32_t s_NameLength;
+};
+
+struct SZoneBinaryPoint
+{
+    std::int32_t s_X;
+    std::int32_t s_Y;
+};
+
+struct SZoneBinaryDirection
+{
+    SZoneBinaryPoint s_Center;
+    SZoneBinaryPoint s_ArrowHead;
+};
+
+// Read-only view of a memory-mapped binary zone file
+class CZoneBinaryView
+{
+public:
+    // Map the file and validate its tables: their bounds and alignment, the order of the ids, and the vertex range
+    // and name of every zone. Returns false if the file is missing or not a valid zone file.
+    bool Open(const std::string& FileName);
+
+    std::size_t Size() const { return m_Header ? m_Header->s_ZoneCount : 0; }
+
+    int ZoneId(std::size_t Index) const { return m_Entries[Index].s_ZoneId; }
+    std::string_view ZoneName(std::size_t Index) const;
+    const SZoneBinaryPoint* Vertices(std::size_t Index) const { return m_Vertices + m_Entries[Index].s_FirstVertex; }
+    std::size_t VertexCount(std::size_t Index) const { return m_Entries[Index].s_VertexCount; }
+    CMouseEvents::PointType Center(std::size_t Index) const;
+    CMouseEvents::PointType ArrowHead(std::size_t Index) const;
+    int Angle(std::size_t Index) const { return m_Angles[Index]; }
+
+    // Index of a zone id (binary search in the id table)
+    std::optional<std::size_t> Find(int ZoneId) const;
+
+    // Copy a zone out of the mapping
+    CMouseEvents::SZone Zone(std::size_t Index) const;
+
+private:
+    boost::interprocess::file_mapping m_File;
+    boost::interprocess::mapped_region m_Region;
+    const SZoneBinaryHeader* m_Header{nullptr};
+    const SZoneBinaryEntry* m_Entries{nullptr};
+    const SZoneBinaryPoint* m_Vertices{nullptr};
+    const SZoneBinaryDirection* m_Directions{nullptr};
+    const std::int32_t* m_Angles{nullptr};
+    const char* m_StringPool{nullptr};
+};
+
+// Configuration files with this extension are stored in the binary format
+bool IsBinaryConfigPath(const std::string& FileName);
+
+// Check the magic bytes of a file
+bool IsBinaryConfigFile(const std::string& FileName);
+
+bool WriteConfigBinary(const std::string& FileName, const CMouseEvents::ZonesType& Zones);
+
+bool ReadConfigBinary(const std::string& FileName, std::map<int, CMouseEvents::SZone>& Zones);
+
+// Converters between the binary format and the XML written by WriteConfigXML
+bool ConvertXMLToBinary(const std::string& XMLFileName, const std::string& BinaryFileName);
+
+bool ConvertBinaryToXML(const std::string& BinaryFileName, const std::string& XMLFileName);
+
+}
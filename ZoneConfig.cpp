@@ -0,0 +1,319 @@
+#include "ZoneConfig.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "TinyXml/tinyxml.h"
+#include "ZoneBinary.h"
+
+namespace mouseevents
+{
+
+namespace
+{
+
+const std::string PreConfigElement{""};
+const std::string PostConfigElement{""};
+
+// Angle (in degrees, same convention as SZone::Rotate) of the arrow head around the center
+int GetAngle(const CMouseEvents::PointType& Center, const CMouseEvents::PointType& ArrowHead)
+{
+    auto Delta = ArrowHead - Center;
+    auto Angle = static_cast<int>(std::lround(-std::atan2(Delta.y, Delta.x)*180/CV_PI));
+    return Angle < 0 ? Angle + 360 : Angle;
+}
+
+// Attribute values are written between double quotes, the markup characters and control characters are
+// written as character references so that any name reads back unchanged
+std::string EscapeAttribute(const std::string& Value)
+{
+    std::string Escaped;
+    Escaped.reserve(Value.size());
+    for(char C : Value)
+    {
+        switch(C)
+        {
+        case '&': Escaped += "&amp;"; break;
+        case '<': Escaped += "&lt;"; break;
+        case '>': Escaped += "&gt;"; break;
+        case '"': Escaped += "&quot;"; break;
+        case '\'': Escaped += "&apos;"; break;
+        default:
+            if(static_cast<unsigned char>(C) < 32)
+            {
+                const char Hex[] = "0123456789ABCDEF";
+                Escaped += "&#x";
+                Escaped += Hex[(C >> 4) & 0xF];
+                Escaped += Hex[C & 0xF];
+                Escaped += ';';
+            }
+            else
+            {
+                Escaped += C;
+            }
+        }
+    }
+    return Escaped;
+}
+
+// Same conversion as TiXmlAttribute::QueryIntValue
+bool ReadInt(const char* Value, int& Int)
+{
+    return TiXmlBase::ToInt(Value, &Int) == TIXML_SUCCESS;
+}
+
+// Streams the zones out of a <Zones> document without building a DOM.
+// Expected layout (depth in brackets): [1] root, [2] Zone, [3] Shape/Direction, [4] Point
+class CZoneHandler : public TiXmlSaxHandler
+{
+public:
+    explicit CZoneHandler(std::map<int, CMouseEvents::SZone>& Zones)
+        : m_Zones{Zones}
+    {}
+
+    bool StartElement(const char* Name) override
+    {
+        ++m_Depth;
+        const std::string_view Element{Name};
+        if(m_Depth == 2)
+        {
+            m_InZone = Element == "Zone";
+            if(m_InZone)
+            {
+                m_Zone = CMouseEvents::SZone{};
+                m_HasZoneId = m_ShapeSeen = m_DirectionSeen = false;
+                m_Points.clear();
+                m_DirectionPoints.clear();
+            }
+        }
+        else if(m_Depth == 3 && m_InZone)
+        {
+            // Only the first Shape and the first Direction of a zone are used
+            m_Section = ESection::None;
+            if(Element == "Shape" && !m_ShapeSeen)
+            {
+                m_Section = ESection::Shape;
+                m_ShapeSeen = true;
+            }
+            else if(Element == "Direction" && !m_DirectionSeen)
+            {
+                m_Section = ESection::Direction;
+                m_DirectionSeen = true;
+            }
+        }
+        else if(m_Depth == 4 && m_InZone && m_Section != ESection::None)
+        {
+            m_InPoint = Element == "Point";
+            m_HasX = m_HasY = false;
+        }
+        return true;
+    }
+
+    bool Attribute(const char* Name, const char* Value) override
+    {
+        const std::string_view AttributeName{Name};
+        if(m_Depth == 2 && m_InZone)
+        {
+            if(AttributeName == "ZoneId")
+            {
+                m_HasZoneId = ReadInt(Value, m_Zone.s_ZoneId);
+            }
+            else if(AttributeName == "ZoneName")
+            {
+                m_Zone.s_ZoneName = Value;
+            }
+        }
+        else if(m_Depth == 4 && m_InPoint)
+        {
+            if(AttributeName == "X")
+            {
+                m_HasX = ReadInt(Value, m_Point.x);
+            }
+            else if(AttributeName == "Y")
+            {
+                m_HasY = ReadInt(Value, m_Point.y);
+            }
+        }
+        return true;
+    }
+
+    bool EndElement(const char* /*Name*/) override
+    {
+        if(m_Depth == 4 && m_InPoint)
+        {
+            m_InPoint = false;
+            if(m_Section == ESection::Shape && m_HasX && m_HasY)
+            {
+                m_Points.push_back(m_Point);
+            }
+            else if(m_Section == ESection::Direction)
+            {
+                // The direction is the first two points, both have to be valid
+                m_DirectionPoints.emplace_back(m_HasX && m_HasY, m_Point);
+            }
+        }
+        else if(m_Depth == 3)
+        {
+            m_Section = ESection::None;
+        }
+        else if(m_Depth == 2 && m_InZone)
+        {
+            m_InZone = false;
+            if(m_HasZoneId)
+            {
+                AddZone();
+            }
+        }
+        --m_Depth;
+        return true;
+    }
+
+private:
+    enum class ESection
+    {
+        None,
+        Shape,
+        Direction
+    };
+
+    void AddZone()
+    {
+        // Consecutive points form the lines of the polygon, the last point connects back to the first one
+        for(std::size_t i = 0; i < m_Points.size() && m_Points.size() > 1; ++i)
+        {
+            m_Zone.s_Lines.emplace_back(m_Points[i], m_Points[(i+1)%m_Points.size()]);
+        }
+
+        // The direction holds the center and the arrow head
+        if(m_DirectionPoints.size() > 1 && m_DirectionPoints[0].first && m_DirectionPoints[1].first)
+        {
+            m_Zone.s_Center = m_DirectionPoints[0].second;
+            m_Zone.s_ArrowHead = m_DirectionPoints[1].second;
+            m_Zone.s_Angle = GetAngle(m_DirectionPoints[0].second, m_DirectionPoints[1].second);
+        }
+
+        m_Zones[m_Zone.s_ZoneId] = m_Zone;
+    }
+
+    std::map<int, CMouseEvents::SZone>& m_Zones;
+    int m_Depth{0};
+    ESection m_Section{ESection::None};
+    bool m_InZone{false}, m_InPoint{false};
+    bool m_HasZoneId{false}, m_ShapeSeen{false}, m_DirectionSeen{false};
+    bool m_HasX{false}, m_HasY{false};
+    CMouseEvents::SZone m_Zone;
+    CMouseEvents::PointType m_Point;
+    std::vector<CMouseEvents::PointType> m_Points;
+    std::vector<std::pair<bool, CMouseEvents::PointType>> m_DirectionPoints;
+};
+
+}
+
+void WriteConfigXML(std::ostream& Ofs, const CMouseEvents::SZone& Zone)
+{
+    Ofs << "<Zone ZoneId=\"" << Zone.s_ZoneId << "\" ZoneName=\"" << EscapeAttribute(Zone.s_ZoneName) << "\">" << std::endl;
+    Ofs << "\t<Shape Type=\"POLYGON\">" << std::endl;
+    for(auto It = Zone.s_Lines.cbegin(); It != Zone.s_Lines.cend(); ++It)
+    {
+        auto Line = *It;
+
+        // Print the 1st point of line
+        Ofs << "\t\t<Point X=\"" << Line.first.x << "\" Y=\"" << Line.first.y << "\"/>" << std::endl;
+
+        // Print the 2nd point of line if it does not match with the first point of next line
+        auto NextLine = std::next(It) != Zone.s_Lines.cend() ? *std::next(It) : Zone.s_Lines.front();
+        if(Line.second != NextLine.first)
+        {
+            Ofs << "\t\t<Point X=\"" << Line.second.x << "\" Y=\"" << Line.second.y << "\"/>" << std::endl;
+        }
+    }
+    Ofs << "\t</Shape>" << std::endl;
+    Ofs << "\t<Characteristics/>" << std::endl;
+    Ofs << "\t\t<Direction>" << std::endl;
+    Ofs << "\t\t<Point X=\"" << Zone.GetCenter().x << "\" Y=\"" << Zone.GetCenter().y << "\"/>" << std::endl;
+    Ofs << "\t\t<Point X=\"" << Zone.GetArrowHead().x << "\" Y=\"" << Zone.GetArrowHead().y << "\"/>" << std::endl;
+    Ofs << "\t\t</Direction>" << std::endl;
+    Ofs << "</Zone>" << std::endl;
+}
+
+void WriteConfigXML(std::ostream& Ofs, const CMouseEvents::ZonesType& Zones)
+{
+    Ofs << PreConfigElement << std::endl;
+    Ofs << "<Zones>" << std::endl;
+    for(const auto& [ZoneId, Zone] : Zones)
+    {
+        WriteConfigXML(Ofs, Zone);
+    }
+    Ofs << "</Zones>" << std::endl;
+    Ofs << PostConfigElement << std::endl;
+    Ofs << std::flush;
+}
+
+bool ReadConfigXML(const std::string& FileName, std::map<int, CMouseEvents::SZone>& Zones)
+{
+    // Zones are only handed out if the whole document could be read
+    std::map<int, CMouseEvents::SZone> ReadZones;
+    CZoneHandler Handler(ReadZones);
+    TiXmlSaxReader Reader(&Handler);
+    // Independent of the global TinyXml settings, which other threads may change
+    Reader.SetParseOptions(TiXmlParseOptions{});
+    if(!Reader.LoadFile(FileName.c_str(), TiXmlEncoding::TIXML_ENCODING_UTF8))
+    {
+        return false;
+    }
+
+    for(auto& [ZoneId, Zone] : ReadZones)
+    {
+        Zones[ZoneId] = std::move(Zone);
+    }
+    return true;
+}
+
+bool ReadConfig(const std::string& FileName, std::map<int, CMouseEvents::SZone>& Zones)
+{
+    return IsBinaryConfigFile(FileName) ? ReadConfigBinary(FileName, Zones) : ReadConfigXML(FileName, Zones);
+}
+
+std::vector<std::optional<std::map<int, CMouseEvents::SZone>>> ReadConfigs(const std::vector<std::string>& FileNames, unsigned ThreadCount)
+{
+    std::vector<std::optional<std::map<int, CMouseEvents::SZone>>> Configs(FileNames.size());
+
+    // Every reader has its own parser state, the workers only share the index of the next file
+    std::atomic<std::size_t> Next{0};
+    auto Work = [&FileNames, &Configs, &Next]()
+    {
+        for(auto Index = Next++; Index < FileNames.size(); Index = Next++)
+        {
+            std::map<int, CMouseEvents::SZone> Zones;
+            if(ReadConfig(FileNames[Index], Zones))
+            {
+                Configs[Index] = std::move(Zones);
+            }
+        }
+    };
+
+    if(ThreadCount == 0)
+    {
+        ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    ThreadCount = static_cast<unsigned>(std::min<std::size_t>(ThreadCount, FileNames.size()));
+
+    // The calling thread is one of the workers
+    std::vector<std::thread> Workers;
+    for(unsigned i = 1; i < ThreadCount; ++i)
+    {
+        Workers.emplace_back(Work);
+    }
+    Work();
+    for(auto& Worker : Workers)
+    {
+        Worker.join();
+    }
+    return Configs;
+}
+
+}
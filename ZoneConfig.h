@@ -0,0 +1,30 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "MouseEvents.h"
+
+namespace mouseevents
+{
+
+// Write a single zone as a <Zone> element
+void WriteConfigXML(std::ostream& OS, const CMouseEvents::SZone& Zone);
+
+// Write all zones as a complete <Zones> document
+void WriteConfigXML(std::ostream& OS, const CMouseEvents::ZonesType& Zones);
+
+// Read all zones from a configuration file written by WriteConfigXML. Returns false if the file could not be read.
+bool ReadConfigXML(const std::string& FileName, std::map<int, CMouseEvents::SZone>& Zones);
+
+// Read all zones from a configuration file in either the binary or the XML format (detected from the file content)
+bool ReadConfig(const std::string& FileName, std::map<int, CMouseEvents::SZone>& Zones);
+
+// Read the configuration files of several cameras on a pool of threads (one per hardware thread if ThreadCount is 0).
+// The zones of each file are at the same index as its name, std::nullopt if the file could not be read.
+std::vector<std::optional<std::map<int, CMouseEvents::SZone>>> ReadConfigs(const std::vector<std::string>& FileNames, unsigned ThreadCount = 0);
+
+}
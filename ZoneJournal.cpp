@@ -0,0 +1,340 @@
+#include "ZoneJournal.h"
+
+#include <cstdio>
+#include <sstream>
+
+#include "EventLog.h"
+#include "ZoneBinary.h"
+#include "ZoneConfig.h"
+
+namespace mouseevents
+{
+
+namespace
+{
+
+// Record types, one record per line: <Type> <ZoneId> <Arguments...>
+constexpr char AddRecord{'A'};
+constexpr char RotateRecord{'R'};
+constexpr char DeleteRecord{'D'};
+constexpr char RenameRecord{'N'};
+
+// Names are stored at the end of a record, they must not break the line
+std::string SanitizeName(std::string Name)
+{
+    for(auto& C : Name)
+    {
+        C = (C == '\n' || C == '\r') ? ' ' : C;
+    }
+    return Name;
+}
+
+// An empty configuration file holds no zones which could be lost
+bool IsEmptyOrMissing(const std::string& FileName)
+{
+    std::ifstream Ifs(FileName, std::ifstream::binary);
+    return !Ifs.is_open() || Ifs.peek() == std::ifstream::traits_type::eof();
+}
+
+// Append the content of a file to another one
+bool AppendFile(const std::string& FromPath, const std::string& ToPath)
+{
+    std::ifstream Ifs(FromPath, std::ifstream::binary);
+    std::ofstream Ofs(ToPath, std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+    Ofs << Ifs.rdbuf();
+    Ofs.close();
+    return Ifs && Ofs;
+}
+
+// Read the rest of the record (after a single separator) as a name
+std::string ReadName(std::istream& Is)
+{
+    std::string Name;
+    Is.get();
+    std::getline(Is, Name);
+    return Name;
+}
+
+}
+
+CZoneJournal::CZoneJournal(const std::string& ConfigPath, std::size_t CompactThreshold)
+    : m_ConfigPath{ConfigPath}
+    , m_JournalPath{ConfigPath + ".journal"}
+    , m_CompactingPath{ConfigPath + ".journal.old"}
+    , m_CompactThreshold{CompactThreshold}
+{
+}
+
+CZoneJournal::~CZoneJournal()
+{
+    WaitForCompaction();
+}
+
+void CZoneJournal::Load(std::map<int, CMouseEvents::SZone>& Zones)
+{
+    WaitForCompaction();
+    m_Ofs.close();
+
+    // The journal is only folded into a configuration file which could be read, otherwise the zones of the
+    // file would be replaced by the journaled ones. Both files are kept until the zones are saved.
+    m_ConfigUnreadable = !ReadConfig(m_ConfigPath, Zones) && !IsEmptyOrMissing(m_ConfigPath);
+    if(m_ConfigUnreadable)
+    {
+        EventLog().Log(ELogLevel::Error, "Could not read %s, the journaled edits are not folded into it until the zones are saved", m_ConfigPath.c_str());
+    }
+
+    // A journal left over from an interrupted compaction is older than the current journal
+    auto Replayed = Replay(m_CompactingPath, Zones);
+    Replayed += Replay(m_JournalPath, Zones);
+
+    // Fold the replayed edits into the configuration right away so that we start with an empty journal
+    if(Replayed > 0 && !m_ConfigUnreadable && WriteConfig(m_ConfigPath, CMouseEvents::ZonesType(Zones.cbegin(), Zones.cend())))
+    {
+        std::remove(m_CompactingPath.c_str());
+        m_Ofs.open(m_JournalPath, std::ofstream::out | std::ofstream::trunc);
+    }
+    else
+    {
+        m_Ofs.open(m_JournalPath, std::ofstream::out | std::ofstream::app);
+    }
+    m_Records = 0;
+}
+
+void CZoneJournal::Add(const CMouseEvents::SZone& Zone)
+{
+    std::ostringstream Record;
+    Record << AddRecord << ' ' << Zone.s_ZoneId << ' ' << Zone.s_Angle << ' ' << Zone.s_Lines.size();
+    for(const auto& Line : Zone.s_Lines)
+    {
+        Record << ' ' << Line.first.x << ' ' << Line.first.y << ' ' << Line.second.x << ' ' << Line.second.y;
+    }
+    Record << ' ' << SanitizeName(Zone.s_ZoneName);
+    Append(Record.str());
+}
+
+void CZoneJournal::Rotate(int ZoneId, int Angle)
+{
+    std::ostringstream Record;
+    Record << RotateRecord << ' ' << ZoneId << ' ' << Angle;
+    Append(Record.str());
+}
+
+void CZoneJournal::Delete(int ZoneId)
+{
+    std::ostringstream Record;
+    Record << DeleteRecord << ' ' << ZoneId;
+    Append(Record.str());
+}
+
+void CZoneJournal::Rename(int ZoneId, const std::string& ZoneName)
+{
+    std::ostringstream Record;
+    Record << RenameRecord << ' ' << ZoneId << ' ' << SanitizeName(ZoneName);
+    Append(Record.str());
+}
+
+void CZoneJournal::CompactIfNeeded(const CMouseEvents::ZonesType& Zones)
+{
+    if(m_Records < m_CompactThreshold || m_Compacting || m_ConfigUnreadable)
+    {
+        return;
+    }
+    WaitForCompaction();
+
+    // Switch to a fresh journal, the old one is kept until its edits are safely in the configuration. The edits of
+    // a compaction which could not write the configuration are still in the old journal, the journal goes after them.
+    m_Ofs.close();
+    const bool Moved = IsEmptyOrMissing(m_CompactingPath) ? std::rename(m_JournalPath.c_str(), m_CompactingPath.c_str()) == 0
+                                                          : AppendFile(m_JournalPath, m_CompactingPath);
+    if(!Moved)
+    {
+        m_Ofs.open(m_JournalPath, std::ofstream::out | std::ofstream::app);
+        return;
+    }
+    m_Ofs.open(m_JournalPath, std::ofstream::out | std::ofstream::trunc);
+    m_Records = 0;
+
+    m_Compacting = true;
+    m_Compactor = std::thread([this, Zones]()
+    {
+        if(WriteConfig(m_ConfigPath, Zones))
+        {
+            std::remove(m_CompactingPath.c_str());
+        }
+        m_Compacting = false;
+    });
+}
+
+void CZoneJournal::WaitForCompaction()
+{
+    if(m_Compactor.joinable())
+    {
+        m_Compactor.join();
+    }
+}
+
+bool CZoneJournal::Save(const CMouseEvents::ZonesType& Zones, TiXmlDocument* Doc)
+{
+    // A background compaction must not write the configuration file at the same time
+    WaitForCompaction();
+
+    if(m_ConfigUnreadable)
+    {
+        const std::string UnreadablePath{m_ConfigPath + ".unreadable"};
+        std::remove(UnreadablePath.c_str());
+        if(std::rename(m_ConfigPath.c_str(), UnreadablePath.c_str()) != 0)
+        {
+            EventLog().Log(ELogLevel::Error, "Could not keep the unreadable %s as %s", m_ConfigPath.c_str(), UnreadablePath.c_str());
+            return false;
+        }
+        EventLog().Log(ELogLevel::Warning, "Kept the unreadable %s as %s", m_ConfigPath.c_str(), UnreadablePath.c_str());
+    }
+
+    if(!WriteConfig(m_ConfigPath, Zones, Doc))
+    {
+        EventLog().Log(ELogLevel::Error, "Could not write %s, the edits are kept in the journal", m_ConfigPath.c_str());
+        return false;
+    }
+    Reset();
+    return true;
+}
+
+void CZoneJournal::Reset()
+{
+    WaitForCompaction();
+    std::remove(m_CompactingPath.c_str());
+    m_Ofs.close();
+    m_Ofs.open(m_JournalPath, std::ofstream::out | std::ofstream::trunc);
+    m_Records = 0;
+    m_ConfigUnreadable = false;
+}
+
+void CZoneJournal::Append(const std::string& Record)
+{
+    m_Ofs << Record << '\n' << std::flush;
+    ++m_Records;
+}
+
+std::size_t CZoneJournal::Replay(const std::string& JournalPath, std::map<int, CMouseEvents::SZone>& Zones)
+{
+    std::ifstream Ifs(JournalPath);
+    std::size_t Replayed{0};
+    std::string Line;
+    while(std::getline(Ifs, Line))
+    {
+        // A record cut short by a crash is dropped, all records are idempotent
+        std::istringstream Record(Line);
+        char Type{};
+        int ZoneId{};
+        if(!(Record >> Type >> ZoneId))
+        {
+            continue;
+        }
+
+        if(Type == AddRecord)
+        {
+            CMouseEvents::SZone Zone;
+            Zone.s_ZoneId = ZoneId;
+            int Angle{};
+            std::size_t LineCount{};
+            Record >> Angle >> LineCount;
+            for(std::size_t i = 0; i < LineCount && Record; ++i)
+            {
+                CMouseEvents::LineType ZoneLine;
+                Record >> ZoneLine.first.x >> ZoneLine.first.y >> ZoneLine.second.x >> ZoneLine.second.y;
+                Zone.s_Lines.push_back(ZoneLine);
+            }
+            if(!Record)
+            {
+                continue;
+            }
+            Zone.s_ZoneName = ReadName(Record);
+            if(Angle != 0)
+            {
+                Zone.Rotate(Angle);
+            }
+            Zones[ZoneId] = Zone;
+        }
+        else if(Type == RotateRecord)
+        {
+            int Angle{};
+            auto It = Zones.find(ZoneId);
+            if(!(Record >> Angle) || It == Zones.end())
+            {
+                continue;
+            }
+            It->second.Rotate(Angle - It->second.s_Angle);
+        }
+        else if(Type == DeleteRecord)
+        {
+            Zones.erase(ZoneId);
+        }
+        else if(Type == RenameRecord)
+        {
+            auto It = Zones.find(ZoneId);
+            if(It == Zones.end())
+            {
+                continue;
+            }
+            It->second.s_ZoneName = ReadName(Record);
+        }
+        else
+        {
+            continue;
+        }
+        ++Replayed;
+    }
+    return Replayed;
+}
+
+bool CZoneJournal::WriteConfig(const std::string& ConfigPath, const CMouseEvents::ZonesType& Zones, TiXmlDocument* Doc)
+{
+    const std::string TmpPath{ConfigPath + ".tmp"};
+    if(IsBinaryConfigPath(ConfigPath))
+    {
+        if(!WriteConfigBinary(TmpPath, Zones))
+        {
+            return false;
+        }
+    }
+    else if(Doc)
+    {
+        // Same layout as Notepad++->Plugins->XML Tools->Pretty print
+        std::ostringstream Oss;
+        WriteConfigXML(Oss, Zones);
+        Doc->Clear();
+        Doc->Parse(Oss.str().c_str(), nullptr, TiXmlEncoding::TIXML_ENCODING_UTF8);
+        FILE* Fp = Doc->Error() ? nullptr : std::fopen(TmpPath.c_str(), "w");
+        if(!Fp)
+        {
+            return false;
+        }
+        Doc->Print(Fp);
+        const bool Written = std::ferror(Fp) == 0;
+        if(std::fclose(Fp) != 0 || !Written)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        std::ofstream Ofs(TmpPath, std::ofstream::out | std::ofstream::trunc);
+        WriteConfigXML(Ofs, Zones);
+        Ofs.close();
+        if(!Ofs)
+        {
+            return false;
+        }
+    }
+
+    if(std::rename(TmpPath.c_str(), ConfigPath.c_str()) == 0)
+    {
+        return true;
+    }
+
+    // rename does not replace an existing file on every platform
+    std::remove(ConfigPath.c_str());
+    return std::rename(TmpPath.c_str(), ConfigPath.c_str()) == 0;
+}
+
+}
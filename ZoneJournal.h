@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "MouseEvents.h"
+
+namespace mouseevents
+{
+
+// Append-only journal of zone edits stored next to the configuration file.
+// Every edit appends one small record (O(change)), the full <Zones> configuration is only
+// rewritten in the background once the journal has grown past the compaction threshold.
+class CZoneJournal
+{
+public:
+    CZoneJournal(const std::string& ConfigPath, std::size_t CompactThreshold = 256);
+
+    ~CZoneJournal();
+
+    // Read the configuration file and replay the journal on top of it. If the configuration file exists but
+    // cannot be read the journal is replayed onto no zones, and neither file is changed until the zones are saved.
+    void Load(std::map<int, CMouseEvents::SZone>& Zones);
+
+    // Record zone operations as they happen
+    void Add(const CMouseEvents::SZone& Zone);
+    void Rotate(int ZoneId, int Angle);
+    void Delete(int ZoneId);
+    void Rename(int ZoneId, const std::string& ZoneName);
+
+    // Rewrite the configuration in the background if the journal has grown past the threshold (and the
+    // configuration file could be read)
+    void CompactIfNeeded(const CMouseEvents::ZonesType& Zones);
+
+    // Block until a running compaction has finished writing the configuration file
+    void WaitForCompaction();
+
+    // Write all zones to the configuration file and start a new journal, the XML format is pretty printed through
+    // Doc if one is given. If the configuration could not be written it is left as it was and the journal is kept.
+    // An existing configuration file which could not be read is kept as <ConfigPath>.unreadable.
+    bool Save(const CMouseEvents::ZonesType& Zones, TiXmlDocument* Doc = nullptr);
+
+private:
+    // Write a record and flush it so that no edit is lost if the process dies
+    void Append(const std::string& Record);
+
+    // Apply all records of a journal file to the zones. Returns the number of applied records.
+    static std::size_t Replay(const std::string& JournalPath, std::map<int, CMouseEvents::SZone>& Zones);
+
+    // All journaled edits are part of the configuration file now
+    void Reset();
+
+    // Write the zones to the configuration file through a temporary file, pretty printed through Doc if given
+    static bool WriteConfig(const std::string& ConfigPath, const CMouseEvents::ZonesType& Zones, TiXmlDocument* Doc = nullptr);
+
+    const std::string m_ConfigPath{};
+    const std::string m_JournalPath{};
+    const std::string m_CompactingPath{}; // journal being compacted, replayed as well if compaction did not finish
+    const std::size_t m_CompactThreshold{256};
+    std::size_t m_Records{0};
+    bool m_ConfigUnreadable{false}; // the existing configuration file could not be read by Load
+    std::ofstream m_Ofs;
+    std::thread m_Compactor;
+    std::atomic<bool> m_Compacting{false};
+};
+
+}
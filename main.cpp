@@ -1,38 +1,64 @@
+#include "FrameGrabber.h"
+#include "FramePipeline.h"
+#include "Mosaic.h"
 #include "MouseEvents.h"
 
-#include <opencv2/core.hpp>
-#include <opencv2/videoio.hpp>
+#include <opencv2/imgcodecs.hpp>
 
 #include <iostream>
 #include <string>
 
-int main()
+int main(int argc, char* argv[])
 {
+    if (argc > 2)
+    {
+        // One window for several streams: <source> <config> <snapshot> for each (a source is a camera index or a video)
+        if ((argc - 1) % 3 != 0)
+        {
+            std::cout<<"Usage: "<<argv[0]<<" [<image> | <source> <config> <snapshot> [<source> <config> <snapshot>]...]"<<std::endl;
+            return -1;
+        }
+        mouseevents::CMosaic Mosaic("Mosaic");
+        for (int i = 1; i < argc; i += 3)
+        {
+            if (!Mosaic.Add(argv[i], argv[i + 1], argv[i + 2]))
+            {
+                std::cout<<"Video capture could not be initialized for file: "<<argv[i]<<std::endl;
+                return -1;
+            }
+        }
+        Mosaic.Run();
+        return 0;
+    }
+
     auto inFilename = 0;
 
     mouseevents::CMouseEvents MEvents("Draw", "C:/Users/ahkad/Desktop/Config.xml", "C:/Users/ahkad/Desktop/Config.jpg", false);
 
-    cv::VideoCapture inVid;
-    inVid.open(inFilename);
-    if (!inVid.isOpened())
+    if (argc == 2)
     {
-        std::cout<<"Video capture could not be initialized for file: "<<inFilename<<std::endl;
-        return -1;
+        // Zones of a snapshot, redrawn only on mouse input
+        cv::Mat Image = cv::imread(argv[1]);
+        if (Image.empty())
+        {
+            std::cout<<"Image could not be read: "<<argv[1]<<std::endl;
+            return -1;
+        }
+        MEvents.Annotate(Image);
+        return 0;
     }
 
-    cv::Mat_<cv::Vec3b> Frame;
-    inVid >> Frame;
-
-    while(1)
+    // Decode on a capture thread, the display always gets the latest frame
+    mouseevents::CFrameGrabber Grabber(2, mouseevents::EFramePolicy::DropOldest);
+    if (!Grabber.Open(inFilename))
     {
-        MEvents.Show(Frame);
-        inVid >> Frame;
-        if(Frame.empty())
-        {
-            inVid.set(cv::CAP_PROP_POS_MSEC, 1);
-            inVid >> Frame;
-        }
+        std::cout<<"Video capture could not be initialized for file: "<<inFilename<<std::endl;
+        return -1;
     }
 
+    // Compose the next frame while the current one is shown
+    mouseevents::CFramePipeline Pipeline(MEvents, Grabber);
+    Pipeline.Run();
+
     return 0;
 }